@@ -0,0 +1,664 @@
+// Truth or Dare 게임 엔진 벤치마크 (화면 입출력 없이 실행)
+//
+// 합성 데이터(사용자 N명, 기록 M개, Truth 질문 / Dare 도전 K개)를 만든 뒤
+// 로드/스냅샷/압축 경로와 스크립트 세션(로그인 → Truth → Dare → 기록 보기 → 랭킹)을
+// 여러 스레드로 재생하고, 동작별 처리량과 p50/p99/p999 지연을 보고한다.
+// 결과를 JSON으로 저장해 두고 다음 실행에서 --compare로 비교할 수 있다.
+//
+// 빌드: gcc -O2 -pthread benchmark.c game_core.c -o benchmark
+// 예:   ./benchmark --users 10000 --records 1000000 --threads 4 --json baseline.json
+//       ./benchmark --users 10000 --records 1000000 --threads 4 --compare baseline.json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h> // mkdir
+
+#include "game_core.h"
+
+#define BENCH_MAX_STEPS 64        // 세션 스크립트 최대 단계 수
+#define BENCH_MAX_THREADS 256
+#define BENCH_MARKER ".benchmark" // 벤치마크가 만든 데이터 디렉터리 표시 (다른 데이터를 덮어쓰지 않도록)
+#define BENCH_RECORD_DAYS 365     // 합성 기록 날짜 범위 (오늘 이전 일수)
+#define BENCH_CATEGORY_COUNT 3
+
+// 합성 Dare 도전의 카테고리
+static const char* const benchCategories[BENCH_CATEGORY_COUNT] = { "신체", "학습", "정서" };
+
+// --- 측정 항목 ---
+
+enum {
+    OP_BUILD_CATALOG, // 콘텐츠 카탈로그 생성 (--content catalog일 때만)
+    OP_LOAD_TEXT,     // 텍스트 파일에서 전체 로드 (카탈로그가 있으면 콘텐츠는 카탈로그 매핑)
+    OP_SAVE_SNAPSHOT, // 스냅샷 저장
+    OP_LOAD_SNAPSHOT, // 스냅샷에서 전체 로드
+    OP_LOGIN,
+    OP_TRUTH,         // 질문 선택 + 답변 저장
+    OP_DARE,          // 남은 횟수 확인 + 도전 선택 + 결과 저장
+    OP_RECORDS,       // 자기 기록 전체 조회
+    OP_RANKING,       // 상위 10명 + 자기 순위 (누적 코인과 기간별 코인)
+    OP_SEARCH,        // 자기 Truth 답변 검색 (합성 답변 낱말 하나)
+    OP_FLUSH,         // 세션 후 남은 변경 저장
+    OP_LOAD_JOURNAL,  // 세션 후 재시작 (스냅샷 + 저널 재생)
+    OP_COMPACT,       // 기록 저널 압축
+    OP_REPORT,        // 전체 기간 기록 분석 (CPU 수만큼 스캔 스레드)
+    OP_COUNT
+};
+
+static const char* const opNames[OP_COUNT] = {
+    "build_catalog", "load_text", "save_snapshot", "load_snapshot",
+    "login", "truth", "dare", "records", "ranking", "search",
+    "flush", "load_journal", "compact", "report"
+};
+
+// 동작 하나의 지연 표본 (나노초)
+typedef struct {
+    uint64_t* samples;
+    int count;
+    int capacity;
+} LatencyLog;
+
+// 집계 결과 (마이크로초)
+typedef struct {
+    int count;
+    double throughput; // 초당 횟수 (세션 구간 기준, 한 번만 하는 동작은 1 / 소요 시간)
+    double mean, p50, p99, p999, max;
+} OpStats;
+
+// 세션 스크립트 단계 (OP_LOGIN ~ OP_SEARCH)
+typedef struct {
+    int steps[BENCH_MAX_STEPS];
+    int numSteps;
+} SessionScript;
+
+typedef struct {
+    const char* dataDir;
+    int users;
+    int records;
+    int questions;
+    int dares;
+    int threads;
+    int sessions;
+    int durability;
+    unsigned int seed;
+    const char* scriptText;
+    SessionScript script;
+    const char* jsonPath;
+    const char* comparePath;
+    double threshold; // 회귀로 볼 변화율 (%)
+    const char* statsPath; // 엔진 계측 결과 파일 (NULL: 계측하지 않음, "-": 표준 출력)
+    int catalog;           // 1: 질문/도전을 카탈로그로 변환해 사용
+} BenchConfig;
+
+// 세션 스레드 하나의 상태
+typedef struct {
+    GameContext* ctx;
+    const BenchConfig* config;
+    int sessions;       // 이 스레드가 재생할 세션 수
+    unsigned int rng;
+    const int* categoryIds; // 콘텐츠의 Dare 카테고리 ID
+    int categoryCount;
+    LatencyLog logs[OP_COUNT];
+    pthread_t thread;
+} BenchWorker;
+
+
+// --- 도우미 ---
+
+static uint64_t nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 스레드 전용 난수 (xorshift32)
+static unsigned int benchRandom(unsigned int* state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void logSample(LatencyLog* log, uint64_t nanos) {
+    if (log->count == log->capacity) {
+        int newCapacity = log->capacity ? log->capacity * 2 : 1024;
+        uint64_t* grown = realloc(log->samples, sizeof(uint64_t) * newCapacity);
+        if (grown == NULL) {
+            fprintf(stderr, "메모리가 부족합니다.\n");
+            exit(1);
+        }
+        log->samples = grown;
+        log->capacity = newCapacity;
+    }
+    log->samples[log->count++] = nanos;
+}
+
+static int compareSamples(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// 정렬된 표본의 백분위수 (p: 0~1)
+static uint64_t percentile(const uint64_t* sorted, int count, double p) {
+    int idx = (int)(p * count + 0.999999) - 1;
+    if (idx < 0) idx = 0;
+    if (idx >= count) idx = count - 1;
+    return sorted[idx];
+}
+
+static void computeStats(LatencyLog* log, double seconds, OpStats* out) {
+    memset(out, 0, sizeof(*out));
+    out->count = log->count;
+    if (log->count == 0) return;
+    qsort(log->samples, log->count, sizeof(uint64_t), compareSamples);
+    double total = 0;
+    for (int i = 0; i < log->count; i++) total += (double)log->samples[i];
+    out->mean = total / log->count / 1000.0;
+    out->p50 = percentile(log->samples, log->count, 0.50) / 1000.0;
+    out->p99 = percentile(log->samples, log->count, 0.99) / 1000.0;
+    out->p999 = percentile(log->samples, log->count, 0.999) / 1000.0;
+    out->max = log->samples[log->count - 1] / 1000.0;
+    out->throughput = seconds > 0 ? log->count / seconds : 0;
+}
+
+// 날짜 문자열 (오늘에서 daysAgo일 전)
+static void formatPastDate(char* buf, size_t size, int daysAgo) {
+    time_t t = time(NULL) - (time_t)daysAgo * 24 * 60 * 60;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    strftime(buf, size, "%Y-%m-%d", &tm);
+}
+
+static void dataPath(char* buf, size_t size, const char* dir, const char* name) {
+    snprintf(buf, size, "%s/%s", dir, name);
+}
+
+
+// --- 합성 데이터 ---
+
+// 합성 Truth 답변에 섞는 낱말 (답변 검색 단계의 검색어로도 사용)
+static const char* const answerWords[] = {
+    "학교", "친구", "가족", "여행", "운동", "음악", "영화", "공부", "coffee", "weekend", "game", "book"
+};
+#define ANSWER_WORD_COUNT ((int)(sizeof(answerWords) / sizeof(answerWords[0])))
+
+// 데이터 디렉터리 준비 (벤치마크가 만든 디렉터리가 아니면서 게임 데이터가 있으면 거부)
+static int prepareDataDir(const char* dir) {
+    char path[1024];
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        printf("데이터 디렉터리를 만들 수 없습니다: %s\n", dir);
+        return 0;
+    }
+    struct stat st;
+    dataPath(path, sizeof(path), dir, "users.txt");
+    int hasUsers = stat(path, &st) == 0;
+    dataPath(path, sizeof(path), dir, BENCH_MARKER);
+    if (hasUsers && stat(path, &st) != 0) {
+        printf("%s 에 게임 데이터가 있습니다. 벤치마크용 빈 디렉터리를 지정하세요.\n", dir);
+        return 0;
+    }
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) return 0;
+    fclose(fp);
+
+    // 이전 실행이 남긴 파생 파일 삭제
+    static const char* const stale[] = { "snapshot.bin", "records.journal", "users.wal", "users.txt.tmp", "records.txt.tmp", "snapshot.bin.tmp",
+                                          "answers.idx", "answers.idx.tmp", "content.cat", "content.cat.tmp" };
+    for (size_t i = 0; i < sizeof(stale) / sizeof(stale[0]); i++) {
+        dataPath(path, sizeof(path), dir, stale[i]);
+        remove(path);
+    }
+    return 1;
+}
+
+// 사용자, 기록, 질문, 도전 텍스트 파일 생성 (게임 저장 형식과 같음)
+static int generateDataset(const BenchConfig* config) {
+    char path[1024];
+    unsigned int rng = config->seed ? config->seed : 1;
+
+    dataPath(path, sizeof(path), config->dataDir, "truth_questions.txt");
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) return 0;
+    for (int i = 0; i < config->questions; i++) {
+        fprintf(fp, "%d 합성 질문 %d번: 최근에 가장 기억에 남는 일은 무엇인가요?\n", i + 1, i + 1);
+    }
+    fclose(fp);
+
+    dataPath(path, sizeof(path), config->dataDir, "dare_challenges.txt");
+    fp = fopen(path, "w");
+    if (fp == NULL) return 0;
+    for (int i = 0; i < config->dares; i++) {
+        // 가중치를 섞어 두어 별칭 표 뽑기도 함께 잼
+        fprintf(fp, "%d %s *%d 합성 도전 %d번 해 보기\n", 1001 + i, benchCategories[i % BENCH_CATEGORY_COUNT], 1 + i % 7, i + 1);
+    }
+    fclose(fp);
+
+    // 사용자 코인은 기록의 Dare 완료 합계와 맞춤
+    int* coins = calloc(config->users > 0 ? config->users : 1, sizeof(int));
+    if (coins == NULL) return 0;
+
+    dataPath(path, sizeof(path), config->dataDir, "records.txt");
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        free(coins);
+        return 0;
+    }
+    char dates[BENCH_RECORD_DAYS][MAX_DATE_LEN];
+    for (int d = 0; d < BENCH_RECORD_DAYS; d++) formatPastDate(dates[d], sizeof(dates[d]), d + 1);
+    for (int i = 0; i < config->records && config->users > 0; i++) {
+        int user = benchRandom(&rng) % config->users;
+        const char* date = dates[benchRandom(&rng) % BENCH_RECORD_DAYS];
+        if (benchRandom(&rng) % 6 == 0 && config->questions > 0) { // Truth 1 : Dare 5 (하루 한도 비율)
+            int question = 1 + (int)(benchRandom(&rng) % config->questions);
+            fprintf(fp, "user%d %s 0 %d 0 %s에 대한 합성 답변입니다 %s\n", user, date, question,
+                    answerWords[benchRandom(&rng) % ANSWER_WORD_COUNT], answerWords[benchRandom(&rng) % ANSWER_WORD_COUNT]);
+        } else {
+            int complete = benchRandom(&rng) % 2;
+            int dareId = config->dares > 0 ? 1001 + (int)(benchRandom(&rng) % config->dares) : 0;
+            fprintf(fp, "user%d %s 1 %d %d %s\n", user, date, dareId, complete ? 10 : 0, complete ? "Complete" : "Fail");
+            if (complete) coins[user] += 10;
+        }
+    }
+    fclose(fp);
+
+    dataPath(path, sizeof(path), config->dataDir, "users.txt");
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        free(coins);
+        return 0;
+    }
+    for (int i = 0; i < config->users; i++) {
+        fprintf(fp, "user%d pw%d %d none none 0\n", i, i, coins[i]);
+    }
+    fclose(fp);
+    free(coins);
+    return 1;
+}
+
+
+// --- 세션 재생 ---
+
+// "login,truth,dare*5,records,ranking" 형식의 스크립트 해석
+static int parseScript(const char* text, SessionScript* script) {
+    script->numSteps = 0;
+    const char* p = text;
+    while (*p) {
+        char name[32];
+        int repeat = 1;
+        size_t len = strcspn(p, ",*");
+        if (len == 0 || len >= sizeof(name)) return 0;
+        memcpy(name, p, len);
+        name[len] = '\0';
+        p += len;
+        if (*p == '*') {
+            char* end;
+            repeat = (int)strtol(p + 1, &end, 10);
+            if (end == p + 1 || repeat < 1) return 0;
+            p = end;
+        }
+        if (*p == ',') p++;
+
+        int op = -1;
+        for (int i = OP_LOGIN; i <= OP_SEARCH; i++) {
+            if (strcmp(name, opNames[i]) == 0) op = i;
+        }
+        if (op < 0) return 0;
+        while (repeat-- > 0) {
+            if (script->numSteps == BENCH_MAX_STEPS) return 0;
+            script->steps[script->numSteps++] = op;
+        }
+    }
+    return script->numSteps > 0;
+}
+
+// 세션 한 번 재생 (로그인이 스크립트에 없으면 측정하지 않고 먼저 로그인)
+static void runSession(BenchWorker* w) {
+    const BenchConfig* config = w->config;
+    int user = benchRandom(&w->rng) % config->users;
+    char id[MAX_ID_LEN], password[MAX_PW_LEN];
+    snprintf(id, sizeof(id), "user%d", user);
+    snprintf(password, sizeof(password), "pw%d", user);
+
+    GameSession session;
+    if (config->script.steps[0] != OP_LOGIN) loginSession(w->ctx, &session, id, password);
+
+    for (int i = 0; i < config->script.numSteps; i++) {
+        int op = config->script.steps[i];
+        uint64_t start = nowNanos();
+        switch (op) {
+            case OP_LOGIN:
+                loginSession(w->ctx, &session, id, password);
+                break;
+            case OP_TRUTH: {
+                const TruthQuestion* q = getTruthQuestion(&session);
+                if (q != NULL) answerTruth(&session, q->id, "벤치마크 답변입니다");
+                break;
+            }
+            case OP_DARE: {
+                if (dareAttemptsLeft(&session) == 0 || w->categoryCount == 0) break; // 오늘 한도를 다 쓴 사용자
+                const DareChallenge* d = getRandomDareChallenge(w->ctx, w->categoryIds[benchRandom(&w->rng) % w->categoryCount]);
+                if (d != NULL) attemptDare(&session, d->id, 1 + benchRandom(&w->rng) % 2, NULL);
+                break;
+            }
+            case OP_RECORDS: {
+                UserRecord batch[64];
+                int start = 0, n;
+                while ((n = listRecords(&session, start, batch, 64)) > 0) start += n;
+                break;
+            }
+            case OP_RANKING: {
+                int top[10];
+                topRanks(w->ctx, top, 10);
+                sessionRank(&session);
+                for (int k = 0; k < RANK_WINDOW_COUNT; k++) {
+                    topWindowRanks(w->ctx, k, top, NULL, 10);
+                    sessionWindowRank(&session, k, NULL);
+                }
+                break;
+            }
+            case OP_SEARCH: {
+                UserRecord batch[64];
+                const char* query = answerWords[benchRandom(&w->rng) % ANSWER_WORD_COUNT];
+                int start = 0, n;
+                while ((n = searchRecords(&session, query, start, batch, 64)) > 0) start += n;
+                break;
+            }
+        }
+        logSample(&w->logs[op], nowNanos() - start);
+    }
+}
+
+static void* benchWorkerMain(void* arg) {
+    BenchWorker* w = arg;
+    for (int i = 0; i < w->sessions; i++) runSession(w);
+    return NULL;
+}
+
+
+// --- 보고 ---
+
+static void printStats(const OpStats* stats) {
+    printf("%-14s %9s %12s %10s %10s %10s %10s %10s\n",
+           "동작", "횟수", "처리량/s", "평균us", "p50us", "p99us", "p999us", "최대us");
+    for (int op = 0; op < OP_COUNT; op++) {
+        const OpStats* s = &stats[op];
+        if (s->count == 0) continue;
+        printf("%-14s %9d %12.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+               opNames[op], s->count, s->throughput, s->mean, s->p50, s->p99, s->p999, s->max);
+    }
+}
+
+// 결과 JSON 저장 (동작 하나가 한 줄이므로 --compare가 줄 단위로 읽음)
+static int writeJson(const char* path, const BenchConfig* config, const OpStats* stats) {
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL) return 0;
+    static const char* const durabilityNames[] = { "none", "batch", "sync" };
+    fprintf(fp, "{\n  \"config\": {\"users\": %d, \"records\": %d, \"questions\": %d, \"dares\": %d, "
+                "\"threads\": %d, \"sessions\": %d, \"script\": \"%s\", \"durability\": \"%s\", \"seed\": %u},\n",
+            config->users, config->records, config->questions, config->dares,
+            config->threads, config->sessions, config->scriptText, durabilityNames[config->durability], config->seed);
+    fprintf(fp, "  \"ops\": {\n");
+    int first = 1;
+    for (int op = 0; op < OP_COUNT; op++) {
+        const OpStats* s = &stats[op];
+        if (s->count == 0) continue;
+        fprintf(fp, "%s    \"%s\": {\"count\": %d, \"throughput\": %.3f, \"mean_us\": %.3f, \"p50_us\": %.3f, "
+                    "\"p99_us\": %.3f, \"p999_us\": %.3f, \"max_us\": %.3f}",
+                first ? "" : ",\n", opNames[op], s->count, s->throughput, s->mean, s->p50, s->p99, s->p999, s->max);
+        first = 0;
+    }
+    fprintf(fp, "\n  }\n}\n");
+    fclose(fp);
+    return 1;
+}
+
+// 기준 JSON과 비교 (p99가 늘었거나 처리량이 threshold% 넘게 줄면 회귀, 회귀 수 반환, 파일 오류는 -1)
+static int compareWithBaseline(const char* path, const OpStats* stats, double threshold) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        printf("기준 결과 파일을 열 수 없습니다: %s\n", path);
+        return -1;
+    }
+    printf("\n기준 결과와 비교 (%s, 기준 %.0f%%)\n", path, threshold);
+    printf("%-14s %12s %12s %12s\n", "동작", "p50 변화", "p99 변화", "처리량 변화");
+    int regressions = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char name[32];
+        OpStats base;
+        if (sscanf(line, " \"%31[^\"]\": {\"count\": %d, \"throughput\": %lf, \"mean_us\": %lf, \"p50_us\": %lf, "
+                         "\"p99_us\": %lf, \"p999_us\": %lf, \"max_us\": %lf",
+                   name, &base.count, &base.throughput, &base.mean, &base.p50, &base.p99, &base.p999, &base.max) != 8) {
+            continue;
+        }
+        for (int op = 0; op < OP_COUNT; op++) {
+            const OpStats* s = &stats[op];
+            if (strcmp(name, opNames[op]) != 0 || s->count == 0) continue;
+            double p50Change = base.p50 > 0 ? (s->p50 - base.p50) / base.p50 * 100 : 0;
+            double p99Change = base.p99 > 0 ? (s->p99 - base.p99) / base.p99 * 100 : 0;
+            double tputChange = base.throughput > 0 ? (s->throughput - base.throughput) / base.throughput * 100 : 0;
+            int regressed = p99Change > threshold || tputChange < -threshold;
+            printf("%-14s %+11.1f%% %+11.1f%% %+11.1f%%%s\n",
+                   name, p50Change, p99Change, tputChange, regressed ? "  <- 느려짐" : "");
+            regressions += regressed;
+        }
+    }
+    fclose(fp);
+    return regressions;
+}
+
+
+// --- Main 함수 ---
+
+// 한 번만 실행하는 동작의 소요 시간 기록
+static void timeOnce(LatencyLog* log, uint64_t start) {
+    logSample(log, nowNanos() - start);
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config = { "bench_data", 10000, 200000, 200, 300, 1, 20000, DURABILITY_BATCH, 1,
+                           "login,truth,dare*5,records,ranking,search", { {0}, 0 }, NULL, NULL, 10.0, NULL, 0 };
+
+    // 실행 옵션
+    //   --dir DIR         : 합성 데이터 디렉터리 (기본 bench_data, 실행마다 다시 만듦)
+    //   --users N         : 사용자 수
+    //   --records M       : 기록 수
+    //   --questions K     : Truth 질문 수
+    //   --dares K         : Dare 도전 수
+    //   --threads T       : 세션을 재생하는 스레드 수
+    //   --sessions S      : 전체 세션 수 (스레드에 나눠 배정)
+    //   --script LIST     : 세션 단계 (login, truth, dare, records, ranking, search; name*N 반복)
+    //   --durability L    : none | batch | sync
+    //   --seed S          : 합성 데이터/세션 난수 시드
+    //   --json FILE       : 결과를 기준 JSON으로 저장
+    //   --compare FILE    : 기준 JSON과 비교 (회귀가 있으면 종료 코드 2)
+    //   --threshold PCT   : 회귀로 볼 변화율 (기본 10)
+    //   --content C       : text (기본) | catalog (질문/도전을 콘텐츠 카탈로그로 변환해 매핑)
+    //   --stats FILE      : 엔진 계측을 켜고 세션 재생 구간의 동작별 통계를 FILE에 씀 ("-": 표준 출력)
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            printf("알 수 없는 옵션: %s\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--dir") == 0) config.dataDir = value;
+        else if (strcmp(argv[i], "--users") == 0) config.users = atoi(value);
+        else if (strcmp(argv[i], "--records") == 0) config.records = atoi(value);
+        else if (strcmp(argv[i], "--questions") == 0) config.questions = atoi(value);
+        else if (strcmp(argv[i], "--dares") == 0) config.dares = atoi(value);
+        else if (strcmp(argv[i], "--threads") == 0) config.threads = atoi(value);
+        else if (strcmp(argv[i], "--sessions") == 0) config.sessions = atoi(value);
+        else if (strcmp(argv[i], "--script") == 0) config.scriptText = value;
+        else if (strcmp(argv[i], "--seed") == 0) config.seed = (unsigned int)strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "--json") == 0) config.jsonPath = value;
+        else if (strcmp(argv[i], "--compare") == 0) config.comparePath = value;
+        else if (strcmp(argv[i], "--threshold") == 0) config.threshold = atof(value);
+        else if (strcmp(argv[i], "--stats") == 0) config.statsPath = value;
+        else if (strcmp(argv[i], "--content") == 0) {
+            if (strcmp(value, "text") == 0) config.catalog = 0;
+            else if (strcmp(value, "catalog") == 0) config.catalog = 1;
+            else {
+                printf("알 수 없는 콘텐츠 형식: %s\n", value);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--durability") == 0) {
+            if (strcmp(value, "none") == 0) config.durability = DURABILITY_NONE;
+            else if (strcmp(value, "batch") == 0) config.durability = DURABILITY_BATCH;
+            else if (strcmp(value, "sync") == 0) config.durability = DURABILITY_SYNC;
+            else {
+                printf("알 수 없는 내구성 수준: %s\n", value);
+                return 1;
+            }
+        } else {
+            printf("알 수 없는 옵션: %s\n", argv[i]);
+            return 1;
+        }
+        i++;
+    }
+    if (config.users < 1 || config.records < 0 || config.questions < 0 || config.dares < 0 ||
+        config.threads < 1 || config.threads > BENCH_MAX_THREADS || config.sessions < 0) {
+        printf("잘못된 벤치마크 설정입니다.\n");
+        return 1;
+    }
+    if (!parseScript(config.scriptText, &config.script)) {
+        printf("잘못된 세션 스크립트입니다: %s\n", config.scriptText);
+        return 1;
+    }
+
+    // 1. 합성 데이터 생성
+    printf("합성 데이터 생성: 사용자 %d명, 기록 %d개, 질문 %d개, 도전 %d개 (%s)\n",
+           config.users, config.records, config.questions, config.dares, config.dataDir);
+    if (!prepareDataDir(config.dataDir) || !generateDataset(&config)) {
+        printf("합성 데이터를 만들 수 없습니다.\n");
+        return 1;
+    }
+
+    LatencyLog once[OP_COUNT];
+    memset(once, 0, sizeof(once));
+    GameConfig gameConfig = { config.dataDir, NULL, config.durability, config.seed, config.statsPath != NULL, NULL, 0, 0, 0 };
+
+    // 2. 로드/저장 경로
+    GameContext* ctx = createGameContext(&gameConfig);
+    if (ctx == NULL) {
+        printf("게임 데이터를 준비할 수 없습니다.\n");
+        return 1;
+    }
+    uint64_t start;
+    if (config.catalog) {
+        start = nowNanos();
+        int built = buildContentCatalog(ctx);
+        timeOnce(&once[OP_BUILD_CATALOG], start);
+        destroyGameContext(ctx);
+        if (!built) {
+            printf("콘텐츠 카탈로그를 만들 수 없습니다.\n");
+            return 1;
+        }
+        ctx = createGameContext(&gameConfig);
+    }
+    start = nowNanos();
+    loadGame(ctx);
+    timeOnce(&once[OP_LOAD_TEXT], start);
+    start = nowNanos();
+    saveSnapshot(ctx);
+    timeOnce(&once[OP_SAVE_SNAPSHOT], start);
+    destroyGameContext(ctx);
+
+    ctx = createGameContext(&gameConfig);
+    start = nowNanos();
+    loadGame(ctx);
+    timeOnce(&once[OP_LOAD_SNAPSHOT], start);
+    startGame(ctx);
+
+    // 3. 세션 재생
+    printf("세션 재생: %d개, 스레드 %d개, 스크립트 %s\n", config.sessions, config.threads, config.scriptText);
+    BenchWorker* workers = calloc(config.threads, sizeof(BenchWorker));
+    if (workers == NULL) return 1;
+    int categoryIds[BENCH_CATEGORY_COUNT];
+    int categoryCount = listDareCategories(ctx, categoryIds, NULL, BENCH_CATEGORY_COUNT);
+    if (categoryCount > BENCH_CATEGORY_COUNT) categoryCount = BENCH_CATEGORY_COUNT;
+    uint64_t sessionStart = nowNanos();
+    for (int t = 0; t < config.threads; t++) {
+        BenchWorker* w = &workers[t];
+        w->ctx = ctx;
+        w->config = &config;
+        w->categoryIds = categoryIds;
+        w->categoryCount = categoryCount;
+        w->sessions = config.sessions / config.threads + (t < config.sessions % config.threads);
+        w->rng = (config.seed ? config.seed : 1) ^ (0x9e3779b9u * (unsigned int)(t + 1));
+        if (w->rng == 0) w->rng = 1;
+        if (pthread_create(&w->thread, NULL, benchWorkerMain, w) != 0) {
+            printf("세션 스레드를 시작할 수 없습니다.\n");
+            return 1;
+        }
+    }
+    for (int t = 0; t < config.threads; t++) pthread_join(workers[t].thread, NULL);
+    double sessionSeconds = (nowNanos() - sessionStart) / 1e9;
+
+    start = nowNanos();
+    flushGame(ctx);
+    timeOnce(&once[OP_FLUSH], start);
+    if (config.statsPath != NULL) {
+        FILE* statsOut = strcmp(config.statsPath, "-") == 0 ? stdout : fopen(config.statsPath, "w");
+        if (statsOut == NULL) {
+            printf("통계 파일을 만들 수 없습니다: %s\n", config.statsPath);
+        } else {
+            dumpGameStats(ctx, statsOut);
+            if (statsOut != stdout) fclose(statsOut);
+        }
+    }
+    destroyGameContext(ctx);
+
+    // 4. 재시작 (스냅샷 + 세션 중 쌓인 저널), 압축, 기록 분석
+    ctx = createGameContext(&gameConfig);
+    start = nowNanos();
+    loadGame(ctx);
+    timeOnce(&once[OP_LOAD_JOURNAL], start);
+    start = nowNanos();
+    compactUserRecords(ctx);
+    timeOnce(&once[OP_COMPACT], start);
+    start = nowNanos();
+    freeGameReport(buildGameReport(ctx, DAY_NONE, DAY_NONE, 0));
+    timeOnce(&once[OP_REPORT], start);
+    destroyGameContext(ctx);
+
+    // 5. 집계 및 보고
+    OpStats stats[OP_COUNT];
+    for (int op = 0; op < OP_COUNT; op++) {
+        LatencyLog merged = once[op];
+        double seconds = merged.count > 0 ? merged.samples[0] / 1e9 : 0;
+        if (op >= OP_LOGIN && op <= OP_SEARCH) {
+            seconds = sessionSeconds;
+            for (int t = 0; t < config.threads; t++) {
+                LatencyLog* log = &workers[t].logs[op];
+                for (int i = 0; i < log->count; i++) logSample(&merged, log->samples[i]);
+                free(log->samples);
+            }
+        }
+        computeStats(&merged, seconds, &stats[op]);
+        free(merged.samples);
+    }
+    free(workers);
+
+    printf("\n세션 구간: %.3f초, 초당 세션 %.1f개\n", sessionSeconds,
+           sessionSeconds > 0 ? config.sessions / sessionSeconds : 0);
+    printStats(stats);
+
+    if (config.jsonPath != NULL) {
+        if (writeJson(config.jsonPath, &config, stats)) printf("\n결과 저장: %s\n", config.jsonPath);
+        else printf("\n결과 파일을 저장할 수 없습니다: %s\n", config.jsonPath);
+    }
+    if (config.comparePath != NULL) {
+        int regressions = compareWithBaseline(config.comparePath, stats, config.threshold);
+        if (regressions < 0) return 1;
+        if (regressions > 0) {
+            printf("회귀 %d건\n", regressions);
+            return 2;
+        }
+    }
+    return 0;
+}
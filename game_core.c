@@ -0,0 +1,5650 @@
+// Truth or Dare 게임 엔진 구현 (game_core.h 참고)
+
+#include "game_core.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h> // gameLog
+#include <time.h> // 시간 및 날짜 관련 함수
+#include <ctype.h> // 문자열 처리 (예: tolower)
+#include <stddef.h> // size_t, max_align_t
+#include <limits.h> // INT_MAX (기록 분석의 날짜 범위)
+#include <stdint.h> // 스냅샷 파일의 고정 폭 정수
+#include <sys/stat.h> // stat (파일 크기/수정 시각)
+#include <stdatomic.h> // 원자적 카운터, 무잠금 큐
+#ifdef _WIN32
+#include <io.h> // _commit, _fileno
+#else
+#include <unistd.h> // fsync, fileno
+#include <fcntl.h> // open
+#include <sys/mman.h> // mmap
+#include <pthread.h> // 비동기 저장 스레드
+#include <sched.h> // sched_yield
+#endif
+#ifdef __linux__
+#include <sys/inotify.h> // 콘텐츠 파일 감시
+#include <poll.h> // 감시 스레드가 멈출 때를 확인하려고 제한 시간을 두고 기다림
+#include <errno.h>
+#include <signal.h> // kill (공유 사용자 표의 체크포인트 프로세스가 살아 있는지)
+#endif
+
+#define USER_ROW_WIDTH 512 // users.txt 한 줄의 고정 폭 (개행 포함, 공백으로 채움, 160: 통계 칸이 없던 형식, 256: 주머니 칸까지 넣던 형식)
+#define INT_TEXT_MAX 11    // 10진 int 한 칸의 최대 글자 수 ("-2147483648")
+#define RECORD_LINE_MAX (MAX_ID_LEN + MAX_DATE_LEN + MAX_ANSWER_LEN + 64) // 기록 한 줄 최대 길이
+#define PERSIST_QUEUE_SIZE 1024 // 비동기 저장 큐 크기 (2의 거듭제곱)
+#define PERSIST_BATCH_MAX 256   // 한 번의 그룹 커밋에서 처리하는 최대 항목 수
+#define ARENA_MIN_BLOCK (64 * 1024)        // 아레나 첫 블록 크기
+#define ARENA_MAX_BLOCK (4 * 1024 * 1024)  // 아레나 블록 크기 상한
+#define SEG_CHUNK_BYTES (32 * 1024)        // 세그먼트 배열 청크 하나의 목표 크기
+#define RECORD_BLOCK_SHIFT 10               // 기록 블록 하나의 행 수 = 1 << RECORD_BLOCK_SHIFT
+#define RECORD_BLOCK_ROWS (1 << RECORD_BLOCK_SHIFT)
+#define RECORD_INTERN_MIN_CAPACITY 64       // 기록 공유 문자열 해시 초기 슬롯 수 (2의 거듭제곱)
+#define TODAY_MAX_DAY_SECONDS (25 * 3600)   // 하루의 최대 길이 (일광 절약 시간 전환 포함)
+#define USER_INDEX_MIN_CAPACITY 64          // 사용자 ID 해시 인덱스 초기 슬롯 수 (2의 거듭제곱)
+#define GAME_PATH_MAX 512                   // 데이터 파일 경로 최대 길이
+#define USER_SHARD_BITS 6                   // 사용자 표 샤드 수 = 1 << USER_SHARD_BITS
+#define USER_SHARD_COUNT (1 << USER_SHARD_BITS)
+#define CACHE_LINE_SIZE 64
+#define STATS_SUB_BITS 4                    // 히스토그램: 2의 거듭제곱 구간마다 16칸 (상대 오차 약 6%)
+#define STATS_BUCKETS (((41 - STATS_SUB_BITS) << STATS_SUB_BITS) + (2 << STATS_SUB_BITS)) // 약 2^41ns(36분)까지
+#define STATS_POLL_MS 200                   // 계측 스레드가 덤프 요청을 확인하는 주기
+#define STATS_DEFAULT_INTERVAL 10           // 통계 파일 기본 갱신 주기 (초)
+#define SEARCH_TOKEN_MAX 64                 // 답변 검색 토큰 최대 바이트 수 (긴 단어는 잘라서 색인)
+#define SEARCH_QUERY_TOKENS 32              // 검색어 하나에서 쓰는 최대 토큰 수
+#define SEARCH_INDEX_MIN_CAPACITY 64        // 답변 색인 해시 초기 슬롯 수 (2의 거듭제곱)
+#define CONTENT_POLL_MS 200                 // 콘텐츠 감시 스레드가 변경이 잠잠해졌는지/종료 요청을 확인하는 주기
+#define WINDOW_RING_DAYS 32                 // 사용자별 날짜 버킷 수 (가장 긴 순위 기간 30일 이상, 2의 거듭제곱)
+#define REPORT_MAX_THREADS 64               // 기록 분석 스캔 스레드 수 상한
+#define REPORT_DENSE_ID_SPAN (1 << 20)      // Dare ID 범위가 이보다 좁으면 ID → 도전 번호를 배열로 찾음
+#define SHARED_USERS_DEFAULT_CAPACITY (1 << 20) // 공유 사용자 표 기본 최대 사용자 수 (tmpfs는 쓴 페이지만 메모리를 씀)
+#define SHARED_CHECKPOINT_MS 1000           // 체크포인트 프로세스가 다른 프로세스가 바꾼 사용자 행을 찾아 쓰는 주기
+#define SHARED_POLL_MS 200                  // 체크포인트 스레드가 종료 요청을 확인하는 주기
+#define SHARED_ATTACH_WAIT_MS 1000          // 공유 사용자 표를 만든 프로세스가 크기를 정하기를 기다리는 최대 시간
+#define SHARED_USERS_MAX_CAPACITY (1 << 28)  // 해시 슬롯 수 계산이 int를 넘지 않도록
+#define SHARED_MAX_PROCESSES 64             // 공유 사용자 표 하나에 동시에 붙을 수 있는 프로세스 수
+
+// 데이터 파일 (GameContext.paths의 인덱스, 이름은 dataFileNames 참고)
+enum {
+    DATA_USERS,
+    DATA_USERS_TEMP,       // 전체 재작성 중 임시 파일
+    DATA_USERS_WAL,        // 행 단위 쓰기 전 변경 행을 먼저 적어 두는 로그
+    DATA_RECORDS,
+    DATA_RECORDS_JOURNAL,  // 마지막 압축 이후 추가된 기록 (append 전용)
+    DATA_RECORDS_TEMP,     // 압축 중 임시 파일
+    DATA_TRUTH_QUESTIONS,
+    DATA_DARE_CHALLENGES,
+    DATA_SNAPSHOT,         // 빠른 시작용 바이너리 스냅샷
+    DATA_SNAPSHOT_TEMP,
+    DATA_SEARCH_INDEX,     // Truth 답변 역색인
+    DATA_SEARCH_INDEX_TEMP,
+    DATA_CATALOG,          // 질문/도전 텍스트 파일을 미리 변환한 콘텐츠 카탈로그 (매핑해서 사용)
+    DATA_CATALOG_TEMP,
+    DATA_CATEGORIES,       // Dare 카테고리 이름 → ID (한 줄에 이름 하나, 추가만 함)
+    DATA_FILE_COUNT
+};
+
+static const char* const dataFileNames[DATA_FILE_COUNT] = {
+    "users.txt", "users.txt.tmp", "users.wal",
+    "records.txt", "records.journal", "records.txt.tmp",
+    "truth_questions.txt", "dare_challenges.txt",
+    "snapshot.bin", "snapshot.bin.tmp",
+    "answers.idx", "answers.idx.tmp",
+    "content.cat", "content.cat.tmp",
+    "dare_categories.txt"
+};
+
+// 스냅샷 형식
+#define SNAPSHOT_MAGIC "TODSNAP"  // 8바이트 (NUL 포함)
+#define SNAPSHOT_VERSION 10 // 2: 기록 섹션을 항목별 배열로 저장, 3: 사용자 날짜를 일수로 저장, 4: 사용자 누적 통계, 5: Truth 질문 주머니, 6: Dare 가중치, 7: Truth 주머니를 질문 ID로, 8: 카테고리 통계를 이름 해시로, 9: Truth 주머니를 ID 범위 순열로, 10: 카테고리 통계를 카테고리 ID로
+
+// 답변 색인 파일 형식
+#define SEARCH_INDEX_MAGIC "TODSRCH" // 8바이트 (NUL 포함)
+#define SEARCH_INDEX_VERSION 1
+
+// 콘텐츠 카탈로그 파일 형식
+#define CATALOG_MAGIC "TODCATL" // 8바이트 (NUL 포함)
+#define CATALOG_VERSION 2 // 2: Dare 가중치와 카테고리별 별칭 표
+
+// 공유 사용자 표 머리 형식
+#define SHARED_USERS_MAGIC "TODSHRD" // 8바이트 (NUL 포함)
+#define SHARED_USERS_VERSION 1
+
+// --- 메모리 관리 ---
+
+// 아레나: 큰 블록을 한 번에 받아 잘라 쓰는 할당기 (개별 해제 없음, 전체 해제만)
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    max_align_t data[]; // 블록 본문 (정렬 보장)
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;  // 현재 할당 중인 블록
+    size_t nextSize;   // 다음 블록 크기 (두 배씩 증가)
+    size_t totalBytes; // 실제로 잡아 둔 메모리 합계
+} Arena;
+
+// 세그먼트 배열: 아레나에서 받은 고정 크기 청크를 이어 붙인 가변 길이 배열
+// 청크는 옮겨지지 않으므로 원소 포인터가 계속 유효하다.
+// 추가는 한 번에 한 스레드만 하고, 이미 추가된 원소는 다른 스레드가 잠금 없이 읽을 수 있다
+// (청크 포인터 표를 늘릴 때 예전 표를 해제하지 않고 새 표를 원자적으로 바꿔 끼움).
+typedef struct {
+    Arena arena;
+    _Atomic(void**) chunks; // 청크 포인터 표 (아레나에 할당, 늘릴 때마다 새 표로 교체)
+    int numChunks;
+    int capChunks;
+    int chunkShift;  // 청크당 원소 수 = 1 << chunkShift
+    size_t elemSize;
+    atomic_int count; // 저장된 원소 수
+} SegArray;
+
+#define SEG_ARRAY_INIT(type) { {NULL, 0, 0}, NULL, 0, 0, -1, sizeof(type), 0 }
+
+// 사용자별 기록 인덱스: 기록 행 번호를 날짜순으로 보관
+typedef struct {
+    int* items;
+    int count;
+    int capacity;
+} RecordList;
+
+// 기록 열 저장소의 블록: RECORD_BLOCK_ROWS개 행을 항목별 배열로 보관 (행 i는 i >> RECORD_BLOCK_SHIFT번째 블록)
+// 한 항목만 훑는 필터/집계가 그 항목의 연속된 메모리만 읽도록 행 구조체 대신 항목마다 배열을 둔다.
+typedef struct {
+    int32_t user[RECORD_BLOCK_ROWS];         // users 인덱스 (음수: 등록되지 않은 사용자, -(공유 문자열 인덱스 + 1))
+    int32_t day[RECORD_BLOCK_ROWS];          // 날짜 (1970-01-01부터의 일수)
+    int32_t contentId[RECORD_BLOCK_ROWS];
+    int32_t coinsEarned[RECORD_BLOCK_ROWS];
+    const char* response[RECORD_BLOCK_ROWS]; // 문자열 힙의 답변 (Dare 결과는 공유 문자열)
+    uint8_t type[RECORD_BLOCK_ROWS];         // 0: Truth, 1: Dare
+} RecordBlock;
+
+// 기록 열 저장소
+// 행 추가는 한 번에 한 스레드만 하며 (로드 중이거나 recordsLock 안), 추가된 행은 바뀌지 않으므로
+// 다른 스레드가 잠금 없이 읽을 수 있다 (블록과 문자열은 아레나에 있어 옮겨지지 않음).
+typedef struct {
+    SegArray blocks;   // RecordBlock
+    atomic_int count;  // 행 수 (행을 다 채운 뒤 늘림)
+    Arena strings;     // 답변 문자열 힙 (NUL 종료 문자열을 빈틈없이 이어 붙임)
+    SegArray interned; // const char*: 공유 문자열 (Dare 결과, 등록되지 않은 사용자 ID)
+    int* internSlots;  // 공유 문자열 해시 (interned 인덱스 + 1, 0은 빈 슬롯)
+    int internCapacity;
+} RecordStore;
+
+// 텍스트 기록 한 줄의 값 (열 저장소에 넣을 때/꺼낼 때 사용, 문자열은 빌려 온 포인터)
+typedef struct {
+    const char* userId;
+    int day;
+    int type;
+    int contentId;
+    int coinsEarned;
+    const char* response;
+} RecordFields;
+
+// 코인 리더보드 노드 (순서 통계 트립, users와 같은 인덱스 사용)
+// 정렬 기준: 코인 내림차순, 같으면 가입 순서(users 인덱스) 오름차순
+typedef struct {
+    int left;      // 왼쪽 자식 (-1: 없음)
+    int right;     // 오른쪽 자식
+    int size;      // 서브트리 노드 수
+    int coins;     // 트리에 넣을 때의 코인 (정렬 키, 사용자 코인은 잠금 없이 먼저 바뀜)
+    unsigned int priority;
+} RankNode;
+
+// 코인 리더보드 (누적 코인 하나와 기간별 코인마다 하나씩)
+typedef struct {
+    SegArray nodes; // RankNode (users 인덱스로 접근, 트리에 없는 사용자의 노드는 쓰지 않음)
+    int root;       // 트립의 루트 (-1: 비어 있음)
+    RankNode* sharedNodes; // NULL이 아니면 nodes/root 대신 공유 사용자 표의 노드 배열과 루트 사용
+    int* sharedRoot;
+} Leaderboard;
+
+// 사용자 하나의 기간별 코인 (날짜 버킷 링)
+// 버킷 i는 lastDay 이전 WINDOW_RING_DAYS일 중 날짜 % WINDOW_RING_DAYS == i인 날의 코인이다.
+typedef struct {
+    int lastDay;                      // 가장 최근 버킷의 날짜 (DAY_NONE: 코인 기록 없음)
+    int buckets[WINDOW_RING_DAYS];
+    int windowCoins[RANK_WINDOW_COUNT]; // windowDay 기준 기간 합계 (0이 아니면 그 기간 리더보드에 들어 있음)
+} UserWindow;
+
+// 사용자 ID 해시 인덱스 (개방 주소법, 선형 탐사)
+// 슬롯 값은 users 배열 인덱스 + 1 (0은 빈 슬롯)
+typedef struct {
+    int* slots;
+    int capacity; // 2의 거듭제곱
+    int size;
+} UserIndex;
+
+// Truth 답변 역색인의 항목 하나: (사용자, 토큰) → 그 토큰이 나오는 기록 행 번호 (오름차순)
+typedef struct {
+    const char* term; // 샤드 아레나의 토큰 문자열 (NULL: 빈 슬롯)
+    int user;         // users 인덱스
+    int* rows;
+    int count;
+    int capacity;
+} SearchTerm;
+
+// 사용자 샤드 하나의 답변 역색인 (개방 주소법, 선형 탐사)
+// 키에 사용자가 들어 있어 한 사용자를 검색할 때 다른 사용자의 기록 행은 보지 않는다.
+typedef struct {
+    SearchTerm* slots;
+    int capacity; // 2의 거듭제곱
+    int size;
+    Arena terms;  // 토큰 문자열
+} SearchIndex;
+
+// 잠금 (Windows 빌드에는 저장 스레드가 없고 컨텍스트를 한 스레드에서만 사용하므로 아무 일도 하지 않음)
+#ifdef _WIN32
+typedef int GameLock;
+static void gameLockInit(GameLock* lock) { (void)lock; }
+static void gameLockDestroy(GameLock* lock) { (void)lock; }
+static int gameLock(GameLock* lock) { (void)lock; return 0; }
+static void gameUnlock(GameLock* lock) { (void)lock; }
+#else
+// shared가 NULL이 아니면 공유 사용자 표의 프로세스 간 잠금을 대신 사용
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_mutex_t* shared;
+} GameLock;
+static void gameLockInit(GameLock* lock) {
+    pthread_mutex_init(&lock->mutex, NULL);
+    lock->shared = NULL;
+}
+static void gameLockDestroy(GameLock* lock) { pthread_mutex_destroy(&lock->mutex); }
+// 반환값: 잠금을 쥔 채 죽은 프로세스에게서 이어받았으면 1 (보호하던 자료를 고칠지는 호출자가 정함)
+static int gameLock(GameLock* lock) {
+    if (lock->shared == NULL) {
+        pthread_mutex_lock(&lock->mutex);
+        return 0;
+    }
+#ifdef __linux__
+    if (pthread_mutex_lock(lock->shared) == EOWNERDEAD) {
+        pthread_mutex_consistent(lock->shared);
+        return 1;
+    }
+#else
+    pthread_mutex_lock(lock->shared);
+#endif
+    return 0;
+}
+static void gameUnlock(GameLock* lock) { pthread_mutex_unlock(lock->shared ? lock->shared : &lock->mutex); }
+#endif
+
+// 사용자 표 샤드: ID 해시 상위 비트로 사용자를 나누고 샤드마다 따로 잠금
+// 잠금은 샤드 사용자들의 ID 인덱스, 날짜 필드, 기록 목록, 답변 색인, 변경 표시를 보호한다.
+// 잠금 순서: 샤드 → userAppendLock → recordsLock → rankLock, 샤드 → windowLock (한 번에 샤드 하나만)
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) GameLock lock; // 샤드끼리 같은 캐시 라인을 공유하지 않도록
+    UserIndex index;
+    SearchIndex search;       // 샤드 사용자들의 Truth 답변 역색인
+    int* dirtyUsers;          // 변경된 사용자 인덱스 목록
+    int numDirtyUsers;
+    int dirtyUsersCapacity;
+} UserShard;
+
+
+// 공유 사용자 표 (같은 데이터 디렉터리를 쓰는 로컬 프로세스들이 사용자 행과 누적 코인 리더보드를 함께 씀)
+// POSIX 공유 메모리에 머리, User users[capacity], RankNode rank[capacity], 사용자 ID 해시 슬롯 순서로 놓는다.
+// 잠금은 프로세스 간 robust 뮤텍스이며 GameLock.shared로 샤드/userAppendLock/rankLock 자리를 대신한다.
+// users.txt는 체크포인트 프로세스 하나만 쓴다. 다른 프로세스는 행의 dirty 표시만 남기고,
+// 체크포인트 프로세스가 SHARED_CHECKPOINT_MS마다 표시된 행을 찾아 저장한다.
+typedef struct SharedUserHeader SharedUserHeader;
+#ifdef __linux__
+struct SharedUserHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t userSize;      // sizeof(User) (빌드가 다른 프로세스는 붙지 않음)
+    int32_t capacity;       // 최대 사용자 수
+    int32_t indexCapacity;  // ID 해시 슬롯 수 (2의 거듭제곱, capacity의 두 배 이상)
+    uint64_t rankOffset;    // 머리부터 RankNode 배열까지
+    uint64_t indexOffset;   // 머리부터 ID 해시 슬롯까지
+    uint64_t size;          // 공유 메모리 전체 크기
+    atomic_int ready;        // 만든 프로세스가 사용자를 모두 채웠는지
+    atomic_int closed;       // 마지막 프로세스가 떠나는 중 (늦게 연 프로세스는 이름이 지워진 뒤 새로 만듦)
+    atomic_int checkpointer; // users.txt를 쓰는 프로세스 ID (0: 없음)
+    atomic_int count;        // 사용자 수 (추가는 appendLock 안에서)
+    int rankRoot;            // 누적 코인 트립의 루트 (rankLock으로 보호)
+    int rankCount;           // 리더보드까지 등록을 마친 사용자 수 (rankLock과 appendLock을 모두 쥐고 바꿈)
+    char path[GAME_PATH_MAX]; // 데이터 디렉터리의 실제 경로 (이름 해시가 겹친 다른 디렉터리와 구분)
+    int processes[SHARED_MAX_PROCESSES]; // 붙은 프로세스 ID (0: 빈 칸, appendLock으로 보호)
+    pthread_mutex_t appendLock;
+    pthread_mutex_t rankLock;
+    pthread_mutex_t shardLocks[USER_SHARD_COUNT];
+};
+#endif
+
+// 컨텍스트가 붙은 공유 사용자 표 (users가 NULL이면 프로세스 안의 users 배열 사용)
+typedef struct {
+    SharedUserHeader* header;
+    User* users;
+    atomic_int* count;
+    atomic_int* index;     // ID 해시 슬롯 (0: 빈 칸, 그 밖: 사용자 인덱스 + 1)
+    int* rankCount;
+    int capacity;
+    int indexCapacity;
+    size_t size;
+    int pid;
+    char name[64];         // shm_open 이름
+#ifdef __linux__
+    pthread_t checkpointThread;
+    int checkpointRunning;
+    atomic_int checkpointStopping;
+#endif
+} SharedUserTable;
+
+
+// 스냅샷 파일 헤더와 섹션 표 (모든 정수는 리틀 엔디언 고정 폭)
+enum {
+    SNAP_USERS = 1, // SnapUserRow 배열
+    SNAP_RECORDS,   // 기록 항목별 배열 (RECORDS_FILE 압축본과 같은 내용, SNAP_RECORD_ROW_BYTES 참고)
+    SNAP_TRUTH,     // SnapTruthRow 배열
+    SNAP_DARE,      // SnapDareRow 배열
+    SNAP_STRINGS,   // NUL 종료 문자열 풀
+    SNAP_SECTION_COUNT = SNAP_STRINGS
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+    uint64_t fileSize;
+} SnapshotHeader;
+
+typedef struct {
+    uint32_t type;
+    uint32_t count;      // 행 수 (문자열 풀은 바이트 수)
+    uint64_t offset;     // 파일 시작 기준 본문 위치
+    uint64_t size;       // 본문 바이트 수
+    int64_t sourceSize;  // 섹션을 만들 때의 텍스트 파일 크기 (-1: 파일 없음)
+    int64_t sourceMtime; // 섹션을 만들 때의 텍스트 파일 수정 시각
+} SnapshotSection;
+
+// 행 형식 (문자열은 문자열 풀 오프셋)
+typedef struct {
+    uint32_t idOff, passwordOff;
+    int32_t lastTruthDay, lastDareDay, coins, dareAttemptsToday;
+    int32_t truthAnswers, dareAttempts, dareCompletions, truthStreak, truthStreakDay, weekStart, weekCoins;
+    int32_t categoryIds[USER_CATEGORY_SLOTS];
+    int32_t categoryDares[USER_CATEGORY_SLOTS];
+    int32_t truthBagFirstId;
+    uint32_t truthBagSpan, truthBagCursor;
+    uint32_t truthBagKey;
+} SnapUserRow;
+// 기록 섹션은 행 대신 항목별 배열을 차례로 저장:
+// int32 day[n], int32 contentId[n], int32 coinsEarned[n], uint32 userIdOff[n], uint32 responseOff[n], uint8 type[n]
+#define SNAP_RECORD_ROW_BYTES (5 * sizeof(uint32_t) + sizeof(uint8_t))
+typedef struct { int32_t id; uint32_t questionOff; } SnapTruthRow;
+typedef struct { int32_t id; uint32_t categoryOff, challengeOff, weight; } SnapDareRow;
+
+// 스냅샷/카탈로그 작성용 문자열 풀 (같은 문자열은 한 번만 저장)
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+    uint32_t* slots;  // 오프셋 + 1 (0은 빈 슬롯)
+    size_t slotCapacity;
+    size_t count;
+} StringPoolBuilder;
+
+// 콘텐츠 카탈로그 파일 헤더 (리틀 엔디언 고정 폭, 오프셋은 파일 시작 기준이며 8바이트 정렬)
+// 본문: SnapTruthRow[truthCount] (ID순), SnapDareRow[dareCount] (ID순), CatalogCategory[categoryCount],
+// uint32 dareOrder[dareCount] (카테고리별로 모은 도전 행 번호), CatalogAlias[dareCount] (dareOrder와 같은 순서),
+// NUL 종료 문자열 풀
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t truthCount;
+    uint32_t dareCount;
+    uint32_t categoryCount;
+    uint64_t truthOffset;
+    uint64_t dareOffset;
+    uint64_t categoryOffset;
+    uint64_t dareOrderOffset;
+    uint64_t aliasOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    int64_t sourceSize[2];  // 만들 때의 truth_questions.txt, dare_challenges.txt 크기 (-1: 파일 없음)
+    int64_t sourceMtime[2];
+    uint64_t fileSize;
+} CatalogHeader;
+
+// 카테고리 하나: dareOrder[first, first + count)가 그 카테고리의 도전 행 번호 (ID순)
+typedef struct { uint32_t nameOff, first, count; } CatalogCategory;
+
+// 카테고리 안에서 가중치 비례로 뽑기 위한 별칭 표의 칸 하나 (Walker/Vose 별칭 방법)
+// 카테고리의 칸 j를 고르고, 32비트 난수가 threshold보다 작으면 j번째, 아니면 alias번째 도전 (번호는 카테고리 안 순번)
+typedef struct { uint32_t threshold, alias; } CatalogAlias;
+
+// 콘텐츠 한 판: 카탈로그 이미지 하나 (카탈로그 파일을 매핑했거나, 텍스트/스냅샷에서 같은 형식으로 메모리에 만든 것)
+// 질문/도전은 ID순 행 배열을 이진 검색으로 찾고 문자열은 이미지 안의 풀을 가리키므로, 조회는 필요한 페이지만 읽는다.
+// 다 만든 뒤 GameContext.content 포인터를 원자적으로 바꿔 끼워 공개하며, 공개한 판은 바뀌지 않는다.
+// 읽는 쪽은 잠금 없이 포인터를 읽고 자기 스레드의 ContentReader에 판 순번을 표시해 두며,
+// 교체된 판은 모든 스레드의 표시가 그보다 새 판으로 넘어간 뒤에 해제한다.
+typedef struct ContentTable {
+    const char* data;       // 이미지 전체 (CatalogHeader로 시작)
+    size_t size;
+    int mapped;             // 1: mmap, 0: malloc (unmapFile 참고)
+    int fromCatalog;        // 카탈로그 파일에서 읽은 판 (스냅샷에 콘텐츠를 따로 저장하지 않음)
+    const SnapTruthRow* truthRows;
+    const SnapDareRow* dareRows;
+    const CatalogCategory* categories;
+    const uint32_t* dareOrder;
+    const CatalogAlias* dareAlias;
+    const char* strings;
+    size_t stringsSize;
+    int truthCount;
+    int dareCount;
+    int categoryCount;
+    int* categoryIds;           // 카테고리 번호 → Dare 카테고리 ID (contentPublish에서 채움)
+    int* categoryById;          // Dare 카테고리 ID → 카테고리 번호 (-1: 이 판에 없음, categoryIdLimit + 1개)
+    int categoryIdLimit;        // 이 판을 공개할 때까지 정해진 가장 큰 카테고리 ID
+    uint64_t version;           // 공개 순번 (1부터)
+    struct ContentTable* nextRetired; // 교체되어 해제를 기다리는 판 목록
+} ContentTable;
+
+// 콘텐츠를 읽는 스레드 하나의 표시 (그 스레드만 쓰고 교체하는 쪽이 읽음, 컨텍스트와 함께 해제)
+typedef struct ContentReader {
+    struct ContentReader* next;
+    unsigned long owner;   // 스레드 번호 (threadSerial)
+    atomic_ullong pinned;  // 이 스레드가 마지막으로 읽은 판의 순번 (CONTENT_PIN_ALL: 아직 읽지 않음)
+} ContentReader;
+#define CONTENT_PIN_ALL 1 // 판 순번은 1부터이므로, 이 표시가 있으면 해제 대기 판을 모두 남김
+
+// 판을 만드는 중의 질문/도전 하나 (문자열은 StringPoolBuilder 오프셋)
+typedef struct {
+    int32_t id;
+    uint32_t order;        // 추가된 순서 (같은 ID는 먼저 나온 항목을 남김)
+    uint32_t textOff;
+    uint32_t categoryOff;  // Dare만
+    uint32_t weight;       // Dare만
+} ContentEntry;
+
+typedef struct {
+    ContentEntry* truth;
+    int truthCount;
+    int truthCapacity;
+    ContentEntry* dare;
+    int dareCount;
+    int dareCapacity;
+    StringPoolBuilder pool;
+} ContentBuilder;
+
+// 매핑된 스냅샷 파일
+typedef struct {
+    const char* data;
+    size_t size;
+    int mapped; // 1: mmap, 0: malloc으로 읽음
+    const SnapshotSection* sections[SNAP_SECTION_COUNT + 1]; // 종류별 섹션 (없으면 NULL)
+    const char* strings;
+    size_t stringsSize;
+} Snapshot;
+
+
+// 답변 색인 파일 헤더 (리틀 엔디언 고정 폭)
+// 헤더 뒤에 항목 termCount개가 이어짐: uint32 termLen, uint32 rowCount, 토큰(termLen바이트), uint32 rows[rowCount]
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t rowCount;  // 색인에 반영한 앞쪽 기록 행 수
+    uint32_t rowCheck;  // 마지막 반영 행의 검사값 (기록 파일이 그대로인지 확인)
+    uint32_t termCount;
+    uint64_t fileSize;
+} SearchIndexHeader;
+
+
+// 비동기 저장 항목 (핸들러가 미리 파일에 쓸 문자열로 만들어 넘김)
+enum { PERSIST_RECORD = 1, PERSIST_USER_ROW };
+
+typedef struct {
+    int type;
+    uint32_t rowIndex; // PERSIST_USER_ROW: users.txt 행 번호
+    size_t length;
+    char data[RECORD_LINE_MAX > USER_ROW_WIDTH ? RECORD_LINE_MAX : USER_ROW_WIDTH];
+} PersistEntry;
+
+#ifndef _WIN32
+// 고정 크기 무잠금 MPMC 큐 (셀마다 순번을 두는 방식)
+typedef struct {
+    atomic_size_t sequence;
+    PersistEntry entry;
+} PersistCell;
+
+typedef struct {
+    PersistCell* cells;
+    atomic_size_t enqueuePos;
+    char pad[64]; // 생산자/소비자 위치가 같은 캐시 라인을 공유하지 않도록
+    atomic_size_t dequeuePos;
+    atomic_int writerSleeping;
+} PersistQueue;
+#endif
+
+
+// 계측 항목 (statOpNames와 같은 순서)
+enum {
+    STAT_LOAD_USERS,      // users.txt 또는 스냅샷에서 사용자 로드 (파싱 포함)
+    STAT_LOAD_RECORDS,    // 기록 압축본 + 저널 로드와 사용자별 목록 구성
+    STAT_LOAD_CONTENT,    // Truth 질문 / Dare 도전 로드
+    STAT_REWRITE_USERS,   // users.txt 전체 재작성
+    STAT_COMPACT_RECORDS, // 기록 압축 (records.txt 전체 재작성)
+    STAT_SAVE_SNAPSHOT,
+    STAT_WRITE_USER_ROWS, // 저장 스레드: 바뀐 사용자 행 덮어쓰기 (로그 포함)
+    STAT_JOURNAL_APPEND,  // 저장 스레드: 기록 저널에 추가
+    STAT_PERSIST_COMMIT,  // 저장 스레드: 그룹 커밋 한 번 전체
+    STAT_SIGN_UP,
+    STAT_LOGIN,
+    STAT_ANSWER_TRUTH,
+    STAT_ATTEMPT_DARE,
+    STAT_LIST_RECORDS,    // 기록 보기 (한 페이지)
+    STAT_SEARCH_RECORDS,  // 답변 검색 (한 페이지)
+    STAT_RANKING,         // 상위 순위 / 자기 순위 조회
+    STAT_TRUTH_QUESTION,  // 사용자별 Truth 질문 차례 조회
+    STAT_RANDOM_DARE,     // Dare 도전 무작위 선택
+    STAT_REPORT,          // 기록 분석 보고서 전체
+    STAT_OP_COUNT
+};
+
+static const char* const statOpNames[STAT_OP_COUNT] = {
+    "load_users", "load_records", "load_content", "rewrite_users", "compact_records", "save_snapshot",
+    "write_user_rows", "journal_append", "persist_commit",
+    "sign_up", "login", "answer_truth", "attempt_dare", "list_records", "search_records", "ranking",
+    "truth_question", "random_dare", "report"
+};
+
+enum { STAT_IO_READ_BYTES, STAT_IO_WRITE_BYTES, STAT_IO_FSYNC, STAT_IO_COUNT };
+
+// 스레드 하나가 한 컨텍스트에서 쌓는 계측 값 (그 스레드만 쓰고, 덤프할 때 다른 스레드가 읽음)
+// 쓰는 쪽이 하나뿐이므로 원자적 읽기 + 쓰기(relaxed)로 충분하며 잠금 명령이 필요 없다.
+typedef struct StatsBuffer {
+    struct StatsBuffer* next;
+    unsigned long owner; // 스레드 번호 (threadSerial)
+    atomic_ullong count[STAT_OP_COUNT];
+    atomic_ullong totalNanos[STAT_OP_COUNT];
+    atomic_ullong maxNanos[STAT_OP_COUNT];
+    atomic_ullong io[STAT_IO_COUNT];
+    atomic_ullong histogram[STAT_OP_COUNT][STATS_BUCKETS];
+} StatsBuffer;
+
+// 모든 스레드의 버퍼를 합친 값 (덤프할 때만 만듦)
+typedef struct {
+    uint64_t count[STAT_OP_COUNT];
+    uint64_t totalNanos[STAT_OP_COUNT];
+    uint64_t maxNanos[STAT_OP_COUNT];
+    uint64_t io[STAT_IO_COUNT];
+    uint64_t histogram[STAT_OP_COUNT][STATS_BUCKETS];
+} StatsTotals;
+
+
+// 기록 분석 스캔 단계
+enum {
+    REPORT_PASS_RANGE = 1, // 기록의 처음/마지막 날짜 (기록 블록을 나눔)
+    REPORT_PASS_SCAN,      // 날짜별/도전별 집계 (기록 블록을 나눔)
+    REPORT_PASS_BITMAP,    // 날짜 × 사용자 비트맵 채우기 (날짜 행을 나눔)
+    REPORT_PASS_USERS      // 비트맵에서 날짜별 활동 사용자 수와 Truth 연속 참여 (사용자 단어를 나눔)
+};
+
+// 날짜별 집계 열 (ReportWorker.daily에서 numDays개씩)
+enum { REPORT_COL_TRUTH, REPORT_COL_DARE, REPORT_COL_COMPLETE, REPORT_COL_COINS, REPORT_COL_ACTIVE, REPORT_COL_COUNT };
+
+// 모든 스캔 스레드가 함께 읽는 값 (비트맵은 날짜 행마다 한 스레드만 씀)
+typedef struct {
+    GameContext* ctx;
+    const ContentTable* content; // 시작할 때의 콘텐츠 판 (ID순 도전 행)
+    int rowCount;              // 시작할 때의 기록 수 (이후 추가된 행은 보지 않음)
+    int numUsers;              // 시작할 때의 사용자 수
+    int firstDay;
+    int numDays;
+    int words;                 // 비트맵 한 날짜 행의 64비트 단어 수
+    uint64_t* userBits;        // [numDays][words][2]: 그날 기록을 남긴 사용자, Truth에 답한 사용자 (같은 캐시 라인)
+    const int* dareSlots;      // Dare ID - dareMinId → 도전 번호 + 1 (NULL: ID순 행에서 이진 검색)
+    int dareMinId;
+    int dareSpan;
+    int numChallenges;
+    const char* complete;      // 공유 문자열 "Complete" (포인터 비교, NULL: 완료 기록 없음)
+} ReportScan;
+
+// 스캔 스레드 하나의 작업 범위와 부분 결과 (끝난 뒤 호출한 스레드가 합침)
+typedef struct {
+    const ReportScan* scan;
+    int pass;
+    int firstBlock, endBlock; // 맡은 기록 블록 [firstBlock, endBlock)
+    int firstRow, endRow;     // 맡은 비트맵 날짜 행 [firstRow, endRow)
+    int firstWord, endWord;   // 맡은 비트맵 단어 (사용자 64명씩) [firstWord, endWord)
+    int minDay, maxDay;
+    long long records;
+    long long* daily;         // [REPORT_COL_COUNT][numDays]
+    long long* dareCounts;    // [numChallenges][2]: 시도, 완료
+    int streakUsers[REPORT_STREAK_BUCKETS];
+    int longestStreak;
+    int ongoingStreaks;
+    int started;              // 별도 스레드로 시작했는지
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+} ReportWorker;
+
+
+// --- 게임 컨텍스트 ---
+// 게임 상태 전체 (전역 변수 없이 컨텍스트마다 독립)
+struct GameContext {
+    UserShard userShards[USER_SHARD_COUNT];
+    SegArray users;
+    SegArray userRecordLists; // users와 같은 인덱스의 사용자별 기록 목록
+    GameLock userAppendLock;  // users/userRecordLists 끝에 추가 (회원가입)
+    SharedUserTable shared;   // 공유 사용자 표 (users/ID 인덱스/rankBoard를 대신함)
+    int sharedRequested;      // GameConfig.sharedUsers
+    int sharedCapacity;       // 새로 만들 공유 사용자 표의 최대 사용자 수
+
+    Leaderboard rankBoard; // 누적 코인 리더보드
+    GameLock rankLock;     // rankBoard 전체
+
+    Leaderboard windowBoards[RANK_WINDOW_COUNT]; // 기간별 코인 리더보드 (기간 코인이 있는 사용자만)
+    SegArray userWindows;  // UserWindow (users와 같은 인덱스, Dare 코인을 처음 얻을 때 늘림)
+    int windowDay;         // 기간 합계와 리더보드의 기준 날짜 (DAY_NONE: 아직 만들지 않음)
+    GameLock windowLock;   // windowBoards, userWindows, windowDay
+
+    _Atomic(ContentTable*) content;         // 현재 콘텐츠 판 (읽을 때는 contentAcquire)
+    _Atomic(ContentReader*) contentReaders; // 콘텐츠를 읽은 스레드 목록 (추가만 함, 무잠금)
+    ContentTable* retiredContent; // 교체되었지만 아직 읽는 스레드가 있을 수 있는 판 (contentLock으로 보호)
+    uint64_t contentVersion;      // 마지막으로 공개한 판 순번 (contentLock으로 보호)
+    GameLock contentLock;         // 판 공개/해제 (읽는 쪽은 잡지 않음)
+    StringPoolBuilder categoryNames; // Dare 카테고리 이름 (dare_categories.txt에서 읽은 것, contentLock으로 보호)
+    uint32_t* categoryNameOffs;   // 카테고리 ID - 1 → categoryNames 오프셋 (ID순으로 넣으므로 오프셋도 오름차순)
+    int categoryNameCount;
+    int categoryNameCapacity;
+    long categoryFileRead;        // dare_categories.txt에서 읽은 바이트 수 (다른 프로세스가 붙인 줄은 그 뒤에 있음)
+#ifdef __linux__
+    int contentWatchFd;           // 데이터 디렉터리 inotify (-1: 감시하지 않음)
+    pthread_t contentThread;
+    int contentRunning;
+    atomic_int contentStopping;
+#endif
+    RecordStore records;
+    GameLock recordsLock; // records 추가와 저널 제출 순서
+
+    // 기록 저널 상태
+    FILE* recordsJournal; // 열려 있는 저널 파일 (append 모드)
+    int baseRecordCount;  // 압축본(records.txt)에 들어 있는 기록 수
+
+    int searchFileRows;   // answers.idx에 들어 있는 기록 행 수 (-1: 파일 없음 또는 못 씀, 종료 시 다르면 다시 저장)
+
+    // 비동기 저장 상태
+    int durabilityLevel;
+    int persistRunning; // 저장 스레드 동작 중 (아니면 제출 즉시 동기 저장)
+#ifndef _WIN32
+    PersistQueue persistQueue;
+    pthread_t persistThread;
+    pthread_mutex_t persistMutex;
+    pthread_cond_t persistWakeCond;   // 저장 스레드 깨우기
+    pthread_cond_t persistCommitCond; // 커밋 완료 알림
+    size_t persistCommitted; // 커밋된 항목 수 (persistMutex로 보호)
+    int persistStopping;
+#endif
+
+    // 스냅샷 상태 (시작 시 로드하는 동안만 열려 있음)
+    Snapshot snapshot;
+    int snapshotRequireFresh; // 1: 텍스트 파일이 바뀐 섹션은 무시
+
+    // users.txt 행 단위 저장 상태 (변경된 사용자 목록은 샤드마다)
+    int usersFileFixedLayout; // users.txt가 users 배열과 같은 순서의 고정 폭 행으로 되어 있는지
+
+    // 계측 (statsEnabled가 0이면 측정 함수가 시각을 읽지 않고 바로 반환)
+    int statsEnabled;
+    unsigned long statsId;     // 스레드별 버퍼/콘텐츠 표시 캐시가 컨텍스트를 구분하는 번호
+    StatsBuffer* statsBuffers; // 스레드별 버퍼 목록 (statsLock으로 보호, 컨텍스트와 함께 해제)
+    GameLock statsLock;
+    char statsFile[GAME_PATH_MAX]; // 주기적으로 쓰는 통계 파일 (빈 문자열: 없음)
+    int statsInterval;
+    atomic_int statsDumpRequested; // 신호 처리기가 올리는 덤프 요청
+#ifndef _WIN32
+    pthread_t statsThread;
+    int statsRunning;
+    int statsStopping;
+    pthread_mutex_t statsMutex;
+    pthread_cond_t statsCond; // 계측 스레드 종료 알림
+#endif
+
+    FILE* log;              // 로드/저장 메시지 출력 (NULL: 출력 안 함)
+    uint64_t rngSeed;       // 난수 시드 (스레드별 흐름과 사용자별 질문 순서의 바탕)
+    int rngSeeded;          // GameConfig.seed로 고정된 시드 (질문 순서를 시드와 사용자 ID만으로 정함)
+    atomic_ulong rngStreams; // 스레드별 난수 흐름 번호 발급
+    atomic_ullong todayCache; // gameToday() 캐시: 다음 지역 자정 시각 << 24 | 오늘 일수 (0: 없음)
+    char paths[DATA_FILE_COUNT][GAME_PATH_MAX];
+    char dataDir[GAME_PATH_MAX]; // 데이터 디렉터리 (콘텐츠 파일 감시용, "."은 현재 디렉터리)
+};
+
+// 로드/저장 메시지 출력
+static void gameLog(GameContext* ctx, const char* format, ...) {
+    if (ctx->log == NULL) return;
+    va_list args;
+    va_start(args, format);
+    vfprintf(ctx->log, format, args);
+    va_end(args);
+    fflush(ctx->log);
+}
+
+// 메모리 할당 실패 (복구하지 않고 종료)
+static void outOfMemory() {
+    fprintf(stderr, "메모리가 부족합니다.\n");
+    exit(1);
+}
+
+// 64비트 값 섞기 (splitmix64, 시드에서 서로 겹치지 않는 상태를 만들 때 사용)
+static uint64_t splitMix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static _Thread_local uint64_t threadRngState;     // 이 스레드의 난수 상태 (xorshift64*)
+static _Thread_local unsigned long threadRngCtxId; // threadRngState가 속한 컨텍스트 번호 (0: 없음)
+
+// 컨텍스트 전용 난수 (전역 rand() 상태를 공유하지 않음)
+// 스레드마다 시드에서 갈라진 흐름을 따로 가지므로 공유 상태에 원자 연산을 하지 않는다.
+// 시드를 고정하면 스레드가 처음 난수를 쓴 순서대로 같은 흐름을 받는다.
+static unsigned int gameRandom(GameContext* ctx) {
+    if (threadRngCtxId != ctx->statsId) {
+        uint64_t stream = atomic_fetch_add_explicit(&ctx->rngStreams, 1, memory_order_relaxed);
+        threadRngState = splitMix64(ctx->rngSeed + stream * 0x9e3779b97f4a7c15ull);
+        if (threadRngState == 0) threadRngState = 0x9e3779b97f4a7c15ull; // xorshift는 0에서 벗어나지 못함
+        threadRngCtxId = ctx->statsId;
+    }
+    uint64_t x = threadRngState;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    threadRngState = x;
+    return (unsigned int)((x * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+// 날짜는 모두 1970-01-01부터의 일수(정수)로 다루고, 텍스트 파일과 화면에 쓸 때만 "YYYY-MM-DD"로 바꾼다.
+
+// 그레고리력 날짜 → 1970-01-01부터의 일수
+static int daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1; // 3월 1일부터
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// 1970-01-01부터의 일수 → 그레고리력 날짜
+static void civilFromDays(int days, int* year, int* month, int* day) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int mp = (5 * dayOfYear + 2) / 153;
+    *day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = yearOfEra + era * 400 + (*month <= 2);
+}
+
+// "YYYY-MM-DD" → 일수 (형식이 다르거나 없는 날짜면 0 반환)
+// 하루 전환 검사와 정렬은 정수 비교로 하고, 이 변환은 파일을 읽을 때만 한다.
+static int parseDay(const char* str, int* days) {
+    int year, month, day, consumed = 0;
+    if (sscanf(str, "%4d-%2d-%2d%n", &year, &month, &day, &consumed) != 3 || str[consumed] != '\0' ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return 0;
+    }
+    int y, m, d;
+    *days = daysFromCivil(year, month, day);
+    civilFromDays(*days, &y, &m, &d);
+    return m == month && d == day; // 2월 30일 등은 다음 달로 넘어가므로 거름
+}
+
+// 사용자 파일의 날짜 칸 → 일수 ("none"이나 읽을 수 없는 값은 DAY_NONE)
+static int parseUserDay(const char* str) {
+    int days;
+    return parseDay(str, &days) ? days : DAY_NONE;
+}
+
+int parseGameDay(const char* str, int* day) {
+    return parseDay(str, day);
+}
+
+// 일수 → "YYYY-MM-DD" (기록 보기/압축에서 행마다 부르므로 printf 없이 직접 만듦)
+void formatGameDay(int days, char* out) {
+    if (days == DAY_NONE) {
+        strcpy(out, "none");
+        return;
+    }
+    int year, month, day;
+    civilFromDays(days, &year, &month, &day);
+    if (year < 0 || year > 9999) year = 0; // parseDay가 받는 범위 밖 (생기지 않음)
+    out[0] = (char)('0' + year / 1000);
+    out[1] = (char)('0' + year / 100 % 10);
+    out[2] = (char)('0' + year / 10 % 10);
+    out[3] = (char)('0' + year % 10);
+    out[4] = '-';
+    out[5] = (char)('0' + month / 10);
+    out[6] = (char)('0' + month % 10);
+    out[7] = '-';
+    out[8] = (char)('0' + day / 10);
+    out[9] = (char)('0' + day % 10);
+    out[10] = '\0';
+}
+
+// 오늘 날짜 (지역 시간 기준 일수)
+// 지역 시간 계산은 다음 지역 자정을 지났을 때만 하고, 그 전에는 캐시한 값을 돌려준다 (time() 한 번과 비교 한 번).
+// 캐시는 (다음 자정 시각 << 24 | 일수) 원자적 값 하나라서 여러 세션 스레드가 잠금 없이 읽고 갱신한다.
+static int gameToday(GameContext* ctx) {
+    time_t now = time(NULL);
+    uint64_t cache = atomic_load_explicit(&ctx->todayCache, memory_order_relaxed);
+    int64_t rollover = (int64_t)(cache >> 24);
+    if (now < rollover && now >= rollover - TODAY_MAX_DAY_SECONDS) { // 시계가 하루 넘게 뒤로 가면 다시 계산
+        return (int)(cache & 0xFFFFFF);
+    }
+    struct tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &now);
+#else
+    localtime_r(&now, &tm); // localtime()의 공유 버퍼를 쓰지 않음
+#endif
+    int today = daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    // 다음 지역 자정 (일광 절약 시간 전환으로 하루가 23/25시간이어도 mktime이 맞춰 줌)
+    tm.tm_mday++;
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    time_t nextMidnight = mktime(&tm);
+    if (today >= 0 && today < (1 << 24) && nextMidnight > now) {
+        atomic_store_explicit(&ctx->todayCache, ((uint64_t)nextMidnight << 24) | (uint64_t)today, memory_order_relaxed);
+    }
+    return today;
+}
+
+// 개행 문자 제거 함수 (fgets 사용 시 유용)
+void removeNewline(char* str) {
+    str[strcspn(str, "\n")] = 0;
+}
+
+// 길이 제한 문자열 복사 (항상 NUL 종료)
+void copyString(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (len >= size) len = size - 1;
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+// --- 계측 함수 ---
+// 측정 지점은 statsBegin()/statsEnd() 한 쌍이며, 계측이 꺼져 있으면 statsBegin()이 0을 돌려주고
+// statsEnd()는 아무것도 하지 않는다 (분기 하나, 시각 읽기 없음).
+
+static atomic_ulong nextStatsId = 1;     // 컨텍스트 번호 발급 (프로세스 전체)
+static atomic_ulong nextThreadSerial = 1; // 스레드 번호 발급
+static _Thread_local unsigned long threadSerial;     // 이 스레드의 번호 (0: 아직 없음)
+static _Thread_local StatsBuffer* threadStats;       // 이 스레드가 마지막으로 쓴 버퍼
+static _Thread_local unsigned long threadStatsCtxId; // threadStats가 속한 컨텍스트 번호
+
+static uint64_t statsNow() {
+    struct timespec ts;
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// 이 스레드의 버퍼 (처음이면 목록에서 찾거나 새로 만듦)
+static StatsBuffer* statsBuffer(GameContext* ctx) {
+    if (threadStats != NULL && threadStatsCtxId == ctx->statsId) return threadStats;
+    if (threadSerial == 0) threadSerial = atomic_fetch_add(&nextThreadSerial, 1);
+    gameLock(&ctx->statsLock);
+    StatsBuffer* buf = ctx->statsBuffers;
+    while (buf != NULL && buf->owner != threadSerial) buf = buf->next;
+    if (buf == NULL) {
+        buf = calloc(1, sizeof(StatsBuffer));
+        if (buf == NULL) outOfMemory();
+        buf->owner = threadSerial;
+        buf->next = ctx->statsBuffers;
+        ctx->statsBuffers = buf;
+    }
+    gameUnlock(&ctx->statsLock);
+    threadStats = buf;
+    threadStatsCtxId = ctx->statsId;
+    return buf;
+}
+
+// 한 스레드만 쓰는 카운터에 더하기 (잠금 명령 없이)
+static void statsAdd(atomic_ullong* counter, uint64_t value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+// 지연(ns) → 히스토그램 칸: 2^(STATS_SUB_BITS+1) 미만은 1ns 단위, 그 위는 2의 거듭제곱 구간마다 2^STATS_SUB_BITS칸
+static int statsBucket(uint64_t nanos) {
+    const uint64_t linear = 2u << STATS_SUB_BITS;
+    if (nanos < linear) return (int)nanos;
+    int msb = 63;
+    while (!(nanos >> msb)) msb--;
+    int shift = msb - STATS_SUB_BITS;
+    int idx = (int)linear + ((shift - 1) << STATS_SUB_BITS) + (int)((nanos >> shift) - (1u << STATS_SUB_BITS));
+    return idx < STATS_BUCKETS ? idx : STATS_BUCKETS - 1;
+}
+
+// 히스토그램 칸의 대표값 (칸의 윗값, ns)
+static uint64_t statsBucketValue(int idx) {
+    const int linear = 2 << STATS_SUB_BITS;
+    if (idx < linear) return (uint64_t)idx;
+    int shift = (idx - linear) / (1 << STATS_SUB_BITS) + 1;
+    uint64_t mantissa = (uint64_t)((idx - linear) % (1 << STATS_SUB_BITS)) + (1u << STATS_SUB_BITS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+// 측정 시작 (계측이 꺼져 있으면 0)
+static uint64_t statsBegin(GameContext* ctx) {
+    return ctx->statsEnabled ? statsNow() : 0;
+}
+
+// 측정 끝: 횟수, 합계, 최대, 히스토그램 갱신
+static void statsEnd(GameContext* ctx, int op, uint64_t start) {
+    if (start == 0) return;
+    uint64_t nanos = statsNow() - start;
+    StatsBuffer* buf = statsBuffer(ctx);
+    statsAdd(&buf->count[op], 1);
+    statsAdd(&buf->totalNanos[op], nanos);
+    if (nanos > atomic_load_explicit(&buf->maxNanos[op], memory_order_relaxed)) {
+        atomic_store_explicit(&buf->maxNanos[op], nanos, memory_order_relaxed);
+    }
+    statsAdd(&buf->histogram[op][statsBucket(nanos)], 1);
+}
+
+// 입출력 카운터 (읽은/쓴 바이트, fsync 횟수)
+static void statsIo(GameContext* ctx, int kind, uint64_t value) {
+    if (!ctx->statsEnabled) return;
+    statsAdd(&statsBuffer(ctx)->io[kind], value);
+}
+
+// 히스토그램에서 q 분위 지연 (칸의 윗값이므로 최대 1/2^STATS_SUB_BITS만큼 크게 나옴, 최대값을 넘지 않음)
+static uint64_t statsPercentile(const uint64_t* histogram, double q, uint64_t maxNanos) {
+    uint64_t total = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) total += histogram[i];
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (double)total);
+    if (rank >= total) rank = total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen > rank) {
+            uint64_t value = statsBucketValue(i);
+            return value < maxNanos ? value : maxNanos;
+        }
+    }
+    return maxNanos;
+}
+
+void dumpGameStats(GameContext* ctx, FILE* out) {
+    if (!ctx->statsEnabled) {
+        fprintf(out, "계측이 꺼져 있습니다.\n");
+        return;
+    }
+    StatsTotals* total = calloc(1, sizeof(StatsTotals));
+    if (total == NULL) outOfMemory();
+    int threads = 0;
+    // 버퍼 목록만 잠그고, 값은 쓰는 스레드를 멈추지 않고 읽음 (항목 사이가 약간 어긋날 수 있음)
+    gameLock(&ctx->statsLock);
+    for (StatsBuffer* buf = ctx->statsBuffers; buf != NULL; buf = buf->next) {
+        threads++;
+        for (int op = 0; op < STAT_OP_COUNT; op++) {
+            total->count[op] += atomic_load_explicit(&buf->count[op], memory_order_relaxed);
+            total->totalNanos[op] += atomic_load_explicit(&buf->totalNanos[op], memory_order_relaxed);
+            uint64_t maxNanos = atomic_load_explicit(&buf->maxNanos[op], memory_order_relaxed);
+            if (maxNanos > total->maxNanos[op]) total->maxNanos[op] = maxNanos;
+            for (int i = 0; i < STATS_BUCKETS; i++) {
+                total->histogram[op][i] += atomic_load_explicit(&buf->histogram[op][i], memory_order_relaxed);
+            }
+        }
+        for (int k = 0; k < STAT_IO_COUNT; k++) {
+            total->io[k] += atomic_load_explicit(&buf->io[k], memory_order_relaxed);
+        }
+    }
+    gameUnlock(&ctx->statsLock);
+
+    fprintf(out, "# 동작별 지연 (us, 스레드 %d개)\n", threads);
+    fprintf(out, "%-16s %10s %10s %10s %10s %10s %10s\n", "op", "count", "mean", "p50", "p99", "p999", "max");
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        uint64_t count = total->count[op];
+        if (count == 0) continue;
+        const uint64_t* h = total->histogram[op];
+        uint64_t maxNanos = total->maxNanos[op];
+        fprintf(out, "%-16s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", statOpNames[op], (unsigned long long)count,
+                (double)total->totalNanos[op] / count / 1000.0,
+                statsPercentile(h, 0.50, maxNanos) / 1000.0,
+                statsPercentile(h, 0.99, maxNanos) / 1000.0,
+                statsPercentile(h, 0.999, maxNanos) / 1000.0,
+                maxNanos / 1000.0);
+    }
+    fprintf(out, "# 입출력\n");
+    fprintf(out, "read_bytes %llu\nwrite_bytes %llu\nfsync %llu\n",
+            (unsigned long long)total->io[STAT_IO_READ_BYTES],
+            (unsigned long long)total->io[STAT_IO_WRITE_BYTES],
+            (unsigned long long)total->io[STAT_IO_FSYNC]);
+    fflush(out);
+    free(total);
+}
+
+void requestGameStatsDump(GameContext* ctx) {
+    atomic_store(&ctx->statsDumpRequested, 1); // 원자적 저장 하나뿐이므로 신호 처리기에서도 안전
+}
+
+// 통계 파일을 임시 파일에 쓴 뒤 교체 (읽는 쪽이 반쯤 쓴 파일을 보지 않도록)
+static void writeStatsFile(GameContext* ctx) {
+    if (!ctx->statsEnabled || ctx->statsFile[0] == '\0') return;
+    char temp[GAME_PATH_MAX + 8];
+    snprintf(temp, sizeof(temp), "%s.tmp", ctx->statsFile);
+    FILE* fp = fopen(temp, "w");
+    if (fp == NULL) return;
+    dumpGameStats(ctx, fp);
+    fclose(fp);
+#ifdef _WIN32
+    remove(ctx->statsFile);
+#endif
+    rename(temp, ctx->statsFile);
+}
+
+#ifndef _WIN32
+// 계측 스레드: 덤프 요청을 STATS_POLL_MS마다 확인하고, statsInterval초마다 통계 파일 갱신
+// (신호 처리기에서는 파일을 쓸 수 없으므로 요청 표시만 하고 실제 출력은 이 스레드가 함)
+static void* statsWriterMain(void* arg) {
+    GameContext* ctx = arg;
+    uint64_t interval = (uint64_t)ctx->statsInterval * 1000000000ull;
+    uint64_t nextWrite = statsNow() + interval;
+    pthread_mutex_lock(&ctx->statsMutex);
+    while (!ctx->statsStopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += STATS_POLL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&ctx->statsCond, &ctx->statsMutex, &deadline);
+        if (ctx->statsStopping) break;
+        pthread_mutex_unlock(&ctx->statsMutex);
+
+        int requested = atomic_exchange(&ctx->statsDumpRequested, 0);
+        if (requested) dumpGameStats(ctx, stderr);
+        if (requested || statsNow() >= nextWrite) {
+            writeStatsFile(ctx);
+            nextWrite = statsNow() + interval;
+        }
+        pthread_mutex_lock(&ctx->statsMutex);
+    }
+    pthread_mutex_unlock(&ctx->statsMutex);
+    return NULL;
+}
+#endif
+
+// 계측 스레드 시작 (계측이 꺼져 있거나 스레드를 만들 수 없으면 덤프 요청은 무시됨)
+static void statsStart(GameContext* ctx) {
+#ifndef _WIN32
+    if (!ctx->statsEnabled || ctx->statsRunning) return;
+    ctx->statsStopping = 0;
+    if (pthread_create(&ctx->statsThread, NULL, statsWriterMain, ctx) == 0) ctx->statsRunning = 1;
+#else
+    (void)ctx;
+#endif
+}
+
+static void statsStop(GameContext* ctx) {
+#ifndef _WIN32
+    if (!ctx->statsRunning) return;
+    pthread_mutex_lock(&ctx->statsMutex);
+    ctx->statsStopping = 1;
+    pthread_cond_signal(&ctx->statsCond);
+    pthread_mutex_unlock(&ctx->statsMutex);
+    pthread_join(ctx->statsThread, NULL);
+    ctx->statsRunning = 0;
+#else
+    (void)ctx;
+#endif
+}
+
+// 파일 내용을 디스크에 강제로 기록
+static void syncFile(GameContext* ctx, FILE* fp) {
+    statsIo(ctx, STAT_IO_FSYNC, 1);
+    fflush(fp);
+#ifdef _WIN32
+    _commit(_fileno(fp));
+#else
+    fsync(fileno(fp));
+#endif
+}
+
+
+// --- 메모리 관리 함수 ---
+
+// 아레나에서 size 바이트 할당 (0으로 초기화, 실패 시 프로그램 종료)
+static void* arenaAlloc(Arena* arena, size_t size) {
+    size = (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+    ArenaBlock* block = arena->head;
+    if (block == NULL || block->size - block->used < size) {
+        size_t blockSize = arena->nextSize ? arena->nextSize : ARENA_MIN_BLOCK;
+        while (blockSize < size) blockSize *= 2;
+        block = malloc(sizeof(ArenaBlock) + blockSize);
+        if (block == NULL) outOfMemory();
+        block->next = arena->head;
+        block->used = 0;
+        block->size = blockSize;
+        arena->head = block;
+        arena->totalBytes += blockSize;
+        arena->nextSize = blockSize * 2 > ARENA_MAX_BLOCK ? ARENA_MAX_BLOCK : blockSize * 2;
+    }
+    void* ptr = (char*)block->data + block->used;
+    block->used += size;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+// 문자열을 정렬 없이 이어 붙여 복사 (문자열만 담는 아레나에서만 사용, 최대 maxLen바이트 + NUL)
+static const char* arenaCopyString(Arena* arena, const char* str, size_t maxLen) {
+    size_t len = strlen(str);
+    if (len > maxLen) len = maxLen;
+    ArenaBlock* block = arena->head;
+    if (block == NULL || block->size - block->used < len + 1) {
+        arenaAlloc(arena, len + 1); // 새 블록을 받은 뒤 그 앞부분을 사용
+        block = arena->head;
+        block->used = 0;
+    }
+    char* ptr = (char*)block->data + block->used;
+    memcpy(ptr, str, len);
+    ptr[len] = '\0';
+    block->used += len + 1;
+    return ptr;
+}
+
+// 아레나 전체 해제
+static void arenaFree(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->nextSize = 0;
+    arena->totalBytes = 0;
+}
+
+// i번째 원소의 주소
+static void* segAt(const SegArray* arr, int i) {
+    int mask = (1 << arr->chunkShift) - 1;
+    void** chunks = atomic_load_explicit(&arr->chunks, memory_order_acquire);
+    return (char*)chunks[i >> arr->chunkShift] + (size_t)(i & mask) * arr->elemSize;
+}
+
+// 끝에 원소 하나를 추가하고 (0으로 초기화된) 그 주소를 반환
+static void* segPush(SegArray* arr) {
+    if (arr->chunkShift < 0) {
+        // 청크 하나가 SEG_CHUNK_BYTES 안에 들어가도록 2의 거듭제곱 개수 선택
+        arr->chunkShift = 0;
+        while (((size_t)2 << arr->chunkShift) * arr->elemSize <= SEG_CHUNK_BYTES) arr->chunkShift++;
+    }
+    int chunk = arr->count >> arr->chunkShift;
+    if (chunk == arr->numChunks) {
+        void** chunks = atomic_load_explicit(&arr->chunks, memory_order_relaxed);
+        if (arr->numChunks == arr->capChunks) {
+            // 다른 스레드가 예전 표를 읽고 있을 수 있으므로 복사본을 만들어 바꿔 끼우고 예전 표는 아레나에 남김
+            int newCap = arr->capChunks ? arr->capChunks * 2 : 8;
+            void** newChunks = arenaAlloc(&arr->arena, sizeof(void*) * newCap);
+            if (arr->numChunks > 0) memcpy(newChunks, chunks, sizeof(void*) * arr->numChunks);
+            chunks = newChunks;
+            arr->capChunks = newCap;
+        }
+        chunks[arr->numChunks++] = arenaAlloc(&arr->arena, arr->elemSize << arr->chunkShift);
+        atomic_store_explicit(&arr->chunks, chunks, memory_order_release);
+    }
+    return segAt(arr, arr->count++);
+}
+
+// 모든 원소 제거 및 메모리 반환
+static void segClear(SegArray* arr) {
+    arenaFree(&arr->arena); // 청크 포인터 표도 아레나에 있음
+    arr->chunks = NULL;
+    arr->numChunks = 0;
+    arr->capChunks = 0;
+    arr->count = 0;
+}
+
+// 자료형별 접근 함수
+static User* userAt(GameContext* ctx, int i) {
+    return ctx->shared.users != NULL ? &ctx->shared.users[i] : (User*)segAt(&ctx->users, i);
+}
+
+static int userCount(GameContext* ctx) {
+    return ctx->shared.users != NULL ? atomic_load(ctx->shared.count) : ctx->users.count;
+}
+
+// users 끝에 0으로 채운 사용자 추가 (공유 사용자 표가 가득 찼으면 NULL, 로드 중이나 userAppendLock 안에서 호출)
+static User* userPush(GameContext* ctx) {
+    if (ctx->shared.users == NULL) return segPush(&ctx->users);
+    int count = atomic_load(ctx->shared.count);
+    if (count >= ctx->shared.capacity) return NULL;
+    User* u = &ctx->shared.users[count];
+    memset(u, 0, sizeof(User));
+    atomic_store(ctx->shared.count, count + 1);
+    return u;
+}
+
+// users.txt를 이 프로세스가 쓰는지 (공유 사용자 표가 아니면 항상)
+static int sharedIsCheckpointer(GameContext* ctx) {
+#ifdef __linux__
+    if (ctx->shared.header != NULL) return atomic_load(&ctx->shared.header->checkpointer) == ctx->shared.pid;
+#else
+    (void)ctx;
+#endif
+    return 1;
+}
+
+// 사용자 전부 제거 (공유 사용자 표는 처음 채울 때만)
+static void userTableClear(GameContext* ctx) {
+    if (ctx->shared.users != NULL) atomic_store(ctx->shared.count, 0);
+    else segClear(&ctx->users);
+}
+
+// 로드 중 공유 사용자 표가 가득 참: 일부만 올린 채 계속하면 users.txt를 다시 쓸 때 사용자를 잃으므로 종료
+static void sharedUsersFull(GameContext* ctx) {
+    fprintf(stderr, "공유 사용자 표가 가득 찼습니다 (최대 %d명).\n", ctx->shared.capacity);
+#ifdef __linux__
+    shm_unlink(ctx->shared.name); // 채우다 만 표는 다음 프로세스가 새로 만듦
+#endif
+    exit(1);
+}
+
+// userAppendLock 잠금 (공유 사용자 표에서 가입 도중 죽은 프로세스가 있으면 등록을 마치지 못한 사용자를 버림)
+static void lockUserAppend(GameContext* ctx) {
+    if (!gameLock(&ctx->userAppendLock)) return;
+    int registered = *ctx->shared.rankCount;
+    if (atomic_load(ctx->shared.count) > registered) atomic_store(ctx->shared.count, registered);
+    if (registered > 0) userAt(ctx, registered - 1)->dirty = 1; // 행을 제출하기 전에 죽었을 수 있음
+    gameLog(ctx, "공유 사용자 표 복구: 사용자 %d명\n", registered);
+}
+
+// 기록 목록을 count개까지 늘림 (로드 중이나 userAppendLock 안에서 호출)
+static void recordListsGrow(GameContext* ctx, int count) {
+    while (ctx->userRecordLists.count < count) segPush(&ctx->userRecordLists); // 빈 기록 목록
+}
+
+// 공유 사용자 표에서는 다른 프로세스가 추가한 사용자의 기록 목록이 아직 없을 수 있으므로 처음 쓸 때 만듦
+static RecordList* recordListAt(GameContext* ctx, int userIdx) {
+    if (userIdx >= ctx->userRecordLists.count) {
+        lockUserAppend(ctx);
+        recordListsGrow(ctx, userIdx + 1);
+        gameUnlock(&ctx->userAppendLock);
+    }
+    return (RecordList*)segAt(&ctx->userRecordLists, userIdx);
+}
+
+// 샤드의 변경 목록에 사용자 추가 (샤드 잠금 안에서 호출)
+static void shardDirtyPush(UserShard* shard, int userIdx) {
+    if (shard->numDirtyUsers == shard->dirtyUsersCapacity) {
+        int newCapacity = shard->dirtyUsersCapacity ? shard->dirtyUsersCapacity * 2 : 16;
+        int* newList = realloc(shard->dirtyUsers, sizeof(int) * newCapacity);
+        if (newList == NULL) outOfMemory();
+        shard->dirtyUsers = newList;
+        shard->dirtyUsersCapacity = newCapacity;
+    }
+    shard->dirtyUsers[shard->numDirtyUsers++] = userIdx;
+}
+
+// 사용자 정보가 바뀌었음을 표시 (다음 saveShardUsers()에서 해당 행만 기록, 샤드 잠금 안에서 호출)
+static void markUserDirty(GameContext* ctx, UserShard* shard, int userIdx) {
+    User* u = userAt(ctx, userIdx);
+    if (u->dirty) return;
+    u->dirty = 1;
+    shardDirtyPush(shard, userIdx);
+}
+
+
+// --- 해시 함수 ---
+
+// 문자열 해시 (FNV-1a)
+static unsigned int hashString(const char* str) {
+    unsigned int h = 2166136261u;
+    while (*str) {
+        h ^= (unsigned char)*str++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 정수 해시 (곱셈 해시)
+static unsigned int hashInt(int key) {
+    return (unsigned int)key * 2654435761u;
+}
+
+// ID가 속한 샤드 (해시 상위 비트 사용, 하위 비트는 샤드 안의 인덱스 슬롯 위치에 사용)
+static UserShard* shardForId(GameContext* ctx, const char* id) {
+    return &ctx->userShards[hashString(id) >> (32 - USER_SHARD_BITS)];
+}
+
+static UserShard* userShard(GameContext* ctx, int userIdx) {
+    return shardForId(ctx, userAt(ctx, userIdx)->id);
+}
+
+
+// --- 코인 리더보드 함수 ---
+// 코인이 바뀔 때마다 해당 사용자 노드만 빼고 다시 넣으므로
+// 순위/상위 N명 조회 모두 O(log n)이며 사용자 테이블을 복사하거나 정렬하지 않음.
+// 누적 코인과 기간별 코인 리더보드가 같은 함수를 쓴다 (잠금은 호출자가).
+
+static RankNode* rankNodeAt(Leaderboard* board, int i) {
+    return board->sharedNodes != NULL ? &board->sharedNodes[i] : (RankNode*)segAt(&board->nodes, i);
+}
+
+static int* rankRoot(Leaderboard* board) { return board->sharedRoot != NULL ? board->sharedRoot : &board->root; }
+
+static int rankSize(Leaderboard* board, int node) { return node < 0 ? 0 : rankNodeAt(board, node)->size; }
+
+static void rankUpdateSize(Leaderboard* board, int node) {
+    RankNode* n = rankNodeAt(board, node);
+    n->size = 1 + rankSize(board, n->left) + rankSize(board, n->right);
+}
+
+// a가 b보다 앞 순위인지 (노드에 넣어 둔 코인 기준)
+static int rankBefore(Leaderboard* board, int a, int b) {
+    int coinsA = rankNodeAt(board, a)->coins, coinsB = rankNodeAt(board, b)->coins;
+    if (coinsA != coinsB) return coinsA > coinsB;
+    return a < b;
+}
+
+// node 트리를 key보다 앞 순위인 노드들(*left)과 나머지(*right)로 분리
+static void rankSplit(Leaderboard* board, int node, int key, int* left, int* right) {
+    if (node < 0) {
+        *left = *right = -1;
+        return;
+    }
+    RankNode* n = rankNodeAt(board, node);
+    if (rankBefore(board, node, key)) {
+        rankSplit(board, n->right, key, &n->right, right);
+        *left = node;
+    } else {
+        rankSplit(board, n->left, key, left, &n->left);
+        *right = node;
+    }
+    rankUpdateSize(board, node);
+}
+
+// left의 모든 노드가 right보다 앞 순위일 때 두 트리 합치기
+static int rankMerge(Leaderboard* board, int left, int right) {
+    if (left < 0) return right;
+    if (right < 0) return left;
+    RankNode* l = rankNodeAt(board, left);
+    RankNode* r = rankNodeAt(board, right);
+    if (l->priority > r->priority) {
+        l->right = rankMerge(board, l->right, right);
+        rankUpdateSize(board, left);
+        return left;
+    }
+    r->left = rankMerge(board, left, r->left);
+    rankUpdateSize(board, right);
+    return right;
+}
+
+// userIdx 사용자를 coins 기준 위치에 삽입
+static void leaderboardInsert(Leaderboard* board, int userIdx, int coins) {
+    if (board->sharedNodes == NULL) { // 공유 노드 배열은 사용자 수만큼 미리 있음
+        while (board->nodes.count <= userIdx) segPush(&board->nodes);
+    }
+    RankNode* n = rankNodeAt(board, userIdx);
+    n->left = n->right = -1;
+    n->size = 1;
+    n->coins = coins;
+    n->priority = hashInt(userIdx) ^ 0x9e3779b9u;
+    int left, right;
+    rankSplit(board, *rankRoot(board), userIdx, &left, &right);
+    *rankRoot(board) = rankMerge(board, rankMerge(board, left, userIdx), right);
+}
+
+// node 트리에서 userIdx 사용자 제거
+static int rankErase(Leaderboard* board, int node, int userIdx) {
+    if (node < 0) return -1;
+    RankNode* n = rankNodeAt(board, node);
+    if (node == userIdx) return rankMerge(board, n->left, n->right);
+    if (rankBefore(board, userIdx, node)) n->left = rankErase(board, n->left, userIdx);
+    else n->right = rankErase(board, n->right, userIdx);
+    rankUpdateSize(board, node);
+    return node;
+}
+
+static void leaderboardRemove(Leaderboard* board, int userIdx) {
+    *rankRoot(board) = rankErase(board, *rankRoot(board), userIdx);
+}
+
+static void leaderboardClear(Leaderboard* board) {
+    segClear(&board->nodes);
+    *rankRoot(board) = -1;
+}
+
+// 기간별 리더보드와 사용자별 날짜 버킷 모두 비우기
+static void windowBoardsClear(GameContext* ctx) {
+    for (int k = 0; k < RANK_WINDOW_COUNT; k++) leaderboardClear(&ctx->windowBoards[k]);
+    segClear(&ctx->userWindows);
+    ctx->windowDay = DAY_NONE;
+}
+
+// 누적 코인 리더보드 잠금 (공유 사용자 표에서 트립을 고치던 프로세스가 죽었으면 등록된 사용자로 다시 만듦)
+static void lockRankBoard(GameContext* ctx) {
+    if (!gameLock(&ctx->rankLock)) return;
+    int count = *ctx->shared.rankCount;
+    *rankRoot(&ctx->rankBoard) = -1;
+    for (int i = 0; i < count; i++) {
+        leaderboardInsert(&ctx->rankBoard, i, atomic_load(&userAt(ctx, i)->coins));
+    }
+    gameLog(ctx, "공유 코인 리더보드 복구: %d명\n", count);
+}
+
+// 사용자 코인 변경 (리더보드 위치도 함께 갱신, 파일 저장은 호출자가 markUserDirty로)
+// 코인은 원자적으로 먼저 더하고, 리더보드는 잠금 안에서 그 시점의 코인으로 다시 넣는다.
+// 같은 사용자의 변경이 동시에 일어나도 나중에 다시 넣는 쪽이 최종 코인을 반영한다.
+static void addUserCoins(GameContext* ctx, int userIdx, int delta) {
+    if (delta == 0) return;
+    atomic_fetch_add(&userAt(ctx, userIdx)->coins, delta);
+    lockRankBoard(ctx);
+    leaderboardRemove(&ctx->rankBoard, userIdx);
+    leaderboardInsert(&ctx->rankBoard, userIdx, atomic_load(&userAt(ctx, userIdx)->coins));
+    gameUnlock(&ctx->rankLock);
+}
+
+// 0부터 시작하는 순위 (앞 순위 사용자 수, 트리에 없으면 -1)
+static int leaderboardRank(Leaderboard* board, int userIdx) {
+    int rank = 0;
+    int node = *rankRoot(board);
+    while (node >= 0) {
+        RankNode* n = rankNodeAt(board, node);
+        if (node == userIdx) return rank + rankSize(board, n->left);
+        if (rankBefore(board, userIdx, node)) {
+            node = n->left;
+        } else {
+            rank += rankSize(board, n->left) + 1;
+            node = n->right;
+        }
+    }
+    return -1;
+}
+
+// k번째(0부터) 순위의 사용자 인덱스 (없으면 -1)
+static int leaderboardAt(Leaderboard* board, int k) {
+    int node = *rankRoot(board);
+    while (node >= 0) {
+        RankNode* n = rankNodeAt(board, node);
+        int leftSize = rankSize(board, n->left);
+        if (k < leftSize) {
+            node = n->left;
+        } else if (k == leftSize) {
+            return node;
+        } else {
+            k -= leftSize + 1;
+            node = n->right;
+        }
+    }
+    return -1;
+}
+
+
+// --- 사용자 ID 인덱스 함수 ---
+
+// 사용자 ID 인덱스는 샤드마다 하나씩이며 샤드 잠금으로 보호된다 (로드 중에는 잠금 없이 사용).
+
+// 슬롯 배열에 사용자 인덱스 삽입 (중복 검사 없음)
+static void userIndexPlace(GameContext* ctx, int* slots, int capacity, int userIdx) {
+    unsigned int pos = hashString(userAt(ctx, userIdx)->id) & (capacity - 1);
+    while (slots[pos] != 0) {
+        pos = (pos + 1) & (capacity - 1);
+    }
+    slots[pos] = userIdx + 1;
+}
+
+// 공유 사용자 표의 ID 해시 (모든 샤드가 슬롯 배열 하나를 함께 쓰므로 슬롯은 원자적으로 읽고 씀)
+// 슬롯은 사용자 행을 다 채운 뒤에 공개하고 지우지 않으므로 다른 샤드의 행을 읽어도 안전하다.
+static int sharedIndexFind(GameContext* ctx, const char* id) {
+    unsigned int mask = (unsigned int)ctx->shared.indexCapacity - 1;
+    unsigned int pos = hashString(id) & mask;
+    int slot;
+    while ((slot = atomic_load_explicit(&ctx->shared.index[pos], memory_order_acquire)) != 0) {
+        if (strcmp(userAt(ctx, slot - 1)->id, id) == 0) return slot - 1;
+        pos = (pos + 1) & mask;
+    }
+    return -1;
+}
+
+static void sharedIndexAdd(GameContext* ctx, int userIdx) {
+    unsigned int mask = (unsigned int)ctx->shared.indexCapacity - 1;
+    unsigned int pos = hashString(userAt(ctx, userIdx)->id) & mask;
+    int empty = 0;
+    // 같은 칸을 다른 샤드의 가입이 동시에 차지할 수 있으므로 빈 칸은 CAS로 가져감
+    while (!atomic_compare_exchange_strong(&ctx->shared.index[pos], &empty, userIdx + 1)) {
+        empty = 0;
+        pos = (pos + 1) & mask;
+    }
+}
+
+// ID로 사용자 인덱스 검색 (없으면 -1, ID가 속한 샤드의 잠금 안에서 호출)
+static int findUserIndex(GameContext* ctx, const char* id) {
+    if (ctx->shared.index != NULL) return sharedIndexFind(ctx, id);
+    const UserIndex* index = &shardForId(ctx, id)->index;
+    if (index->size == 0) return -1;
+    unsigned int pos = hashString(id) & (index->capacity - 1);
+    while (index->slots[pos] != 0) {
+        int idx = index->slots[pos] - 1;
+        if (strcmp(userAt(ctx, idx)->id, id) == 0) return idx;
+        pos = (pos + 1) & (index->capacity - 1);
+    }
+    return -1;
+}
+
+// users 배열의 userIdx번째 사용자를 샤드 인덱스에 등록 (부하율 1/2 넘으면 두 배로 재해시)
+static void userIndexAdd(GameContext* ctx, UserIndex* index, int userIdx) {
+    if (ctx->shared.index != NULL) {
+        sharedIndexAdd(ctx, userIdx);
+        return;
+    }
+    if ((index->size + 1) * 2 > index->capacity) {
+        int newCapacity = index->capacity ? index->capacity * 2 : USER_INDEX_MIN_CAPACITY;
+        int* newSlots = calloc(newCapacity, sizeof(int));
+        if (newSlots == NULL) outOfMemory();
+        for (int i = 0; i < index->capacity; i++) {
+            if (index->slots[i] != 0) {
+                userIndexPlace(ctx, newSlots, newCapacity, index->slots[i] - 1);
+            }
+        }
+        free(index->slots);
+        index->slots = newSlots;
+        index->capacity = newCapacity;
+    }
+    userIndexPlace(ctx, index->slots, index->capacity, userIdx);
+    index->size++;
+}
+
+// 새 사용자(users 배열 마지막 원소)를 ID 인덱스, 기록 목록, 리더보드에 등록
+// (회원가입에서는 샤드 잠금과 userAppendLock 안에서 호출)
+static void registerNewUser(GameContext* ctx) {
+    int userIdx = userCount(ctx) - 1;
+    userIndexAdd(ctx, &userShard(ctx, userIdx)->index, userIdx);
+    recordListsGrow(ctx, userIdx + 1); // 공유 사용자 표에서는 다른 프로세스가 추가한 사용자 몫도 함께
+    lockRankBoard(ctx);
+    leaderboardInsert(&ctx->rankBoard, userIdx, atomic_load(&userAt(ctx, userIdx)->coins));
+    if (ctx->shared.rankCount != NULL) *ctx->shared.rankCount = userIdx + 1;
+    gameUnlock(&ctx->rankLock);
+}
+
+// 인덱스 비우기
+static void userIndexClear(GameContext* ctx) {
+    for (int i = 0; i < ctx->userRecordLists.count; i++) {
+        free(recordListAt(ctx, i)->items);
+    }
+    segClear(&ctx->userRecordLists);
+    leaderboardClear(&ctx->rankBoard);
+    windowBoardsClear(ctx);
+    if (ctx->shared.index != NULL) { // 공유 사용자 표를 처음 채울 때만 (다른 프로세스가 아직 붙지 않음)
+        memset(ctx->shared.index, 0, sizeof(atomic_int) * ctx->shared.indexCapacity);
+        *ctx->shared.rankCount = 0;
+    }
+    for (int i = 0; i < USER_SHARD_COUNT; i++) {
+        UserShard* shard = &ctx->userShards[i];
+        free(shard->index.slots);
+        shard->index.slots = NULL;
+        shard->index.capacity = 0;
+        shard->index.size = 0;
+        shard->numDirtyUsers = 0;
+    }
+}
+
+
+// --- 기록 열 저장소 함수 ---
+
+static RecordBlock* recordBlock(const RecordStore* store, int row) {
+    return (RecordBlock*)segAt(&store->blocks, row >> RECORD_BLOCK_SHIFT);
+}
+
+static int recordSlot(int row) {
+    return row & (RECORD_BLOCK_ROWS - 1);
+}
+
+static const char* recordInterned(const RecordStore* store, int idx) {
+    return *(const char**)segAt(&store->interned, idx);
+}
+
+// 공유 문자열 등록 (이미 있으면 그 인덱스, 부하율 1/2 넘으면 두 배로 재해시)
+static int recordIntern(RecordStore* store, const char* str) {
+    if ((store->interned.count + 1) * 2 > store->internCapacity) {
+        int newCapacity = store->internCapacity ? store->internCapacity * 2 : RECORD_INTERN_MIN_CAPACITY;
+        int* newSlots = calloc(newCapacity, sizeof(int));
+        if (newSlots == NULL) outOfMemory();
+        for (int i = 0; i < store->internCapacity; i++) {
+            if (store->internSlots[i] == 0) continue;
+            unsigned int pos = hashString(recordInterned(store, store->internSlots[i] - 1)) & (newCapacity - 1);
+            while (newSlots[pos] != 0) pos = (pos + 1) & (newCapacity - 1);
+            newSlots[pos] = store->internSlots[i];
+        }
+        free(store->internSlots);
+        store->internSlots = newSlots;
+        store->internCapacity = newCapacity;
+    }
+    unsigned int pos = hashString(str) & (store->internCapacity - 1);
+    while (store->internSlots[pos] != 0) {
+        int idx = store->internSlots[pos] - 1;
+        if (strcmp(recordInterned(store, idx), str) == 0) return idx;
+        pos = (pos + 1) & (store->internCapacity - 1);
+    }
+    int idx = store->interned.count;
+    *(const char**)segPush(&store->interned) = arenaCopyString(&store->strings, str, MAX_ANSWER_LEN - 1);
+    store->internSlots[pos] = idx + 1;
+    return idx;
+}
+
+// 공유 문자열 찾기 (없으면 -1, 등록하지 않음)
+static int recordInternFind(const RecordStore* store, const char* str) {
+    if (store->internCapacity == 0) return -1;
+    unsigned int pos = hashString(str) & (store->internCapacity - 1);
+    while (store->internSlots[pos] != 0) {
+        int idx = store->internSlots[pos] - 1;
+        if (strcmp(recordInterned(store, idx), str) == 0) return idx;
+        pos = (pos + 1) & (store->internCapacity - 1);
+    }
+    return -1;
+}
+
+// 기록 한 행 추가 (userRef: users 인덱스, 음수면 rec->userId로 찾아 없으면 공유 문자열로 보관)
+// 로드 중이거나 recordsLock 안에서 호출하며 새 행 번호를 반환
+static int recordPush(GameContext* ctx, const RecordFields* rec, int userRef) {
+    RecordStore* store = &ctx->records;
+    if (userRef < 0) userRef = findUserIndex(ctx, rec->userId);
+    if (userRef < 0) userRef = -(recordIntern(store, rec->userId) + 1);
+    int row = atomic_load_explicit(&store->count, memory_order_relaxed);
+    if (recordSlot(row) == 0) segPush(&store->blocks);
+    RecordBlock* block = recordBlock(store, row);
+    int slot = recordSlot(row);
+    block->user[slot] = userRef;
+    block->day[slot] = rec->day;
+    block->contentId[slot] = rec->contentId;
+    block->coinsEarned[slot] = rec->coinsEarned;
+    block->type[slot] = (uint8_t)rec->type;
+    // Dare 결과("Complete"/"Fail")는 몇 가지뿐이므로 공유하고, Truth 답변만 힙에 복사
+    block->response[slot] = rec->type == 1 ? recordInterned(store, recordIntern(store, rec->response))
+                                           : arenaCopyString(&store->strings, rec->response, MAX_ANSWER_LEN - 1);
+    atomic_store_explicit(&store->count, row + 1, memory_order_release);
+    return row;
+}
+
+// 행 번호의 기록 값 (문자열은 저장소를 가리킴)
+static void recordFieldsAt(GameContext* ctx, int row, RecordFields* out) {
+    const RecordBlock* block = recordBlock(&ctx->records, row);
+    int slot = recordSlot(row);
+    int user = block->user[slot];
+    out->userId = user >= 0 ? userAt(ctx, user)->id : recordInterned(&ctx->records, -user - 1);
+    out->day = block->day[slot];
+    out->type = block->type[slot];
+    out->contentId = block->contentId[slot];
+    out->coinsEarned = block->coinsEarned[slot];
+    out->response = block->response[slot];
+}
+
+static int recordCount(const RecordStore* store) {
+    return atomic_load_explicit(&store->count, memory_order_acquire);
+}
+
+// 저장소가 잡아 둔 메모리 (바이트)
+static size_t recordStoreBytes(const RecordStore* store) {
+    return store->blocks.arena.totalBytes + store->interned.arena.totalBytes + store->strings.totalBytes +
+           sizeof(int) * (size_t)store->internCapacity;
+}
+
+// 모든 기록 제거 및 메모리 반환
+static void recordStoreClear(RecordStore* store) {
+    segClear(&store->blocks);
+    segClear(&store->interned);
+    arenaFree(&store->strings);
+    free(store->internSlots);
+    store->internSlots = NULL;
+    store->internCapacity = 0;
+    atomic_store(&store->count, 0);
+}
+
+
+// --- 기간별 코인 순위 함수 ---
+// Dare 코인은 사용자별 날짜 버킷 링에 더하고, 기간 합계가 바뀐 사용자만 기간 리더보드에서 빼고 다시 넣는다.
+// 날짜가 바뀌면 월간 리더보드에 있는 사용자(최근 30일 안에 코인을 얻은 사용자)만 합계를 다시 계산해
+// 기간을 벗어난 버킷을 뺀다. 조회할 때 기록을 다시 훑지 않는다.
+
+static const int rankWindowDays[RANK_WINDOW_COUNT] = { 1, 7, 30 };
+
+// 사용자의 날짜 버킷 (없으면 users 인덱스까지 늘림, windowLock 안에서 호출)
+static UserWindow* userWindowAt(GameContext* ctx, int userIdx) {
+    while (ctx->userWindows.count <= userIdx) {
+        UserWindow* w = segPush(&ctx->userWindows);
+        w->lastDay = DAY_NONE;
+    }
+    return (UserWindow*)segAt(&ctx->userWindows, userIdx);
+}
+
+// day 버킷에 코인 추가 (링에서 밀려난 날짜의 버킷은 비우고, 링보다 오래된 날짜는 무시)
+static void userWindowPut(UserWindow* w, int day, int coins) {
+    if (w->lastDay == DAY_NONE || day > w->lastDay) {
+        int from = w->lastDay == DAY_NONE || day - w->lastDay >= WINDOW_RING_DAYS ? day - WINDOW_RING_DAYS + 1
+                                                                                  : w->lastDay + 1;
+        for (int d = from; d <= day; d++) w->buckets[d & (WINDOW_RING_DAYS - 1)] = 0;
+        w->lastDay = day;
+    } else if (day <= w->lastDay - WINDOW_RING_DAYS) {
+        return;
+    }
+    w->buckets[day & (WINDOW_RING_DAYS - 1)] += coins;
+}
+
+// today까지 최근 days일 동안의 코인 합계
+static int userWindowSum(const UserWindow* w, int today, int days) {
+    if (w->lastDay == DAY_NONE) return 0;
+    int first = today - days + 1, last = today < w->lastDay ? today : w->lastDay;
+    if (first <= w->lastDay - WINDOW_RING_DAYS) first = w->lastDay - WINDOW_RING_DAYS + 1;
+    int sum = 0;
+    for (int d = first; d <= last; d++) sum += w->buckets[d & (WINDOW_RING_DAYS - 1)];
+    return sum;
+}
+
+// 사용자의 기간 합계를 windowDay 기준으로 다시 계산하고 합계가 바뀐 리더보드만 갱신
+static void windowRefreshUser(GameContext* ctx, int userIdx) {
+    UserWindow* w = userWindowAt(ctx, userIdx);
+    for (int k = 0; k < RANK_WINDOW_COUNT; k++) {
+        int sum = userWindowSum(w, ctx->windowDay, rankWindowDays[k]);
+        if (sum == w->windowCoins[k]) continue;
+        if (w->windowCoins[k] != 0) leaderboardRemove(&ctx->windowBoards[k], userIdx);
+        if (sum != 0) leaderboardInsert(&ctx->windowBoards[k], userIdx, sum);
+        w->windowCoins[k] = sum;
+    }
+}
+
+// 기준 날짜를 오늘로 옮기고 기간을 벗어난 버킷을 합계에서 뺌 (windowLock 안에서 호출)
+static void windowSyncDay(GameContext* ctx) {
+    int today = gameToday(ctx);
+    if (today == ctx->windowDay) return;
+    int backwards = ctx->windowDay != DAY_NONE && today < ctx->windowDay;
+    ctx->windowDay = today;
+    if (backwards) { // 시계가 거꾸로 가면 30일 밖이던 코인이 다시 들어올 수 있으므로 모두 다시 계산
+        for (int i = 0; i < ctx->userWindows.count; i++) windowRefreshUser(ctx, i);
+        return;
+    }
+    // 일간/주간 리더보드의 사용자는 모두 월간 리더보드에도 있음 (코인은 음수가 아님)
+    Leaderboard* monthly = &ctx->windowBoards[RANK_MONTHLY];
+    int count = rankSize(monthly, monthly->root);
+    int* active = malloc(sizeof(int) * (count + 1));
+    if (active == NULL) outOfMemory();
+    for (int k = 0; k < count; k++) active[k] = leaderboardAt(monthly, k);
+    for (int k = 0; k < count; k++) windowRefreshUser(ctx, active[k]);
+    free(active);
+}
+
+// Dare 코인을 기간 순위에 반영 (기록을 추가할 때 사용자 샤드 잠금 안에서 호출)
+static void windowAddCoins(GameContext* ctx, int userIdx, int day, int coins) {
+    if (coins == 0) return;
+    gameLock(&ctx->windowLock);
+    windowSyncDay(ctx);
+    userWindowPut(userWindowAt(ctx, userIdx), day, coins);
+    windowRefreshUser(ctx, userIdx);
+    gameUnlock(&ctx->windowLock);
+}
+
+// 로드한 기록 중 최근 30일의 Dare 코인으로 기간 리더보드 구성 (로드 중에 호출)
+static void rebuildWindowBoards(GameContext* ctx) {
+    windowBoardsClear(ctx);
+    ctx->windowDay = gameToday(ctx);
+    int firstDay = ctx->windowDay - rankWindowDays[RANK_MONTHLY] + 1;
+    int rows = recordCount(&ctx->records);
+    for (int b = 0; b << RECORD_BLOCK_SHIFT < rows; b++) {
+        const RecordBlock* block = recordBlock(&ctx->records, b << RECORD_BLOCK_SHIFT);
+        int n = rows - (b << RECORD_BLOCK_SHIFT);
+        if (n > RECORD_BLOCK_ROWS) n = RECORD_BLOCK_ROWS;
+        for (int i = 0; i < n; i++) {
+            if (block->coinsEarned[i] == 0 || block->user[i] < 0) continue;
+            if (block->day[i] < firstDay || block->day[i] > ctx->windowDay) continue;
+            userWindowPut(userWindowAt(ctx, block->user[i]), block->day[i], block->coinsEarned[i]);
+        }
+    }
+    for (int i = 0; i < ctx->userWindows.count; i++) windowRefreshUser(ctx, i);
+}
+
+
+// --- 파일 매핑과 문자열 풀 ---
+
+// 파일 크기와 수정 시각 (파일이 없으면 크기 -1)
+static void getFileSignature(const char* path, int64_t* size, int64_t* mtime) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        *size = -1;
+        *mtime = 0;
+        return;
+    }
+    *size = (int64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+}
+
+// 파일 전체를 읽기 전용으로 매핑 (실패 시 NULL)
+static const char* mapFile(const char* path, size_t* size, int* mapped) {
+#ifdef _WIN32
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* data = len > 0 ? malloc(len) : NULL;
+    if (data == NULL || fread(data, 1, len, fp) != (size_t)len) {
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *size = (size_t)len;
+    *mapped = 0;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    *size = (size_t)st.st_size;
+    *mapped = 1;
+    return data;
+#endif
+}
+
+static void unmapFile(const char* data, size_t size, int mapped) {
+    if (data == NULL) return;
+#ifdef _WIN32
+    (void)size;
+    (void)mapped;
+    free((void*)data);
+#else
+    if (mapped) munmap((void*)data, size);
+    else free((void*)data);
+#endif
+}
+
+static void* snapGrow(void* ptr, size_t size) {
+    void* p = realloc(ptr, size);
+    if (p == NULL) outOfMemory();
+    return p;
+}
+
+// 파일에서 한 줄 읽기 (길이 제한 없음, 버퍼는 필요하면 늘림, 끝의 \r\n은 지움, 파일 끝이면 0)
+static int readContentLine(FILE* fp, char** buf, size_t* capacity) {
+    size_t len = 0;
+    for (;;) {
+        if (*capacity - len < 2) {
+            *capacity = *capacity ? *capacity * 2 : 256;
+            *buf = snapGrow(*buf, *capacity);
+        }
+        if (fgets(*buf + len, (int)(*capacity - len), fp) == NULL) {
+            if (len == 0) return 0;
+            break;
+        }
+        len += strlen(*buf + len);
+        if ((*buf)[len - 1] == '\n') break;
+    }
+    while (len > 0 && ((*buf)[len - 1] == '\n' || (*buf)[len - 1] == '\r')) len--;
+    (*buf)[len] = '\0';
+    return 1;
+}
+
+// 풀에 있는 문자열의 오프셋 + 1 (없으면 0)
+static uint32_t poolFind(const StringPoolBuilder* pool, const char* str) {
+    if (pool->slotCapacity == 0) return 0;
+    size_t pos = hashString(str) & (pool->slotCapacity - 1);
+    while (pool->slots[pos] != 0) {
+        if (strcmp(pool->data + pool->slots[pos] - 1, str) == 0) return pool->slots[pos];
+        pos = (pos + 1) & (pool->slotCapacity - 1);
+    }
+    return 0;
+}
+
+// 문자열을 풀에 넣고 오프셋 반환
+static uint32_t poolIntern(StringPoolBuilder* pool, const char* str) {
+    if ((pool->count + 1) * 2 > pool->slotCapacity) {
+        size_t newCapacity = pool->slotCapacity ? pool->slotCapacity * 2 : 1024;
+        uint32_t* newSlots = calloc(newCapacity, sizeof(uint32_t));
+        if (newSlots == NULL) outOfMemory();
+        for (size_t i = 0; i < pool->slotCapacity; i++) {
+            if (pool->slots[i] == 0) continue;
+            size_t pos = hashString(pool->data + pool->slots[i] - 1) & (newCapacity - 1);
+            while (newSlots[pos] != 0) pos = (pos + 1) & (newCapacity - 1);
+            newSlots[pos] = pool->slots[i];
+        }
+        free(pool->slots);
+        pool->slots = newSlots;
+        pool->slotCapacity = newCapacity;
+    }
+    size_t pos = hashString(str) & (pool->slotCapacity - 1);
+    while (pool->slots[pos] != 0) {
+        if (strcmp(pool->data + pool->slots[pos] - 1, str) == 0) return pool->slots[pos] - 1;
+        pos = (pos + 1) & (pool->slotCapacity - 1);
+    }
+    size_t len = strlen(str) + 1;
+    if (pool->size + len > pool->capacity) {
+        pool->capacity = (pool->size + len) * 2;
+        pool->data = snapGrow(pool->data, pool->capacity);
+    }
+    uint32_t offset = (uint32_t)pool->size;
+    memcpy(pool->data + pool->size, str, len);
+    pool->size += len;
+    pool->slots[pos] = offset + 1;
+    pool->count++;
+    return offset;
+}
+
+
+// --- 콘텐츠 카탈로그 ---
+// 질문/도전은 파일 하나짜리 카탈로그 이미지로 보관한다: ID순 행 배열 + 카테고리별 도전 행 번호 + 문자열 풀.
+// 카탈로그 파일(content.cat)은 buildContentCatalog로 미리 만들어 두고 시작 시 매핑만 하므로,
+// 질문이 수십만 개여도 조회/무작위 선택은 행 하나와 문자열 하나가 있는 페이지만 읽는다.
+// 텍스트/스냅샷에서 읽을 때도 같은 형식의 이미지를 메모리에 만들어 조회 경로는 하나다.
+
+static void contentBuilderInit(ContentBuilder* b) {
+    memset(b, 0, sizeof(*b));
+    poolIntern(&b->pool, ""); // 오프셋 0은 빈 문자열
+}
+
+static void contentBuilderFree(ContentBuilder* b) {
+    free(b->truth);
+    free(b->dare);
+    free(b->pool.data);
+    free(b->pool.slots);
+    memset(b, 0, sizeof(*b));
+}
+
+static void contentAddTruth(ContentBuilder* b, int id, const char* question) {
+    if (b->truthCount == b->truthCapacity) {
+        b->truthCapacity = b->truthCapacity ? b->truthCapacity * 2 : 64;
+        b->truth = snapGrow(b->truth, sizeof(ContentEntry) * b->truthCapacity);
+    }
+    ContentEntry* e = &b->truth[b->truthCount];
+    e->id = id;
+    e->order = (uint32_t)b->truthCount++;
+    e->textOff = poolIntern(&b->pool, question);
+    e->categoryOff = 0;
+    e->weight = 0;
+}
+
+// 가중치는 1~MAX_DARE_WEIGHT로 맞춤
+static void contentAddDare(ContentBuilder* b, int id, const char* category, const char* challenge, int weight) {
+    if (b->dareCount == b->dareCapacity) {
+        b->dareCapacity = b->dareCapacity ? b->dareCapacity * 2 : 64;
+        b->dare = snapGrow(b->dare, sizeof(ContentEntry) * b->dareCapacity);
+    }
+    ContentEntry* e = &b->dare[b->dareCount];
+    e->id = id;
+    e->order = (uint32_t)b->dareCount++;
+    e->textOff = poolIntern(&b->pool, challenge);
+    e->categoryOff = poolIntern(&b->pool, category);
+    e->weight = (uint32_t)(weight < 1 ? 1 : weight > MAX_DARE_WEIGHT ? MAX_DARE_WEIGHT : weight);
+}
+
+// 풀 오프셋 → 문자열 (범위를 벗어나면 빈 문자열)
+static const char* contentString(const ContentTable* table, uint32_t offset) {
+    return offset < table->stringsSize ? table->strings + offset : "";
+}
+
+static TruthQuestion truthAt(const ContentTable* table, int i) {
+    const SnapTruthRow* row = &table->truthRows[i];
+    return (TruthQuestion){ row->id, contentString(table, row->questionOff) };
+}
+
+static DareChallenge dareAt(const ContentTable* table, int i) {
+    const SnapDareRow* row = &table->dareRows[i];
+    return (DareChallenge){ row->id, contentString(table, row->categoryOff), contentString(table, row->challengeOff), (int)row->weight };
+}
+
+// ID순 행 배열에서 이진 검색 (없으면 -1)
+static int findTruthRow(const ContentTable* table, int id) {
+    int lo = 0, hi = table->truthCount;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (table->truthRows[mid].id < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < table->truthCount && table->truthRows[lo].id == id ? lo : -1;
+}
+
+static int findDareRow(const ContentTable* table, int id) {
+    int lo = 0, hi = table->dareCount;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (table->dareRows[mid].id < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < table->dareCount && table->dareRows[lo].id == id ? lo : -1;
+}
+
+// 도전 행의 카테고리 번호 (카테고리 표는 이름 오프셋순이므로 이진 검색, 없으면 -1)
+static int findDareRowCategory(const ContentTable* table, int row) {
+    uint32_t nameOff = table->dareRows[row].categoryOff;
+    int lo = 0, hi = table->categoryCount;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (table->categories[mid].nameOff < nameOff) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < table->categoryCount && table->categories[lo].nameOff == nameOff ? lo : -1;
+}
+
+// 카테고리 이름 → 카테고리 번호 (없으면 -1, 판을 만들 때만 쓰며 카테고리 수는 적으므로 차례로 비교)
+static int findDareCategory(const ContentTable* table, const char* name) {
+    for (int k = 0; k < table->categoryCount; k++) {
+        if (strcmp(contentString(table, table->categories[k].nameOff), name) == 0) return k;
+    }
+    return -1;
+}
+
+// ID순, 같은 ID는 추가된 순서
+static int compareContentEntry(const void* a, const void* b) {
+    const ContentEntry* x = a;
+    const ContentEntry* y = b;
+    if (x->id != y->id) return x->id < y->id ? -1 : 1;
+    return x->order < y->order ? -1 : x->order > y->order;
+}
+
+static int compareU64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// 정렬한 뒤 같은 ID는 먼저 추가된 항목만 남김 (남은 개수 반환)
+static int sortContentEntries(ContentEntry* entries, int count) {
+    if (count == 0) return 0;
+    qsort(entries, count, sizeof(ContentEntry), compareContentEntry);
+    int n = 1;
+    for (int i = 1; i < count; i++) {
+        if (entries[i].id != entries[n - 1].id) entries[n++] = entries[i];
+    }
+    return n;
+}
+
+// 카테고리 하나의 별칭 표 만들기 (Vose): 칸마다 가중치 × 칸 수를 두고, 평균(가중치 합)보다 작은 칸의 모자란 몫을
+// 큰 칸에서 채워 주며 그 큰 칸을 별칭으로 적는다. 정수로 계산하므로 칸마다 확률이 정확히 가중치에 비례한다.
+// scaled/stack은 count개 이상의 작업 공간 (stack 앞쪽은 작은 칸, 뒤쪽은 큰 칸)
+static void buildDareAlias(const SnapDareRow* rows, const uint32_t* order, uint32_t count, CatalogAlias* out,
+                           uint64_t* scaled, uint32_t* stack) {
+    uint64_t total = 0;
+    for (uint32_t j = 0; j < count; j++) total += rows[order[j]].weight;
+    uint32_t numSmall = 0, firstLarge = count;
+    for (uint32_t j = 0; j < count; j++) {
+        scaled[j] = (uint64_t)rows[order[j]].weight * count;
+        if (scaled[j] < total) stack[numSmall++] = j;
+        else stack[--firstLarge] = j;
+    }
+    while (numSmall > 0 && firstLarge < count) {
+        uint32_t small = stack[--numSmall];
+        uint32_t large = stack[firstLarge];
+        double threshold = (double)scaled[small] / (double)total * 4294967296.0;
+        out[small].threshold = threshold >= 4294967295.0 ? UINT32_MAX : (uint32_t)threshold;
+        out[small].alias = large;
+        scaled[large] -= total - scaled[small];
+        if (scaled[large] < total) {
+            firstLarge++;
+            stack[numSmall++] = large;
+        }
+    }
+    // 남은 칸은 (반올림 오차까지 포함해) 자기 자신만 가리킴
+    while (numSmall > 0) {
+        uint32_t j = stack[--numSmall];
+        out[j] = (CatalogAlias){ UINT32_MAX, j };
+    }
+    for (uint32_t k = firstLarge; k < count; k++) out[stack[k]] = (CatalogAlias){ UINT32_MAX, stack[k] };
+}
+
+// 이전 판의 같은 이름 카테고리가 도전 ID와 가중치까지 같은 순서로 같으면 그 별칭 표를 그대로 씀 (다시 만들 필요 없음)
+static int reuseDareAlias(const ContentTable* previous, const char* name, const SnapDareRow* rows,
+                          const uint32_t* order, uint32_t count, CatalogAlias* out) {
+    int k = previous ? findDareCategory(previous, name) : -1;
+    if (k < 0 || previous->categories[k].count != count) return 0;
+    const uint32_t* oldOrder = previous->dareOrder + previous->categories[k].first;
+    for (uint32_t j = 0; j < count; j++) {
+        if (oldOrder[j] >= (uint32_t)previous->dareCount) return 0;
+        const SnapDareRow* old = &previous->dareRows[oldOrder[j]];
+        if (old->id != rows[order[j]].id || old->weight != rows[order[j]].weight) return 0;
+    }
+    memcpy(out, previous->dareAlias + previous->categories[k].first, sizeof(CatalogAlias) * count);
+    return 1;
+}
+
+// 모은 질문/도전으로 카탈로그 이미지를 만듦 (파일과 같은 형식, 빌더는 비움)
+// previous가 있으면 내용이 그대로인 카테고리의 별칭 표는 그 판에서 옮겨 오고, 바뀐 카테고리만 새로 만든다.
+static char* buildContentImage(GameContext* ctx, ContentBuilder* b, const ContentTable* previous, size_t* size) {
+    int truthCount = sortContentEntries(b->truth, b->truthCount);
+    int dareCount = sortContentEntries(b->dare, b->dareCount);
+    // 카테고리 문자열 오프셋이 같으면 같은 카테고리 (풀에서 한 번만 저장되므로), 오프셋순으로 묶음
+    uint64_t* keys = snapGrow(NULL, sizeof(uint64_t) * (dareCount + 1));
+    for (int i = 0; i < dareCount; i++) keys[i] = (uint64_t)b->dare[i].categoryOff << 32 | (uint32_t)i;
+    qsort(keys, dareCount, sizeof(uint64_t), compareU64);
+    int categoryCount = 0;
+    for (int i = 0; i < dareCount; i++) categoryCount += i == 0 || keys[i] >> 32 != keys[i - 1] >> 32;
+
+    CatalogHeader header = {0};
+    memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+    header.version = CATALOG_VERSION;
+    header.truthCount = (uint32_t)truthCount;
+    header.dareCount = (uint32_t)dareCount;
+    header.categoryCount = (uint32_t)categoryCount;
+    uint64_t offset = sizeof(header);
+    header.truthOffset = offset;
+    offset = (offset + sizeof(SnapTruthRow) * truthCount + 7) & ~(uint64_t)7;
+    header.dareOffset = offset;
+    offset = (offset + sizeof(SnapDareRow) * dareCount + 7) & ~(uint64_t)7;
+    header.categoryOffset = offset;
+    offset = (offset + sizeof(CatalogCategory) * categoryCount + 7) & ~(uint64_t)7;
+    header.dareOrderOffset = offset;
+    offset = (offset + sizeof(uint32_t) * dareCount + 7) & ~(uint64_t)7;
+    header.aliasOffset = offset;
+    offset = (offset + sizeof(CatalogAlias) * dareCount + 7) & ~(uint64_t)7;
+    header.stringsOffset = offset;
+    header.stringsSize = b->pool.size;
+    header.fileSize = offset + b->pool.size;
+    getFileSignature(ctx->paths[DATA_TRUTH_QUESTIONS], &header.sourceSize[0], &header.sourceMtime[0]);
+    getFileSignature(ctx->paths[DATA_DARE_CHALLENGES], &header.sourceSize[1], &header.sourceMtime[1]);
+
+    char* image = calloc(1, header.fileSize);
+    if (image == NULL) outOfMemory();
+    memcpy(image, &header, sizeof(header));
+    SnapTruthRow* truthRows = (SnapTruthRow*)(image + header.truthOffset);
+    for (int i = 0; i < truthCount; i++) {
+        truthRows[i].id = b->truth[i].id;
+        truthRows[i].questionOff = b->truth[i].textOff;
+    }
+    SnapDareRow* dareRows = (SnapDareRow*)(image + header.dareOffset);
+    for (int i = 0; i < dareCount; i++) {
+        dareRows[i].id = b->dare[i].id;
+        dareRows[i].categoryOff = b->dare[i].categoryOff;
+        dareRows[i].challengeOff = b->dare[i].textOff;
+        dareRows[i].weight = b->dare[i].weight;
+    }
+    CatalogCategory* categories = (CatalogCategory*)(image + header.categoryOffset);
+    uint32_t* dareOrder = (uint32_t*)(image + header.dareOrderOffset);
+    CatalogCategory* category = categories - 1;
+    for (int i = 0; i < dareCount; i++) {
+        if (i == 0 || keys[i] >> 32 != keys[i - 1] >> 32) {
+            category++;
+            category->nameOff = (uint32_t)(keys[i] >> 32);
+            category->first = (uint32_t)i;
+        }
+        category->count++;
+        dareOrder[i] = (uint32_t)keys[i];
+    }
+    CatalogAlias* alias = (CatalogAlias*)(image + header.aliasOffset);
+    uint64_t* scaled = (uint64_t*)keys; // 정렬 키는 다 썼으므로 작업 공간으로 다시 씀
+    uint32_t* stack = snapGrow(NULL, sizeof(uint32_t) * (dareCount + 1));
+    for (int k = 0; k < categoryCount; k++) {
+        const CatalogCategory* c = &categories[k];
+        if (!reuseDareAlias(previous, b->pool.data + c->nameOff, dareRows, dareOrder + c->first, c->count, alias + c->first)) {
+            buildDareAlias(dareRows, dareOrder + c->first, c->count, alias + c->first, scaled, stack);
+        }
+    }
+    free(stack);
+    memcpy(image + header.stringsOffset, b->pool.data, b->pool.size);
+    free(keys);
+    contentBuilderFree(b);
+    *size = (size_t)header.fileSize;
+    return image;
+}
+
+// 본문 배열 하나가 이미지 안에 있는지
+static int catalogRangeValid(uint64_t offset, uint64_t count, size_t rowSize, size_t size) {
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / rowSize;
+}
+
+// 카탈로그 이미지를 검증하고 판으로 감쌈 (형식이 맞지 않으면 NULL, 이때 이미지는 호출한 쪽이 해제)
+// 행과 문자열은 건드리지 않으므로 큰 카탈로그도 여기서는 헤더와 카테고리 표만 읽는다.
+static ContentTable* openContentTable(const char* data, size_t size, int mapped) {
+    const CatalogHeader* header = (const CatalogHeader*)data;
+    if (size < sizeof(CatalogHeader) ||
+        memcmp(header->magic, CATALOG_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CATALOG_VERSION ||
+        header->fileSize != size ||
+        header->truthCount > INT_MAX || header->dareCount > INT_MAX ||
+        !catalogRangeValid(header->truthOffset, header->truthCount, sizeof(SnapTruthRow), size) ||
+        !catalogRangeValid(header->dareOffset, header->dareCount, sizeof(SnapDareRow), size) ||
+        !catalogRangeValid(header->categoryOffset, header->categoryCount, sizeof(CatalogCategory), size) ||
+        !catalogRangeValid(header->dareOrderOffset, header->dareCount, sizeof(uint32_t), size) ||
+        !catalogRangeValid(header->aliasOffset, header->dareCount, sizeof(CatalogAlias), size) ||
+        !catalogRangeValid(header->stringsOffset, header->stringsSize, 1, size) ||
+        header->stringsSize == 0 || data[header->stringsOffset + header->stringsSize - 1] != '\0') { // 풀이 NUL로 끝나야 모든 오프셋이 안전하게 문자열로 읽힘
+        return NULL;
+    }
+    const CatalogCategory* categories = (const CatalogCategory*)(data + header->categoryOffset);
+    for (uint32_t i = 0; i < header->categoryCount; i++) {
+        if (categories[i].first > header->dareCount || categories[i].count > header->dareCount - categories[i].first) return NULL;
+    }
+    ContentTable* table = calloc(1, sizeof(ContentTable));
+    if (table == NULL) outOfMemory();
+    table->data = data;
+    table->size = size;
+    table->mapped = mapped;
+    table->truthRows = (const SnapTruthRow*)(data + header->truthOffset);
+    table->dareRows = (const SnapDareRow*)(data + header->dareOffset);
+    table->categories = categories;
+    table->dareOrder = (const uint32_t*)(data + header->dareOrderOffset);
+    table->dareAlias = (const CatalogAlias*)(data + header->aliasOffset);
+    table->strings = data + header->stringsOffset;
+    table->stringsSize = (size_t)header->stringsSize;
+    table->truthCount = (int)header->truthCount;
+    table->dareCount = (int)header->dareCount;
+    table->categoryCount = (int)header->categoryCount;
+    return table;
+}
+
+static void freeContentTable(ContentTable* table) {
+    unmapFile(table->data, table->size, table->mapped);
+    free(table->categoryIds);
+    free(table->categoryById);
+    free(table);
+}
+
+// 빌더 내용으로 메모리 판 생성 (빌더는 비움, previous는 별칭 표를 옮겨 올 지금 판이며 없으면 NULL)
+static ContentTable* buildContentTable(GameContext* ctx, ContentBuilder* b, const ContentTable* previous) {
+    size_t size;
+    char* image = buildContentImage(ctx, b, previous, &size);
+    ContentTable* table = openContentTable(image, size, 0);
+    if (table == NULL) outOfMemory(); // 방금 만든 이미지는 항상 올바름
+    return table;
+}
+
+// 카탈로그 파일을 매핑해 판 생성 (파일이 없거나, 형식이 다르거나, 질문/도전 텍스트 파일이 그 뒤에 바뀌었으면 NULL)
+// 텍스트 파일이 없으면 카탈로그만 배포한 것으로 보고 그대로 사용한다.
+static ContentTable* openContentCatalog(GameContext* ctx) {
+    size_t size;
+    int mapped;
+    const char* data = mapFile(ctx->paths[DATA_CATALOG], &size, &mapped);
+    if (data == NULL) return NULL;
+    ContentTable* table = openContentTable(data, size, mapped);
+    if (table == NULL) {
+        gameLog(ctx, "콘텐츠 카탈로그 형식이 올바르지 않습니다. 텍스트 파일을 사용합니다.\n");
+        unmapFile(data, size, mapped);
+        return NULL;
+    }
+    const CatalogHeader* header = (const CatalogHeader*)data;
+    const int sources[2] = { DATA_TRUTH_QUESTIONS, DATA_DARE_CHALLENGES };
+    for (int k = 0; k < 2; k++) {
+        int64_t fileSize, mtime;
+        getFileSignature(ctx->paths[sources[k]], &fileSize, &mtime);
+        if (fileSize >= 0 && (fileSize != header->sourceSize[k] || mtime != header->sourceMtime[k])) {
+            gameLog(ctx, "콘텐츠 카탈로그가 %s보다 오래되었습니다. 텍스트 파일을 사용합니다.\n", dataFileNames[sources[k]]);
+            freeContentTable(table);
+            return NULL;
+        }
+    }
+#ifndef _WIN32
+    if (mapped) madvise((void*)data, size, MADV_RANDOM); // 조회마다 흩어진 페이지 하나씩만 읽으므로 미리 읽기를 끔
+#endif
+    table->fromCatalog = 1;
+    statsIo(ctx, STAT_IO_READ_BYTES, sizeof(CatalogHeader)); // 나머지는 조회할 때 필요한 페이지만 읽음
+    return table;
+}
+
+
+// --- 콘텐츠 판 ---
+// 질문/도전 목록은 통째로 새 판을 만들어 포인터만 바꿔 끼운다 (RCU 방식).
+// 읽는 쪽은 잠그지 않으며 만드는 도중의 판을 볼 수 없다. 읽은 판은 같은 스레드가 다음에 콘텐츠를
+// 읽을 때까지 표시해 두므로, 반환한 질문/도전 포인터는 그때까지 유효하다.
+
+static _Thread_local ContentReader* threadContentReader; // 이 스레드가 마지막으로 쓴 표시
+static _Thread_local unsigned long threadContentCtxId;   // threadContentReader가 속한 컨텍스트 번호
+static _Thread_local TruthQuestion threadTruth; // 공개 함수가 반환하는 질문 (이 스레드의 다음 질문 조회까지 유효)
+static _Thread_local DareChallenge threadDare;
+
+// 이 스레드의 표시 (처음이면 목록에서 찾거나 새로 만들어 CAS로 목록 앞에 붙임)
+static ContentReader* contentReader(GameContext* ctx) {
+    if (threadContentReader != NULL && threadContentCtxId == ctx->statsId) return threadContentReader;
+    if (threadSerial == 0) threadSerial = atomic_fetch_add(&nextThreadSerial, 1);
+    ContentReader* reader = atomic_load(&ctx->contentReaders);
+    while (reader != NULL && reader->owner != threadSerial) reader = reader->next;
+    if (reader == NULL) {
+        reader = calloc(1, sizeof(ContentReader));
+        if (reader == NULL) outOfMemory();
+        reader->owner = threadSerial;
+        // 목록에 붙이기 전에 표시해 두어야, 처음 읽는 판이 표시 전에 해제되지 않음
+        atomic_store(&reader->pinned, CONTENT_PIN_ALL);
+        ContentReader* head = atomic_load(&ctx->contentReaders);
+        do {
+            reader->next = head;
+        } while (!atomic_compare_exchange_weak(&ctx->contentReaders, &head, reader));
+    }
+    threadContentReader = reader;
+    threadContentCtxId = ctx->statsId;
+    return reader;
+}
+
+// 현재 판을 읽고 이 스레드의 표시를 그 판으로 옮김
+// 포인터를 읽는 동안에는 이전 표시(또는 CONTENT_PIN_ALL)가 남아 있어 읽은 판보다 오래되지 않았으므로 판이 해제되지 않고,
+// 표시를 쓴 뒤 포인터가 그대로인지 다시 확인하므로 교체하는 쪽이 표시를 읽을 때 이 판을 놓치지 않는다.
+static const ContentTable* contentAcquire(GameContext* ctx) {
+    ContentReader* reader = contentReader(ctx);
+    ContentTable* table = atomic_load(&ctx->content);
+    for (;;) {
+        atomic_store(&reader->pinned, table->version);
+        ContentTable* now = atomic_load(&ctx->content);
+        if (now == table) return table;
+        table = now;
+    }
+}
+
+// 모든 스레드의 표시보다 오래된 판 해제 (contentLock 안에서 호출)
+static void contentReclaim(GameContext* ctx) {
+    uint64_t oldest = atomic_load(&ctx->content)->version;
+    for (ContentReader* r = atomic_load(&ctx->contentReaders); r != NULL; r = r->next) {
+        uint64_t pinned = atomic_load(&r->pinned);
+        if (pinned < oldest) oldest = pinned; // 목록의 표시는 모두 읽는 중으로 봄
+    }
+    ContentTable** link = &ctx->retiredContent;
+    while (*link != NULL) {
+        ContentTable* table = *link;
+        if (table->version < oldest) {
+            *link = table->nextRetired;
+            freeContentTable(table);
+        } else {
+            link = &table->nextRetired;
+        }
+    }
+}
+
+// --- Dare 카테고리 ID ---
+// 카테고리 이름마다 1부터의 작은 정수 ID를 한 번 정해 dare_categories.txt에 한 줄씩 붙여 둔다 (ID: 처음 나온 줄 순서).
+// 그래서 콘텐츠를 다시 읽거나 다시 시작해도, 같은 데이터 디렉터리를 쓰는 다른 프로세스에서도 같은 이름은 같은 ID이며
+// 사용자 통계에 ID만 저장해도 된다. 두 프로세스가 같은 이름을 동시에 붙이면 먼저 붙은 줄이 ID를 정하고 뒤의 줄은 무시된다.
+// 판마다 카테고리 번호 ↔ ID 표를 공개 전에 만들어 두므로, 뽑기와 통계는 이름을 비교하지 않고 ID로 바로 찾는다.
+// (이름 표는 판을 공개하는 쪽만 contentLock 안에서 다루고, 읽는 쪽은 판의 표만 봄)
+
+// 이름 표에 없던 이름이면 다음 ID로 추가
+static void categoryNameAdd(GameContext* ctx, const char* name) {
+    if (*name == '\0' || poolFind(&ctx->categoryNames, name) != 0) return;
+    if (ctx->categoryNameCount == ctx->categoryNameCapacity) {
+        ctx->categoryNameCapacity = ctx->categoryNameCapacity ? ctx->categoryNameCapacity * 2 : 16;
+        ctx->categoryNameOffs = snapGrow(ctx->categoryNameOffs, sizeof(uint32_t) * ctx->categoryNameCapacity);
+    }
+    ctx->categoryNameOffs[ctx->categoryNameCount++] = poolIntern(&ctx->categoryNames, name);
+}
+
+// 이름 → 카테고리 ID (없으면 0, 오프셋 배열에서 이진 검색)
+static int categoryNameId(const GameContext* ctx, const char* name) {
+    uint32_t found = poolFind(&ctx->categoryNames, name);
+    if (found == 0) return 0;
+    int lo = 0, hi = ctx->categoryNameCount;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (ctx->categoryNameOffs[mid] < found - 1) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < ctx->categoryNameCount && ctx->categoryNameOffs[lo] == found - 1 ? lo + 1 : 0;
+}
+
+// dare_categories.txt에서 아직 읽지 않은 줄을 이름 표에 추가 (쓰는 중인 마지막 줄은 다음에 읽음)
+static void categoryNamesSync(GameContext* ctx) {
+    FILE* fp = fopen(ctx->paths[DATA_CATEGORIES], "r");
+    if (fp == NULL) return;
+    fseek(fp, ctx->categoryFileRead, SEEK_SET);
+    char* line = NULL;
+    size_t capacity = 0;
+    for (;;) {
+        long start = ftell(fp);
+        if (!readContentLine(fp, &line, &capacity)) break;
+        if (feof(fp)) { // 개행 없이 끝난 줄
+            fseek(fp, start, SEEK_SET);
+            break;
+        }
+        categoryNameAdd(ctx, line);
+    }
+    ctx->categoryFileRead = ftell(fp);
+    statsIo(ctx, STAT_IO_READ_BYTES, (uint64_t)ctx->categoryFileRead);
+    free(line);
+    fclose(fp);
+}
+
+// 이름의 카테고리 ID (처음 보는 이름이면 파일에 붙여 ID를 정함)
+static int internDareCategory(GameContext* ctx, const char* name) {
+    int id = categoryNameId(ctx, name);
+    if (id != 0 || *name == '\0') return id;
+    FILE* fp = fopen(ctx->paths[DATA_CATEGORIES], "a");
+    size_t len = strlen(name);
+    char* line = snapGrow(NULL, len + 2);
+    memcpy(line, name, len);
+    line[len] = '\n';
+    line[len + 1] = '\0';
+    // 다른 프로세스의 줄과 섞이지 않도록 한 번에 씀 (추가 모드이므로 항상 파일 끝)
+    int written = fp != NULL && fwrite(line, 1, len + 1, fp) == len + 1 && fflush(fp) == 0;
+    if (fp != NULL) fclose(fp);
+    free(line);
+    if (written) statsIo(ctx, STAT_IO_WRITE_BYTES, len + 1);
+    categoryNamesSync(ctx); // 그 사이 다른 프로세스가 붙인 줄까지 읽어 파일 순서대로 ID를 정함
+    id = categoryNameId(ctx, name);
+    if (id == 0) { // 파일에 쓸 수 없으면 이 프로세스 안에서만 정함 (다음 시작 때 다른 ID가 될 수 있음)
+        gameLog(ctx, "%s에 카테고리를 추가할 수 없습니다: %s\n", dataFileNames[DATA_CATEGORIES], name);
+        categoryNameAdd(ctx, name);
+        id = categoryNameId(ctx, name);
+    }
+    return id;
+}
+
+// 판의 카테고리 번호 ↔ ID 표 만들기 (contentLock 안에서, 공개 전에)
+static void contentMapCategories(GameContext* ctx, ContentTable* table) {
+    categoryNamesSync(ctx);
+    table->categoryIds = snapGrow(NULL, sizeof(int) * (table->categoryCount + 1));
+    for (int k = 0; k < table->categoryCount; k++) {
+        table->categoryIds[k] = internDareCategory(ctx, contentString(table, table->categories[k].nameOff));
+    }
+    table->categoryIdLimit = ctx->categoryNameCount;
+    table->categoryById = snapGrow(NULL, sizeof(int) * (table->categoryIdLimit + 1));
+    for (int id = 0; id <= table->categoryIdLimit; id++) table->categoryById[id] = -1;
+    for (int k = 0; k < table->categoryCount; k++) {
+        if (table->categoryIds[k] > 0) table->categoryById[table->categoryIds[k]] = k;
+    }
+}
+
+// 카테고리 ID → 판의 카테고리 번호 (이 판에 없으면 -1)
+static int contentCategoryOfId(const ContentTable* table, int categoryId) {
+    return categoryId > 0 && categoryId <= table->categoryIdLimit ? table->categoryById[categoryId] : -1;
+}
+
+// 다 만든 판을 공개하고 예전 판은 해제 대기 목록으로
+static void contentPublish(GameContext* ctx, ContentTable* table) {
+    gameLock(&ctx->contentLock);
+    contentMapCategories(ctx, table);
+    table->version = ++ctx->contentVersion;
+    ContentTable* old = atomic_exchange(&ctx->content, table);
+    if (old != NULL) {
+        old->nextRetired = ctx->retiredContent;
+        ctx->retiredContent = old;
+    }
+    contentReclaim(ctx);
+    gameUnlock(&ctx->contentLock);
+}
+
+// 현재 판과 해제 대기 판, 읽는 스레드 목록을 모두 해제 (세션이 모두 끝난 뒤)
+static void contentClear(GameContext* ctx) {
+    ContentTable* table = atomic_exchange(&ctx->content, NULL);
+    if (table != NULL) freeContentTable(table);
+    while (ctx->retiredContent != NULL) {
+        table = ctx->retiredContent;
+        ctx->retiredContent = table->nextRetired;
+        freeContentTable(table);
+    }
+    ContentReader* reader = atomic_exchange(&ctx->contentReaders, NULL);
+    while (reader != NULL) {
+        ContentReader* next = reader->next;
+        free(reader);
+        reader = next;
+    }
+    free(ctx->categoryNames.data);
+    free(ctx->categoryNames.slots);
+    free(ctx->categoryNameOffs);
+}
+
+// ID로 Truth 질문 검색 (없으면 NULL)
+const TruthQuestion* findTruthQuestion(GameContext* ctx, int id) {
+    const ContentTable* content = contentAcquire(ctx);
+    int row = findTruthRow(content, id);
+    if (row < 0) return NULL;
+    threadTruth = truthAt(content, row);
+    return &threadTruth;
+}
+
+// ID로 Dare 도전 검색 (없으면 NULL)
+const DareChallenge* findDareChallenge(GameContext* ctx, int id) {
+    const ContentTable* content = contentAcquire(ctx);
+    int row = findDareRow(content, id);
+    if (row < 0) return NULL;
+    threadDare = dareAt(content, row);
+    return &threadDare;
+}
+
+
+// --- 사용자 통계 함수 ---
+// 통계는 기록을 하나 추가할 때마다 그 기록만 보고 갱신하므로, 날짜순으로 다시 적용하면 처음부터 다시 만들 수 있다.
+
+// 그 날짜가 속한 주의 월요일 (1970-01-01은 목요일)
+static int weekStartOf(int day) {
+    int offset = (day + 3) % 7;
+    return day - (offset < 0 ? offset + 7 : offset);
+}
+
+static void userStatsReset(UserStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->truthStreakDay = DAY_NONE;
+    stats->weekStart = DAY_NONE;
+}
+
+// 기록 한 건을 통계에 반영 (사용자 샤드 잠금 안에서, 또는 로드 중에 호출)
+// 예전 날짜의 기록이 늦게 들어오면 횟수만 세고 연속 참여/주간 코인은 바꾸지 않음
+static void userStatsAdd(GameContext* ctx, UserStats* stats, int day, int type, int contentId, const char* response, int coinsEarned) {
+    if (type == 0) {
+        stats->truthAnswers++;
+        if (stats->truthStreakDay == DAY_NONE || day > stats->truthStreakDay + 1) {
+            stats->truthStreak = 1;
+            stats->truthStreakDay = day;
+        } else if (day == stats->truthStreakDay + 1) {
+            stats->truthStreak++;
+            stats->truthStreakDay = day;
+        }
+        return;
+    }
+    stats->dareAttempts++;
+    stats->dareCompletions += strcmp(response, "Complete") == 0;
+    int week = weekStartOf(day);
+    if (stats->weekStart == DAY_NONE || week > stats->weekStart) {
+        stats->weekStart = week;
+        stats->weekCoins = 0;
+    }
+    if (week == stats->weekStart) stats->weekCoins += coinsEarned;
+    const ContentTable* content = contentAcquire(ctx); // 공개 함수의 반환 칸은 호출한 쪽이 쓰고 있을 수 있음
+    int row = findDareRow(content, contentId);
+    int k = row >= 0 ? findDareRowCategory(content, row) : -1;
+    if (k < 0) return; // 지워진 도전은 카테고리를 모름
+    int key = content->categoryIds[k];
+    // 같은 카테고리 칸이나 빈 칸에 세고, 칸이 모두 찼으면 가장 적게 센 칸을 물려받음
+    // (물려받은 칸은 이전 횟수에서 이어 세므로 많이 시도한 카테고리는 밀려나지 않음)
+    int slot = 0;
+    for (int k = 0; k < USER_CATEGORY_SLOTS; k++) {
+        UserCategoryCount* c = &stats->categoryDares[k];
+        if (c->category == key || c->category == 0) {
+            slot = k;
+            break;
+        }
+        if (c->dares < stats->categoryDares[slot].dares) slot = k;
+    }
+    stats->categoryDares[slot].category = key;
+    stats->categoryDares[slot].dares++;
+}
+
+// 사용자 하나의 통계를 날짜순 기록 목록에서 다시 계산
+static void rebuildUserStatsOf(GameContext* ctx, int userIdx) {
+    User* u = userAt(ctx, userIdx);
+    const RecordList* list = recordListAt(ctx, userIdx);
+    userStatsReset(&u->stats);
+    for (int i = 0; i < list->count; i++) {
+        RecordFields rec;
+        recordFieldsAt(ctx, list->items[i], &rec);
+        userStatsAdd(ctx, &u->stats, rec.day, rec.type, rec.contentId, rec.response, rec.coinsEarned);
+    }
+    u->statsStale = 0;
+}
+
+// 사용자 행의 통계 칸 → stats (칸이 없는 예전 형식이면 0), consumed에는 읽은 글자 수
+static int parseUserStats(const char* str, UserStats* stats, int* consumed) {
+    char streakDate[MAX_DATE_LEN], weekDate[MAX_DATE_LEN];
+    *consumed = 0;
+    int slots = 0, len = 0;
+    if (sscanf(str, "%d %d %d %d %14s %14s %d @%d%n", &stats->truthAnswers, &stats->dareAttempts,
+               &stats->dareCompletions, &stats->truthStreak, streakDate, weekDate, &stats->weekCoins,
+               &slots, &len) != 8 || slots < 0 || slots > USER_CATEGORY_SLOTS) {
+        userStatsReset(stats);
+        return 0;
+    }
+    // 카테고리 칸은 "@개수 ID:횟수 ..." (예전 형식은 '@'이 없어 다시 계산됨)
+    memset(stats->categoryDares, 0, sizeof(stats->categoryDares));
+    for (int k = 0; k < slots; k++) {
+        UserCategoryCount* c = &stats->categoryDares[k];
+        int n = 0;
+        if (sscanf(str + len, " %d:%d%n", &c->category, &c->dares, &n) != 2 || c->category <= 0) {
+            userStatsReset(stats);
+            return 0;
+        }
+        len += n;
+    }
+    *consumed = len;
+    stats->truthStreakDay = parseUserDay(streakDate);
+    stats->weekStart = parseUserDay(weekDate);
+    return 1;
+}
+
+// --- Truth 질문 주머니 ---
+// 사용자마다 한 바퀴 동안 질문 ID 범위 [firstId, firstId + span)를 키로 정한 순열 순서대로 하나씩 내고,
+// 끝까지 내면 새 키로 다음 바퀴를 시작한다. 순열은 4^halfBits 범위의 키 있는 파이스텔 전단사 함수를 span 미만이
+// 나올 때까지 되풀이 적용(cycle walking)해서 계산하므로 사용자마다 (첫 ID, 범위, 차례, 키)만 저장하면 되고,
+// 한 번 뽑는 데 평균 네 번 이하의 적용과 ID 이진 검색 한 번이면 된다 (질문 전체를 훑지 않음).
+// 순열이 행 번호가 아니라 ID 위의 것이므로 콘텐츠를 다시 읽어도 차례는 그대로 새 판에서 이어진다:
+// 지워진 ID와 비어 있는 ID는 차례에서 건너뛰고, 범위 밖 ID로 추가된 질문은 다음 바퀴부터 나온다
+// (범위 안의 빈 ID에 추가된 질문은 차례가 아직 안 지났으면 이번 바퀴에 나올 수 있음).
+// 질문 ID는 보통 차례로 붙이므로 건너뛸 빈 ID는 드물다.
+
+// 키에 따라 [0, 4^halfBits) 안에서 섞기 (4단 파이스텔: 반쪽끼리 xor만 하므로 어떤 라운드 함수든 전단사)
+static uint32_t truthBagMix(unsigned int key, int halfBits, uint32_t x) {
+    uint32_t mask = (uint32_t)((1ull << halfBits) - 1);
+    uint32_t left = x >> halfBits, right = x & mask;
+    for (uint64_t round = 0; round < 4; round++) {
+        uint32_t f = (uint32_t)splitMix64(((uint64_t)key << 32 | right) ^ (round << 60)) & mask;
+        uint32_t next = left ^ f;
+        left = right;
+        right = next;
+    }
+    return left << halfBits | right;
+}
+
+// 바퀴의 pos번째 질문 ID (firstId부터 span개 ID의 순열)
+static int truthBagId(const User* u, uint32_t pos) {
+    int halfBits = 1;
+    while (halfBits < 16 && (1ull << (2 * halfBits)) < u->truthBagSpan) halfBits++;
+    uint32_t x = pos;
+    do {
+        x = truthBagMix(u->truthBagKey, halfBits, x);
+    } while (x >= u->truthBagSpan); // pos < span이므로 순열의 같은 순환 안에서 반드시 span 미만으로 돌아옴
+    return (int)((int64_t)u->truthBagFirstId + x);
+}
+
+// 새로 섞을 키 (시드를 고정했으면 사용자 ID와 이전 키만으로 정해지므로 스레드/세션 순서와 무관하게 재현됨)
+static unsigned int truthBagNewKey(GameContext* ctx, const User* u) {
+    if (!ctx->rngSeeded) return gameRandom(ctx);
+    return (unsigned int)splitMix64(ctx->rngSeed ^ ((uint64_t)hashString(u->id) << 32) ^ u->truthBagKey);
+}
+
+// 사용자의 지금 차례 질문 행 (샤드 잠금 안에서, 질문이 하나 이상일 때)
+// 지금 차례의 ID가 판에 없으면 다음 차례로 넘기고, 바퀴가 없거나 끝났으면 지금 판의 ID 범위로 새 바퀴를 시작함
+static int truthBagCurrent(GameContext* ctx, UserShard* shard, int userIdx, const ContentTable* content) {
+    User* u = userAt(ctx, userIdx);
+    int moved = 0;
+    for (;;) {
+        if (u->truthBagCursor >= u->truthBagSpan) {
+            int firstId = content->truthRows[0].id;
+            uint64_t span = (uint64_t)((int64_t)content->truthRows[content->truthCount - 1].id - firstId) + 1;
+            u->truthBagKey = truthBagNewKey(ctx, u);
+            u->truthBagFirstId = firstId;
+            u->truthBagSpan = span > UINT32_MAX ? UINT32_MAX : (uint32_t)span; // ID가 int 전체에 걸치면 마지막 ID는 다음 바퀴로
+            u->truthBagCursor = 0;
+            moved = 1;
+        }
+        int row = findTruthRow(content, truthBagId(u, u->truthBagCursor));
+        if (row >= 0) {
+            if (moved) markUserDirty(ctx, shard, userIdx);
+            return row;
+        }
+        u->truthBagCursor++; // 지워졌거나 비어 있는 ID
+        moved = 1;
+    }
+}
+
+// 지금 차례 질문에 답했으므로 다음 차례로 (샤드 잠금 안에서, 다음 질문은 truthBagCurrent가 찾음)
+static void truthBagAdvance(GameContext* ctx, UserShard* shard, int userIdx) {
+    User* u = userAt(ctx, userIdx);
+    u->truthBagCursor++;
+    markUserDirty(ctx, shard, userIdx);
+}
+
+// 사용자 행의 주머니 칸 → u (칸이 없는 예전 형식이면 다음에 질문을 낼 때 새로 섞음)
+static void parseUserTruthBag(const char* str, User* u) {
+    if (sscanf(str, "%d %u %u %x", &u->truthBagFirstId, &u->truthBagSpan, &u->truthBagCursor, &u->truthBagKey) != 4 ||
+        u->truthBagCursor > u->truthBagSpan) {
+        u->truthBagFirstId = 0;
+        u->truthBagSpan = 0;
+        u->truthBagCursor = 0;
+        u->truthBagKey = 0;
+    }
+}
+
+
+// --- 바이너리 스냅샷 ---
+// 파일 구성: [SnapshotHeader][SnapshotSection × sectionCount][섹션 본문들 (8바이트 정렬)]
+// 행 섹션은 고정 크기 행 배열이며, 문자열은 모두 SNAP_STRINGS 풀(NUL 종료 문자열 모음)의
+// 오프셋으로 저장한다. 각 섹션에는 만들 때 사용한 텍스트 파일의 크기/수정 시각을 기록해 두고,
+// 시작 시 텍스트 파일이 그대로일 때만 해당 섹션을 사용한다 (바뀌었으면 텍스트를 파싱).
+
+// 스냅샷 파일 열기 및 검증 (실패 시 0, 파일이 없거나 형식이 다르면 텍스트 파일 사용)
+static int openSnapshot(GameContext* ctx) {
+    Snapshot s = {0};
+    s.data = mapFile(ctx->paths[DATA_SNAPSHOT], &s.size, &s.mapped);
+    if (s.data == NULL) return 0;
+
+    const SnapshotHeader* header = (const SnapshotHeader*)s.data;
+    if (s.size < sizeof(SnapshotHeader) ||
+        memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SNAPSHOT_VERSION ||
+        header->fileSize != s.size ||
+        header->sectionCount > (s.size - sizeof(SnapshotHeader)) / sizeof(SnapshotSection)) {
+        gameLog(ctx, "스냅샷 파일 형식이 올바르지 않습니다. 텍스트 파일을 사용합니다.\n");
+        unmapFile(s.data, s.size, s.mapped);
+        return 0;
+    }
+
+    const SnapshotSection* table = (const SnapshotSection*)(s.data + sizeof(SnapshotHeader));
+    for (uint32_t i = 0; i < header->sectionCount; i++) {
+        const SnapshotSection* sec = &table[i];
+        if (sec->type == 0 || sec->type > SNAP_SECTION_COUNT) continue; // 모르는 섹션은 무시
+        if (sec->offset > s.size || sec->size > s.size - sec->offset) continue;
+        s.sections[sec->type] = sec;
+    }
+
+    // 문자열 풀은 NUL로 끝나야 모든 오프셋이 안전하게 문자열로 읽힘
+    const SnapshotSection* pool = s.sections[SNAP_STRINGS];
+    if (pool == NULL || pool->size == 0 || s.data[pool->offset + pool->size - 1] != '\0') {
+        gameLog(ctx, "스냅샷 문자열 풀이 손상되었습니다. 텍스트 파일을 사용합니다.\n");
+        unmapFile(s.data, s.size, s.mapped);
+        return 0;
+    }
+    s.strings = s.data + pool->offset;
+    s.stringsSize = (size_t)pool->size;
+    ctx->snapshot = s;
+    statsIo(ctx, STAT_IO_READ_BYTES, s.size); // 매핑한 크기 (실제로 읽는 페이지는 이보다 적을 수 있음)
+    return 1;
+}
+
+static void closeSnapshot(GameContext* ctx) {
+    unmapFile(ctx->snapshot.data, ctx->snapshot.size, ctx->snapshot.mapped);
+    memset(&ctx->snapshot, 0, sizeof(ctx->snapshot));
+}
+
+// 사용할 수 있는 섹션이면 반환 (원본 텍스트 파일이 바뀌었거나 크기가 맞지 않으면 NULL)
+static const SnapshotSection* snapshotSection(GameContext* ctx, int type, const char* sourcePath, size_t rowSize) {
+    if (ctx->snapshot.data == NULL) return NULL;
+    const SnapshotSection* sec = ctx->snapshot.sections[type];
+    if (sec == NULL || sec->size != (uint64_t)sec->count * rowSize) return NULL;
+    if (ctx->snapshotRequireFresh) {
+        int64_t size, mtime;
+        getFileSignature(sourcePath, &size, &mtime);
+        if (size != sec->sourceSize || mtime != sec->sourceMtime) return NULL;
+    }
+    return sec;
+}
+
+// 문자열 풀 오프셋 → 문자열 (범위를 벗어나면 빈 문자열)
+static const char* snapString(GameContext* ctx, uint32_t offset) {
+    return offset < ctx->snapshot.stringsSize ? ctx->snapshot.strings + offset : "";
+}
+
+// 스냅샷에서 사용자 로드 (성공 시 1)
+static int loadUsersFromSnapshot(GameContext* ctx) {
+    const SnapshotSection* sec = snapshotSection(ctx, SNAP_USERS, ctx->paths[DATA_USERS], sizeof(SnapUserRow));
+    if (sec == NULL) return 0;
+    const SnapUserRow* rows = (const SnapUserRow*)(ctx->snapshot.data + sec->offset);
+    userTableClear(ctx);
+    userIndexClear(ctx);
+    for (uint32_t i = 0; i < sec->count; i++) {
+        const char* id = snapString(ctx, rows[i].idOff);
+        if (findUserIndex(ctx, id) >= 0) continue;
+        User* u = userPush(ctx);
+        if (u == NULL) sharedUsersFull(ctx);
+        copyString(u->id, id, sizeof(u->id));
+        copyString(u->password, snapString(ctx, rows[i].passwordOff), sizeof(u->password));
+        u->lastTruthDay = rows[i].lastTruthDay;
+        u->lastDareDay = rows[i].lastDareDay;
+        u->coins = rows[i].coins;
+        u->dareAttemptsToday = rows[i].dareAttemptsToday;
+        u->stats.truthAnswers = rows[i].truthAnswers;
+        u->stats.dareAttempts = rows[i].dareAttempts;
+        u->stats.dareCompletions = rows[i].dareCompletions;
+        u->stats.truthStreak = rows[i].truthStreak;
+        u->stats.truthStreakDay = rows[i].truthStreakDay;
+        u->stats.weekStart = rows[i].weekStart;
+        u->stats.weekCoins = rows[i].weekCoins;
+        for (int k = 0; k < USER_CATEGORY_SLOTS; k++) {
+            u->stats.categoryDares[k].category = rows[i].categoryIds[k];
+            u->stats.categoryDares[k].dares = rows[i].categoryDares[k];
+        }
+        u->truthBagFirstId = rows[i].truthBagFirstId;
+        u->truthBagSpan = rows[i].truthBagSpan;
+        u->truthBagCursor = rows[i].truthBagCursor;
+        u->truthBagKey = rows[i].truthBagKey;
+        registerNewUser(ctx);
+    }
+    // 스냅샷을 만든 뒤 users.txt가 바뀌지 않았으므로 행 수만으로 고정 폭 여부를 알 수 있음
+    ctx->usersFileFixedLayout = userCount(ctx) == (int)sec->count &&
+                           sec->sourceSize == (int64_t)userCount(ctx) * USER_ROW_WIDTH;
+    return 1;
+}
+
+// 스냅샷에서 Truth 질문 로드 (성공 시 1, 빈 섹션은 카탈로그를 쓰던 때의 스냅샷이므로 텍스트 파일 사용)
+static int loadTruthQuestionsFromSnapshot(GameContext* ctx, ContentBuilder* b) {
+    const SnapshotSection* sec = snapshotSection(ctx, SNAP_TRUTH, ctx->paths[DATA_TRUTH_QUESTIONS], sizeof(SnapTruthRow));
+    if (sec == NULL || sec->count == 0) return 0;
+    const SnapTruthRow* rows = (const SnapTruthRow*)(ctx->snapshot.data + sec->offset);
+    for (uint32_t i = 0; i < sec->count; i++) {
+        contentAddTruth(b, rows[i].id, snapString(ctx, rows[i].questionOff));
+    }
+    return 1;
+}
+
+// 스냅샷에서 Dare 도전 로드 (성공 시 1)
+static int loadDareChallengesFromSnapshot(GameContext* ctx, ContentBuilder* b) {
+    const SnapshotSection* sec = snapshotSection(ctx, SNAP_DARE, ctx->paths[DATA_DARE_CHALLENGES], sizeof(SnapDareRow));
+    if (sec == NULL || sec->count == 0) return 0;
+    const SnapDareRow* rows = (const SnapDareRow*)(ctx->snapshot.data + sec->offset);
+    for (uint32_t i = 0; i < sec->count; i++) {
+        contentAddDare(b, rows[i].id, snapString(ctx, rows[i].categoryOff), snapString(ctx, rows[i].challengeOff), (int)rows[i].weight);
+    }
+    return 1;
+}
+
+// 스냅샷에서 기록 압축본 로드 (성공 시 1, 저널 재생은 호출한 쪽에서)
+static int loadUserRecordsFromSnapshot(GameContext* ctx) {
+    const SnapshotSection* sec = snapshotSection(ctx, SNAP_RECORDS, ctx->paths[DATA_RECORDS], SNAP_RECORD_ROW_BYTES);
+    if (sec == NULL) return 0;
+    uint32_t n = sec->count;
+    const int32_t* days = (const int32_t*)(ctx->snapshot.data + sec->offset);
+    const int32_t* contentIds = days + n;
+    const int32_t* coins = contentIds + n;
+    const uint32_t* userIdOffs = (const uint32_t*)(coins + n);
+    const uint32_t* responseOffs = userIdOffs + n;
+    const uint8_t* types = (const uint8_t*)(responseOffs + n);
+    for (uint32_t i = 0; i < n; i++) {
+        RecordFields rec = { snapString(ctx, userIdOffs[i]), days[i], types[i], contentIds[i], coins[i],
+                             snapString(ctx, responseOffs[i]) };
+        recordPush(ctx, &rec, -1);
+    }
+    return 1;
+}
+
+// 현재 메모리의 사용자/기록/콘텐츠를 스냅샷 파일로 저장 (임시 파일에 쓴 뒤 교체)
+int saveSnapshot(GameContext* ctx) {
+    uint64_t start = statsBegin(ctx);
+    StringPoolBuilder pool = {0};
+    poolIntern(&pool, ""); // 오프셋 0은 빈 문자열
+
+    int numUsers = userCount(ctx);
+    SnapUserRow* userRows = snapGrow(NULL, sizeof(SnapUserRow) * (numUsers + 1));
+    for (int i = 0; i < numUsers; i++) {
+        User* u = userAt(ctx, i);
+        userRows[i].idOff = poolIntern(&pool, u->id);
+        userRows[i].passwordOff = poolIntern(&pool, u->password);
+        userRows[i].lastTruthDay = u->lastTruthDay;
+        userRows[i].lastDareDay = u->lastDareDay;
+        userRows[i].coins = u->coins;
+        userRows[i].dareAttemptsToday = u->dareAttemptsToday;
+        userRows[i].truthAnswers = u->stats.truthAnswers;
+        userRows[i].dareAttempts = u->stats.dareAttempts;
+        userRows[i].dareCompletions = u->stats.dareCompletions;
+        userRows[i].truthStreak = u->stats.truthStreak;
+        userRows[i].truthStreakDay = u->stats.truthStreakDay;
+        userRows[i].weekStart = u->stats.weekStart;
+        userRows[i].weekCoins = u->stats.weekCoins;
+        for (int k = 0; k < USER_CATEGORY_SLOTS; k++) {
+            userRows[i].categoryIds[k] = u->stats.categoryDares[k].category;
+            userRows[i].categoryDares[k] = u->stats.categoryDares[k].dares;
+        }
+        userRows[i].truthBagFirstId = u->truthBagFirstId;
+        userRows[i].truthBagSpan = u->truthBagSpan;
+        userRows[i].truthBagCursor = u->truthBagCursor;
+        userRows[i].truthBagKey = u->truthBagKey;
+    }
+    // 카탈로그에서 읽은 콘텐츠는 카탈로그 파일이 따로 있으므로 스냅샷에 넣지 않음 (빈 섹션)
+    const ContentTable* content = contentAcquire(ctx);
+    int numTruth = content->fromCatalog ? 0 : content->truthCount;
+    int numDare = content->fromCatalog ? 0 : content->dareCount;
+    SnapTruthRow* truthRows = snapGrow(NULL, sizeof(SnapTruthRow) * (numTruth + 1));
+    for (int i = 0; i < numTruth; i++) {
+        TruthQuestion q = truthAt(content, i);
+        truthRows[i].id = q.id;
+        truthRows[i].questionOff = poolIntern(&pool, q.question);
+    }
+    SnapDareRow* dareRows = snapGrow(NULL, sizeof(SnapDareRow) * (numDare + 1));
+    for (int i = 0; i < numDare; i++) {
+        DareChallenge d = dareAt(content, i);
+        dareRows[i].id = d.id;
+        dareRows[i].categoryOff = poolIntern(&pool, d.category);
+        dareRows[i].challengeOff = poolIntern(&pool, d.challenge);
+        dareRows[i].weight = (uint32_t)d.weight;
+    }
+    // 기록은 압축본에 들어 있는 부분만 저장 (이후 기록은 저널에서 재생), 항목별 배열로 이어 씀
+    size_t numRecords = (size_t)ctx->baseRecordCount;
+    char* recordColumns = snapGrow(NULL, SNAP_RECORD_ROW_BYTES * numRecords + 1);
+    int32_t* days = (int32_t*)recordColumns;
+    int32_t* contentIds = days + numRecords;
+    int32_t* coins = contentIds + numRecords;
+    uint32_t* userIdOffs = (uint32_t*)(coins + numRecords);
+    uint32_t* responseOffs = userIdOffs + numRecords;
+    uint8_t* types = (uint8_t*)(responseOffs + numRecords);
+    for (size_t i = 0; i < numRecords; i++) {
+        RecordFields rec;
+        recordFieldsAt(ctx, (int)i, &rec);
+        days[i] = rec.day;
+        contentIds[i] = rec.contentId;
+        coins[i] = rec.coinsEarned;
+        userIdOffs[i] = poolIntern(&pool, rec.userId);
+        responseOffs[i] = poolIntern(&pool, rec.response);
+        types[i] = (uint8_t)rec.type;
+    }
+
+    struct { int type; const char* source; const void* data; uint32_t count; size_t size; } parts[SNAP_SECTION_COUNT] = {
+        { SNAP_USERS, ctx->paths[DATA_USERS], userRows, (uint32_t)numUsers, sizeof(SnapUserRow) * numUsers },
+        { SNAP_RECORDS, ctx->paths[DATA_RECORDS], recordColumns, (uint32_t)numRecords, SNAP_RECORD_ROW_BYTES * numRecords },
+        { SNAP_TRUTH, ctx->paths[DATA_TRUTH_QUESTIONS], truthRows, (uint32_t)numTruth, sizeof(SnapTruthRow) * numTruth },
+        { SNAP_DARE, ctx->paths[DATA_DARE_CHALLENGES], dareRows, (uint32_t)numDare, sizeof(SnapDareRow) * numDare },
+        { SNAP_STRINGS, NULL, pool.data, (uint32_t)pool.size, pool.size },
+    };
+
+    SnapshotHeader header = {0};
+    SnapshotSection sections[SNAP_SECTION_COUNT] = {{0}};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.sectionCount = SNAP_SECTION_COUNT;
+    uint64_t offset = sizeof(header) + sizeof(sections);
+    for (int i = 0; i < SNAP_SECTION_COUNT; i++) {
+        offset = (offset + 7) & ~(uint64_t)7;
+        sections[i].type = parts[i].type;
+        sections[i].count = parts[i].count;
+        sections[i].offset = offset;
+        sections[i].size = parts[i].size;
+        if (parts[i].source != NULL) {
+            getFileSignature(parts[i].source, &sections[i].sourceSize, &sections[i].sourceMtime);
+        }
+        offset += parts[i].size;
+    }
+    header.fileSize = offset;
+
+    int ok = 0;
+    FILE* fp = fopen(ctx->paths[DATA_SNAPSHOT_TEMP], "wb");
+    if (fp != NULL) {
+        static const char zeros[8] = {0};
+        long pos = (long)(sizeof(header) + sizeof(sections));
+        fwrite(&header, sizeof(header), 1, fp);
+        fwrite(sections, sizeof(sections), 1, fp);
+        for (int i = 0; i < SNAP_SECTION_COUNT; i++) {
+            fwrite(zeros, 1, (size_t)(sections[i].offset - pos), fp); // 정렬용 패딩
+            fwrite(parts[i].data, 1, parts[i].size, fp);
+            pos = (long)(sections[i].offset + sections[i].size);
+        }
+        ok = !ferror(fp);
+        statsIo(ctx, STAT_IO_WRITE_BYTES, header.fileSize);
+        syncFile(ctx, fp);
+        fclose(fp);
+#ifdef _WIN32
+        remove(ctx->paths[DATA_SNAPSHOT]);
+#endif
+        ok = ok && rename(ctx->paths[DATA_SNAPSHOT_TEMP], ctx->paths[DATA_SNAPSHOT]) == 0;
+    }
+    if (ok) {
+        gameLog(ctx, "스냅샷 저장 완료: 사용자 %d명, 기록 %d개, 문자열 %zu바이트\n", numUsers, ctx->baseRecordCount, pool.size);
+    } else {
+        gameLog(ctx, "스냅샷 파일을 저장할 수 없습니다.\n");
+    }
+
+    free(userRows);
+    free(truthRows);
+    free(dareRows);
+    free(recordColumns);
+    free(pool.data);
+    free(pool.slots);
+    statsEnd(ctx, STAT_SAVE_SNAPSHOT, start);
+    return ok;
+}
+
+
+// --- Truth 답변 검색 ---
+// 답변을 토큰으로 나눠 (사용자, 토큰) → 기록 행 목록 역색인을 사용자 샤드마다 유지한다.
+// 답변을 저장할 때 그 답변의 토큰만 목록 끝에 붙이고, 검색은 검색어 토큰 목록들의 교집합만 본다.
+// 종료할 때 answers.idx에 저장해 두고, 다음 로드에서는 파일 이후에 추가된 행만 다시 토큰화한다.
+
+// 토큰 종류
+enum { SEARCH_CHAR_SEP, SEARCH_CHAR_WORD, SEARCH_CHAR_GRAM };
+
+typedef void (*SearchTokenSink)(void* arg, const char* token);
+
+// UTF-8 문자 하나를 해석하고 바이트 수 반환 (잘못된 바이트는 그 한 바이트를 문자 하나로 취급)
+static int utf8Decode(const unsigned char* s, unsigned int* cp) {
+    unsigned char c = s[0];
+    int len = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+    if (len <= 1) {
+        *cp = c;
+        return 1;
+    }
+    unsigned int value = c & (0x7F >> len);
+    for (int i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *cp = c;
+            return 1;
+        }
+        value = value << 6 | (s[i] & 0x3F);
+    }
+    *cp = value;
+    return len;
+}
+
+// 글자 종류: 한글/가나/한자는 글자 단위 n-gram, 그 밖의 글자는 단어, 공백/문장 부호는 구분자
+static int searchCharClass(unsigned int cp) {
+    if (cp < 0x80) return isalnum((int)cp) ? SEARCH_CHAR_WORD : SEARCH_CHAR_SEP;
+    if ((cp >= 0xAC00 && cp <= 0xD7A3) ||  // 한글 음절
+        (cp >= 0x1100 && cp <= 0x11FF) ||  // 한글 자모
+        (cp >= 0x3130 && cp <= 0x318F) ||  // 한글 호환 자모
+        (cp >= 0x3040 && cp <= 0x30FF) ||  // 히라가나, 가타카나
+        (cp >= 0x4E00 && cp <= 0x9FFF)) {  // 한자
+        return SEARCH_CHAR_GRAM;
+    }
+    if (cp == 0xA0 || (cp >= 0x2000 && cp <= 0x206F) || (cp >= 0x3000 && cp <= 0x303F) ||
+        (cp >= 0xFF00 && cp <= 0xFF0F)) {
+        return SEARCH_CHAR_SEP; // 유니코드 공백과 문장 부호
+    }
+    return SEARCH_CHAR_WORD;
+}
+
+// 문자열을 토큰으로 나눠 sink에 넘김
+// 단어는 통째로 (ASCII는 소문자로, SEARCH_TOKEN_MAX바이트에서 자름), n-gram 글자는 1-gram과 이웃 글자와의 2-gram
+// (조사가 붙거나 띄어쓰기가 다른 한국어도 부분 문자열로 찾을 수 있도록)
+static void searchTokenize(const char* text, SearchTokenSink sink, void* arg) {
+    const unsigned char* p = (const unsigned char*)text;
+    char token[SEARCH_TOKEN_MAX + 1];
+    while (*p) {
+        unsigned int cp;
+        int len = utf8Decode(p, &cp);
+        int cls = searchCharClass(cp);
+        if (cls == SEARCH_CHAR_SEP) {
+            p += len;
+        } else if (cls == SEARCH_CHAR_WORD) {
+            size_t n = 0;
+            while (*p && searchCharClass(cp) == SEARCH_CHAR_WORD) {
+                if (n + len <= SEARCH_TOKEN_MAX) {
+                    for (int i = 0; i < len; i++) token[n++] = p[i] < 0x80 ? (char)tolower(p[i]) : (char)p[i];
+                }
+                p += len;
+                len = utf8Decode(p, &cp);
+            }
+            token[n] = '\0';
+            sink(arg, token);
+        } else {
+            memcpy(token, p, len);
+            token[len] = '\0';
+            sink(arg, token);
+            unsigned int next;
+            int nextLen = utf8Decode(p + len, &next);
+            if (p[len] && searchCharClass(next) == SEARCH_CHAR_GRAM) {
+                memcpy(token + len, p + len, nextLen);
+                token[len + nextLen] = '\0';
+                sink(arg, token);
+            }
+            p += len;
+        }
+    }
+}
+
+static unsigned int searchHash(int user, const char* term) {
+    return hashString(term) ^ hashInt(user);
+}
+
+// (사용자, 토큰) 항목 찾기 (없으면 NULL)
+static SearchTerm* searchIndexFind(const SearchIndex* index, int user, const char* term) {
+    if (index->capacity == 0) return NULL;
+    unsigned int pos = searchHash(user, term) & (index->capacity - 1);
+    while (index->slots[pos].term != NULL) {
+        SearchTerm* t = &index->slots[pos];
+        if (t->user == user && strcmp(t->term, term) == 0) return t;
+        pos = (pos + 1) & (index->capacity - 1);
+    }
+    return NULL;
+}
+
+// (사용자, 토큰) 항목 찾기 또는 추가 (부하율 1/2 넘으면 두 배로 재해시)
+static SearchTerm* searchIndexAdd(SearchIndex* index, int user, const char* term) {
+    SearchTerm* found = searchIndexFind(index, user, term);
+    if (found != NULL) return found;
+    if ((index->size + 1) * 2 > index->capacity) {
+        int newCapacity = index->capacity ? index->capacity * 2 : SEARCH_INDEX_MIN_CAPACITY;
+        SearchTerm* newSlots = calloc(newCapacity, sizeof(SearchTerm));
+        if (newSlots == NULL) outOfMemory();
+        for (int i = 0; i < index->capacity; i++) {
+            if (index->slots[i].term == NULL) continue;
+            unsigned int pos = searchHash(index->slots[i].user, index->slots[i].term) & (newCapacity - 1);
+            while (newSlots[pos].term != NULL) pos = (pos + 1) & (newCapacity - 1);
+            newSlots[pos] = index->slots[i];
+        }
+        free(index->slots);
+        index->slots = newSlots;
+        index->capacity = newCapacity;
+    }
+    unsigned int pos = searchHash(user, term) & (index->capacity - 1);
+    while (index->slots[pos].term != NULL) pos = (pos + 1) & (index->capacity - 1);
+    SearchTerm* t = &index->slots[pos];
+    t->term = arenaCopyString(&index->terms, term, SEARCH_TOKEN_MAX);
+    t->user = user;
+    index->size++;
+    return t;
+}
+
+// 항목에 기록 행 추가 (행은 늘어나는 순서로 들어오며, 한 답변에 같은 토큰이 여러 번 나와도 한 번만)
+static void searchTermPush(SearchTerm* t, int row) {
+    if (t->count > 0 && t->rows[t->count - 1] == row) return;
+    if (t->count == t->capacity) {
+        int newCapacity = t->capacity ? t->capacity * 2 : 4;
+        int* newRows = realloc(t->rows, sizeof(int) * newCapacity);
+        if (newRows == NULL) outOfMemory();
+        t->rows = newRows;
+        t->capacity = newCapacity;
+    }
+    t->rows[t->count++] = row;
+}
+
+// 항목의 행 목록에 row가 있는지 (이진 탐색)
+static int searchTermHas(const SearchTerm* t, int row) {
+    int lo = 0, hi = t->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (t->rows[mid] < row) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < t->count && t->rows[lo] == row;
+}
+
+static void searchIndexClear(SearchIndex* index) {
+    for (int i = 0; i < index->capacity; i++) free(index->slots[i].rows);
+    free(index->slots);
+    index->slots = NULL;
+    index->capacity = 0;
+    index->size = 0;
+    arenaFree(&index->terms);
+}
+
+static void searchIndexClearAll(GameContext* ctx) {
+    for (int i = 0; i < USER_SHARD_COUNT; i++) searchIndexClear(&ctx->userShards[i].search);
+}
+
+typedef struct {
+    SearchIndex* index;
+    int user;
+    int row;
+} SearchAddTarget;
+
+static void searchAddToken(void* arg, const char* token) {
+    SearchAddTarget* target = arg;
+    searchTermPush(searchIndexAdd(target->index, target->user, token), target->row);
+}
+
+// 기록 행 하나를 색인에 반영 (가입한 사용자의 Truth 답변만, 로드 중이거나 그 사용자의 샤드 잠금 안에서 호출)
+static void searchIndexRow(GameContext* ctx, int row) {
+    const RecordBlock* block = recordBlock(&ctx->records, row);
+    int slot = recordSlot(row);
+    int user = block->user[slot];
+    if (block->type[slot] != 0 || user < 0) return;
+    SearchAddTarget target = { &userShard(ctx, user)->search, user, row };
+    searchTokenize(block->response[slot], searchAddToken, &target);
+}
+
+// 색인 파일이 가리키는 기록이 그대로인지 확인하는 값 (마지막 반영 행의 내용)
+static uint32_t searchRowCheck(GameContext* ctx, int rows) {
+    if (rows == 0) return 0;
+    RecordFields rec;
+    recordFieldsAt(ctx, rows - 1, &rec);
+    return hashString(rec.userId) ^ hashString(rec.response) ^ hashInt(rec.day) ^ hashInt(rec.contentId);
+}
+
+// answers.idx에서 색인 읽기 (반영한 행 수, 파일이 없거나 현재 기록과 맞지 않으면 -1)
+static int loadSearchIndexFile(GameContext* ctx) {
+    size_t size;
+    int mapped;
+    const char* data = mapFile(ctx->paths[DATA_SEARCH_INDEX], &size, &mapped);
+    if (data == NULL) return -1;
+    SearchIndexHeader header;
+    int ok = size >= sizeof(header);
+    if (ok) {
+        memcpy(&header, data, sizeof(header));
+        ok = memcmp(header.magic, SEARCH_INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+             header.version == SEARCH_INDEX_VERSION && header.fileSize == size &&
+             header.rowCount <= (uint32_t)recordCount(&ctx->records) &&
+             header.rowCheck == searchRowCheck(ctx, (int)header.rowCount);
+    }
+    size_t pos = sizeof(header);
+    for (uint32_t k = 0; ok && k < header.termCount; k++) {
+        uint32_t lengths[2]; // 토큰 바이트 수, 행 수
+        char term[SEARCH_TOKEN_MAX + 1];
+        if (size - pos < sizeof(lengths)) { ok = 0; break; }
+        memcpy(lengths, data + pos, sizeof(lengths));
+        pos += sizeof(lengths);
+        if (lengths[0] == 0 || lengths[0] > SEARCH_TOKEN_MAX || lengths[1] == 0 ||
+            size - pos < lengths[0] + (size_t)lengths[1] * sizeof(uint32_t)) {
+            ok = 0;
+            break;
+        }
+        memcpy(term, data + pos, lengths[0]);
+        term[lengths[0]] = '\0';
+        pos += lengths[0];
+        const char* rows = data + pos;
+        pos += (size_t)lengths[1] * sizeof(uint32_t);
+
+        // 모든 행이 같은 가입 사용자의 Truth 기록이고 오름차순이어야 함 (다른 사용자에게 보이지 않도록)
+        int user = -1, prev = -1;
+        int* list = malloc(sizeof(int) * lengths[1]);
+        if (list == NULL) outOfMemory();
+        for (uint32_t i = 0; ok && i < lengths[1]; i++) {
+            uint32_t row;
+            memcpy(&row, rows + i * sizeof(uint32_t), sizeof(row));
+            if (row >= header.rowCount || (int)row <= prev) { ok = 0; break; }
+            const RecordBlock* block = recordBlock(&ctx->records, (int)row);
+            int rowUser = block->user[recordSlot((int)row)];
+            if (i == 0) user = rowUser;
+            if (rowUser < 0 || rowUser != user || block->type[recordSlot((int)row)] != 0) ok = 0;
+            list[i] = prev = (int)row;
+        }
+        SearchIndex* index = ok ? &userShard(ctx, user)->search : NULL;
+        if (!ok || searchIndexFind(index, user, term) != NULL) {
+            free(list);
+            ok = 0;
+            break;
+        }
+        SearchTerm* t = searchIndexAdd(index, user, term);
+        t->rows = list;
+        t->count = t->capacity = (int)lengths[1];
+    }
+    statsIo(ctx, STAT_IO_READ_BYTES, size);
+    unmapFile(data, size, mapped);
+    if (!ok || pos != size) {
+        gameLog(ctx, "답변 색인 파일이 현재 기록과 맞지 않습니다. 다시 만듭니다.\n");
+        searchIndexClearAll(ctx);
+        return -1;
+    }
+    return (int)header.rowCount;
+}
+
+// 답변 색인 준비: 파일에 있는 앞쪽 행은 그대로 읽고 이후 행만 토큰화 (로드 중에 호출)
+static void loadSearchIndex(GameContext* ctx) {
+    searchIndexClearAll(ctx);
+    int rows = recordCount(&ctx->records);
+    ctx->searchFileRows = loadSearchIndexFile(ctx);
+    int first = ctx->searchFileRows < 0 ? 0 : ctx->searchFileRows;
+    for (int row = first; row < rows; row++) searchIndexRow(ctx, row);
+    gameLog(ctx, "답변 색인 준비 완료: 파일 %d행, 새로 색인 %d행\n", first, rows - first);
+}
+
+// 답변 색인을 answers.idx로 저장 (파일 이후로 추가된 기록이 있을 때만, 세션이 모두 끝난 뒤 호출)
+static void saveSearchIndex(GameContext* ctx) {
+    int rows = recordCount(&ctx->records);
+    if (rows == ctx->searchFileRows) return;
+    SearchIndexHeader header = {0};
+    memcpy(header.magic, SEARCH_INDEX_MAGIC, sizeof(header.magic));
+    header.version = SEARCH_INDEX_VERSION;
+    header.rowCount = (uint32_t)rows;
+    header.rowCheck = searchRowCheck(ctx, rows);
+    header.fileSize = sizeof(header);
+    for (int s = 0; s < USER_SHARD_COUNT; s++) {
+        const SearchIndex* index = &ctx->userShards[s].search;
+        header.termCount += (uint32_t)index->size;
+        for (int i = 0; i < index->capacity; i++) {
+            const SearchTerm* t = &index->slots[i];
+            if (t->term != NULL) header.fileSize += 2 * sizeof(uint32_t) + strlen(t->term) + sizeof(uint32_t) * (size_t)t->count;
+        }
+    }
+
+    FILE* fp = fopen(ctx->paths[DATA_SEARCH_INDEX_TEMP], "wb");
+    if (fp == NULL) {
+        gameLog(ctx, "답변 색인 파일을 저장할 수 없습니다.\n");
+        return;
+    }
+    fwrite(&header, sizeof(header), 1, fp);
+    for (int s = 0; s < USER_SHARD_COUNT; s++) {
+        const SearchIndex* index = &ctx->userShards[s].search;
+        for (int i = 0; i < index->capacity; i++) {
+            const SearchTerm* t = &index->slots[i];
+            if (t->term == NULL) continue;
+            uint32_t lengths[2] = { (uint32_t)strlen(t->term), (uint32_t)t->count };
+            fwrite(lengths, sizeof(lengths), 1, fp);
+            fwrite(t->term, 1, lengths[0], fp);
+            fwrite(t->rows, sizeof(int), (size_t)t->count, fp); // int와 uint32는 같은 폭 (행 번호는 음수가 아님)
+        }
+    }
+    int ok = !ferror(fp);
+    statsIo(ctx, STAT_IO_WRITE_BYTES, header.fileSize);
+    syncFile(ctx, fp);
+    fclose(fp);
+#ifdef _WIN32
+    remove(ctx->paths[DATA_SEARCH_INDEX]);
+#endif
+    if (!ok || rename(ctx->paths[DATA_SEARCH_INDEX_TEMP], ctx->paths[DATA_SEARCH_INDEX]) != 0) {
+        gameLog(ctx, "답변 색인 파일을 저장할 수 없습니다.\n");
+        return;
+    }
+    ctx->searchFileRows = rows;
+}
+
+// 검색어 해석 결과
+typedef struct {
+    char tokens[SEARCH_QUERY_TOKENS][SEARCH_TOKEN_MAX + 1]; // 중복 없는 토큰 (모두 들어 있어야 일치)
+    int numTokens;
+    char phraseText[MAX_ANSWER_LEN];            // 세 글자 이상 이어진 n-gram 글자열 (NUL로 나눠 보관)
+    const char* phrases[SEARCH_QUERY_TOKENS];   // 2-gram만으로는 순서를 보장하지 못하므로 답변에서 그대로 확인
+    int numPhrases;
+} SearchQuery;
+
+static void searchQueryToken(void* arg, const char* token) {
+    SearchQuery* query = arg;
+    for (int i = 0; i < query->numTokens; i++) {
+        if (strcmp(query->tokens[i], token) == 0) return;
+    }
+    if (query->numTokens < SEARCH_QUERY_TOKENS) strcpy(query->tokens[query->numTokens++], token);
+}
+
+static void parseSearchQuery(const char* text, SearchQuery* query) {
+    query->numTokens = 0;
+    query->numPhrases = 0;
+    copyString(query->phraseText, text, sizeof(query->phraseText));
+    searchTokenize(query->phraseText, searchQueryToken, query);
+
+    // n-gram 글자가 세 개 이상 이어진 구간을 찾아 그 자리에서 NUL로 끊어 둠
+    unsigned char* p = (unsigned char*)query->phraseText;
+    while (*p) {
+        unsigned int cp;
+        int len = utf8Decode(p, &cp);
+        if (searchCharClass(cp) != SEARCH_CHAR_GRAM) {
+            p += len;
+            continue;
+        }
+        unsigned char* runStart = p;
+        int chars = 0;
+        while (*p && searchCharClass(cp) == SEARCH_CHAR_GRAM) {
+            p += len;
+            chars++;
+            len = utf8Decode(p, &cp);
+        }
+        if (chars < 3 || query->numPhrases == SEARCH_QUERY_TOKENS) continue;
+        query->phrases[query->numPhrases++] = (const char*)runStart;
+        if (*p) *p++ = '\0'; // 구간 뒤 글자는 구분자이거나 단어 글자 (토큰은 이미 뽑았음)
+    }
+}
+
+
+// --- 데이터 로드/저장 함수 ---
+
+// 카테고리 통계 칸 하나의 최대 글자 수: " ID:횟수"
+#define USER_CATEGORY_TEXT_MAX (1 + INT_TEXT_MAX + 1 + INT_TEXT_MAX)
+// 사용자 행 한 줄의 최대 글자 수: ID, 비밀번호, 날짜 4칸, 정수 10칸, "@개수", 16진 키 1칸, 칸 사이 공백 17개와 개행,
+// 카테고리 통계 칸들
+#define USER_ROW_TEXT_MAX ((MAX_ID_LEN - 1) + (MAX_PW_LEN - 1) + 4 * (MAX_DATE_LEN - 1) + 10 * INT_TEXT_MAX + \
+                           (1 + INT_TEXT_MAX) + 8 + 18 + USER_CATEGORY_SLOTS * USER_CATEGORY_TEXT_MAX)
+_Static_assert(USER_ROW_TEXT_MAX <= USER_ROW_WIDTH, "사용자 행이 USER_ROW_WIDTH에 들어가지 않음");
+
+// users.txt 고정 폭 행 만들기 (공백으로 채우고 개행으로 끝냄)
+// 칸 폭은 USER_ROW_TEXT_MAX로 컴파일할 때 확인하므로 넘칠 수 없지만, 넘치면 잘린 행을 쓰지 않고 알림
+static void formatUserRow(GameContext* ctx, char* row, const User* u) {
+    char truthDate[MAX_DATE_LEN], dareDate[MAX_DATE_LEN], streakDate[MAX_DATE_LEN], weekDate[MAX_DATE_LEN];
+    const UserStats* st = &u->stats;
+    formatGameDay(u->lastTruthDay, truthDate);
+    formatGameDay(u->lastDareDay, dareDate);
+    formatGameDay(st->truthStreakDay, streakDate);
+    formatGameDay(st->weekStart, weekDate);
+    // 채운 카테고리 칸만 "@개수 ID:횟수 ..."로 적음
+    char categories[1 + INT_TEXT_MAX + USER_CATEGORY_SLOTS * USER_CATEGORY_TEXT_MAX + 1];
+    int slots = 0;
+    while (slots < USER_CATEGORY_SLOTS && st->categoryDares[slots].category != 0) slots++;
+    int catLen = snprintf(categories, sizeof(categories), "@%d", slots);
+    for (int k = 0; k < slots; k++) {
+        catLen += snprintf(categories + catLen, sizeof(categories) - catLen, " %d:%d",
+                           st->categoryDares[k].category, st->categoryDares[k].dares);
+    }
+    // 앞의 6칸은 예전 형식과 같고, 뒤에 통계 칸(parseUserStats와 같은 순서)과 주머니 칸을 붙임
+    int len = snprintf(row, USER_ROW_WIDTH, "%s %s %d %s %s %d %d %d %d %d %s %s %d %s %d %u %u %x",
+                       u->id, u->password, u->coins, truthDate, dareDate, u->dareAttemptsToday,
+                       st->truthAnswers, st->dareAttempts, st->dareCompletions, st->truthStreak, streakDate, weekDate,
+                       st->weekCoins, categories, u->truthBagFirstId, u->truthBagSpan, u->truthBagCursor, u->truthBagKey);
+    if (len < 0 || len > USER_ROW_WIDTH - 1) {
+        gameLog(ctx, "사용자 행이 %d바이트를 넘습니다: %s\n", USER_ROW_WIDTH - 1, u->id);
+        len = USER_ROW_WIDTH - 1;
+    }
+    memset(row + len, ' ', USER_ROW_WIDTH - 1 - len);
+    row[USER_ROW_WIDTH - 1] = '\n';
+}
+
+// 로그 체크섬 (FNV-1a)
+static uint32_t walChecksum(const char* data, size_t size) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 이전 실행이 행을 쓰다가 중단되었다면 로그에 남은 행을 users.txt에 다시 적용
+// 로그 형식: [행 수 uint32][(행 번호 uint32, 행 USER_ROW_WIDTH바이트) × 행 수][체크섬 uint32]
+// 로그 자체가 잘렸거나 체크섬이 맞지 않으면 users.txt는 건드리지 않은 상태이므로 버림.
+static void recoverUsersWal(GameContext* ctx) {
+    FILE* wal = fopen(ctx->paths[DATA_USERS_WAL], "rb");
+    if (wal == NULL) return;
+    fseek(wal, 0, SEEK_END);
+    long size = ftell(wal);
+    fseek(wal, 0, SEEK_SET);
+    char* data = size > 0 ? malloc(size) : NULL;
+    int valid = 0;
+    uint32_t count = 0;
+    size_t entrySize = sizeof(uint32_t) + USER_ROW_WIDTH;
+    if (data != NULL && fread(data, 1, size, wal) == (size_t)size && size >= (long)(2 * sizeof(uint32_t))) {
+        memcpy(&count, data, sizeof(count));
+        uint32_t checksum;
+        size_t bodySize = sizeof(uint32_t) + (size_t)count * entrySize;
+        if ((size_t)size == bodySize + sizeof(checksum)) {
+            memcpy(&checksum, data + bodySize, sizeof(checksum));
+            valid = checksum == walChecksum(data, bodySize);
+        }
+    }
+    fclose(wal);
+    if (size > 0) statsIo(ctx, STAT_IO_READ_BYTES, (uint64_t)size);
+
+    if (valid) {
+        FILE* fp = fopen(ctx->paths[DATA_USERS], "r+b");
+        if (fp == NULL) fp = fopen(ctx->paths[DATA_USERS], "w+b");
+        if (fp != NULL) {
+            for (uint32_t i = 0; i < count; i++) {
+                const char* entry = data + sizeof(uint32_t) + i * entrySize;
+                uint32_t rowIndex;
+                memcpy(&rowIndex, entry, sizeof(rowIndex));
+                fseek(fp, (long)rowIndex * USER_ROW_WIDTH, SEEK_SET);
+                fwrite(entry + sizeof(uint32_t), 1, USER_ROW_WIDTH, fp);
+            }
+            syncFile(ctx, fp);
+            fclose(fp);
+            gameLog(ctx, "사용자 데이터 복구: %u개 행 재적용\n", count);
+        }
+    }
+    free(data);
+    remove(ctx->paths[DATA_USERS_WAL]);
+}
+
+// 사용자 데이터 로드
+static void loadUsers(GameContext* ctx) {
+    recoverUsersWal(ctx);
+    if (loadUsersFromSnapshot(ctx)) {
+        gameLog(ctx, "사용자 데이터 로드 완료: %d명 (스냅샷)\n", userCount(ctx));
+        return;
+    }
+    FILE* fp = fopen(ctx->paths[DATA_USERS], "r");
+    if (fp == NULL) {
+        gameLog(ctx, "사용자 데이터 파일을 찾을 수 없습니다. 새로운 파일을 생성합니다.\n");
+        return;
+    }
+    userTableClear(ctx);
+    userIndexClear(ctx);
+    User u;
+    int coins, dareAttemptsToday;
+    char truthDate[MAX_DATE_LEN], dareDate[MAX_DATE_LEN];
+    char line[USER_ROW_WIDTH * 2];
+    int numLines = 0;
+    int fixedLayout = 1; // 모든 줄이 고정 폭이면 행 단위 저장 가능
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        numLines++;
+        if (strlen(line) != USER_ROW_WIDTH || line[USER_ROW_WIDTH - 1] != '\n') fixedLayout = 0;
+        int consumed = 0;
+        if (sscanf(line, "%49s %49s %d %14s %14s %d%n",
+                   u.id, u.password, &coins, truthDate, dareDate, &dareAttemptsToday, &consumed) != 6) {
+            fixedLayout = 0;
+            continue;
+        }
+        int statsConsumed;
+        u.statsStale = !parseUserStats(line + consumed, &u.stats, &statsConsumed); // 예전 형식이면 기록을 읽은 뒤 다시 계산
+        parseUserTruthBag(u.statsStale ? "" : line + consumed + statsConsumed, &u);
+        u.lastTruthDay = parseUserDay(truthDate);
+        u.lastDareDay = parseUserDay(dareDate);
+        u.coins = coins;
+        u.dareAttemptsToday = dareAttemptsToday;
+        if (findUserIndex(ctx, u.id) >= 0) continue; // 중복 ID는 처음 것만 사용
+        u.dirty = 0;
+        User* slot = userPush(ctx);
+        if (slot == NULL) sharedUsersFull(ctx);
+        *slot = u;
+        registerNewUser(ctx);
+    }
+    statsIo(ctx, STAT_IO_READ_BYTES, (uint64_t)ftell(fp));
+    fclose(fp);
+    ctx->usersFileFixedLayout = fixedLayout && numLines == userCount(ctx);
+    gameLog(ctx, "사용자 데이터 로드 완료: %d명\n", userCount(ctx));
+}
+
+// 사용자 데이터 전체 재작성 (임시 파일에 고정 폭으로 쓴 뒤 교체)
+static void rewriteUsersFile(GameContext* ctx) {
+    uint64_t start = statsBegin(ctx);
+    FILE* fp = fopen(ctx->paths[DATA_USERS_TEMP], "wb");
+    if (fp == NULL) {
+        gameLog(ctx, "사용자 데이터 파일을 저장할 수 없습니다.\n");
+        return;
+    }
+    char row[USER_ROW_WIDTH];
+    int numUsers = userCount(ctx); // 공유 사용자 표에서 이후에 추가된 행은 dirty 표시로 따로 저장됨
+    for (int i = 0; i < numUsers; i++) {
+        formatUserRow(ctx, row, userAt(ctx, i));
+        fwrite(row, 1, USER_ROW_WIDTH, fp);
+    }
+    statsIo(ctx, STAT_IO_WRITE_BYTES, (uint64_t)numUsers * USER_ROW_WIDTH);
+    syncFile(ctx, fp);
+    fclose(fp);
+#ifdef _WIN32
+    remove(ctx->paths[DATA_USERS]);
+#endif
+    if (rename(ctx->paths[DATA_USERS_TEMP], ctx->paths[DATA_USERS]) != 0) {
+        gameLog(ctx, "사용자 데이터 파일을 교체할 수 없습니다.\n");
+        return;
+    }
+    for (int s = 0; s < USER_SHARD_COUNT; s++) {
+        UserShard* shard = &ctx->userShards[s];
+        for (int i = 0; i < shard->numDirtyUsers; i++) {
+            userAt(ctx, shard->dirtyUsers[i])->dirty = 0;
+        }
+        shard->numDirtyUsers = 0;
+    }
+    ctx->usersFileFixedLayout = 1;
+    statsEnd(ctx, STAT_REWRITE_USERS, start);
+    gameLog(ctx, "사용자 데이터 저장 완료.\n");
+}
+
+// 사용자 행들을 제자리에 덮어씀 (저장 스레드에서 호출)
+// 행을 쓰기 전에 같은 내용을 로그에 먼저 기록하므로 쓰는 도중 중단되어도
+// 다음 시작 시 recoverUsersWal()이 행을 다시 적용한다.
+// sync가 0이면 fsync를 생략 (프로세스 중단에는 안전, 전원 장애 시 순서 보장 없음)
+static void writeUserRows(GameContext* ctx, int count, const uint32_t* rowIndex, const char* rows, int sync) {
+    uint64_t start = statsBegin(ctx);
+    size_t entrySize = sizeof(uint32_t) + USER_ROW_WIDTH;
+    size_t bodySize = sizeof(uint32_t) + (size_t)count * entrySize;
+    char* wal = malloc(bodySize + sizeof(uint32_t));
+    if (wal == NULL) return;
+    uint32_t numRows = (uint32_t)count;
+    memcpy(wal, &numRows, sizeof(numRows));
+    for (int i = 0; i < count; i++) {
+        char* entry = wal + sizeof(uint32_t) + i * entrySize;
+        memcpy(entry, &rowIndex[i], sizeof(uint32_t));
+        memcpy(entry + sizeof(uint32_t), rows + (size_t)i * USER_ROW_WIDTH, USER_ROW_WIDTH);
+    }
+    uint32_t checksum = walChecksum(wal, bodySize);
+    memcpy(wal + bodySize, &checksum, sizeof(checksum));
+
+    FILE* walFile = fopen(ctx->paths[DATA_USERS_WAL], "wb");
+    FILE* fp = fopen(ctx->paths[DATA_USERS], "r+b");
+    if (walFile == NULL || fp == NULL) {
+        if (walFile != NULL) fclose(walFile);
+        if (fp != NULL) fclose(fp);
+        free(wal);
+        gameLog(ctx, "사용자 데이터 파일을 저장할 수 없습니다.\n");
+        return;
+    }
+    fwrite(wal, 1, bodySize + sizeof(checksum), walFile);
+    if (sync) syncFile(ctx, walFile); // 로그가 디스크에 남은 뒤에만 본 파일을 건드림
+    fclose(walFile);
+
+    for (int i = 0; i < count; i++) {
+        fseek(fp, (long)rowIndex[i] * USER_ROW_WIDTH, SEEK_SET);
+        fwrite(rows + (size_t)i * USER_ROW_WIDTH, 1, USER_ROW_WIDTH, fp);
+    }
+    if (sync) syncFile(ctx, fp);
+    fclose(fp);
+    remove(ctx->paths[DATA_USERS_WAL]); // 본 파일에 반영되었으므로 로그 폐기
+    free(wal);
+    statsIo(ctx, STAT_IO_WRITE_BYTES, bodySize + sizeof(checksum) + (uint64_t)count * USER_ROW_WIDTH);
+    statsEnd(ctx, STAT_WRITE_USER_ROWS, start);
+}
+
+
+// 공백으로 끝나는 토큰 하나를 건너뛰고 다음 토큰 시작 반환 (*end에 토큰 끝)
+static char* skipContentToken(char* p, char** end) {
+    while (*p != '\0' && !isspace((unsigned char)*p)) p++;
+    *end = p;
+    while (isspace((unsigned char)*p)) p++;
+    return p;
+}
+
+// truth_questions.txt의 "ID 질문" 줄을 빌더에 추가 (파일이 없으면 0)
+static int parseTruthQuestions(GameContext* ctx, ContentBuilder* b) {
+    FILE* fp = fopen(ctx->paths[DATA_TRUTH_QUESTIONS], "r");
+    if (fp == NULL) return 0;
+    char* line = NULL;
+    size_t capacity = 0;
+    while (readContentLine(fp, &line, &capacity)) {
+        char* end;
+        long id = strtol(line, &end, 10);
+        if (end == line || !isspace((unsigned char)*end)) continue;
+        char* question = skipContentToken(end, &end);
+        if (*question == '\0') continue;
+        contentAddTruth(b, (int)id, question);
+    }
+    statsIo(ctx, STAT_IO_READ_BYTES, (uint64_t)ftell(fp));
+    free(line);
+    fclose(fp);
+    return 1;
+}
+
+// dare_challenges.txt의 "ID 카테고리 [*가중치] 도전" 줄을 빌더에 추가 (파일이 없으면 0, 가중치가 없으면 1)
+static int parseDareChallenges(GameContext* ctx, ContentBuilder* b) {
+    FILE* fp = fopen(ctx->paths[DATA_DARE_CHALLENGES], "r");
+    if (fp == NULL) return 0;
+    char* line = NULL;
+    size_t capacity = 0;
+    while (readContentLine(fp, &line, &capacity)) {
+        char* end;
+        long id = strtol(line, &end, 10);
+        if (end == line || !isspace((unsigned char)*end)) continue;
+        char* category = skipContentToken(end, &end);
+        char* challenge = skipContentToken(category, &end);
+        if (*category == '\0' || *challenge == '\0') continue;
+        char* categoryEnd = end;
+        long weight = 1;
+        if (challenge[0] == '*' && isdigit((unsigned char)challenge[1])) { // 선택 칸 "*가중치"
+            char* weightEnd;
+            long value = strtol(challenge + 1, &weightEnd, 10);
+            if (isspace((unsigned char)*weightEnd)) {
+                weight = value > MAX_DARE_WEIGHT ? MAX_DARE_WEIGHT : value;
+                challenge = skipContentToken(challenge, &weightEnd);
+                if (*challenge == '\0') continue;
+            }
+        }
+        *categoryEnd = '\0';
+        contentAddDare(b, (int)id, category, challenge, (int)weight);
+    }
+    statsIo(ctx, STAT_IO_READ_BYTES, (uint64_t)ftell(fp));
+    free(line);
+    fclose(fp);
+    return 1;
+}
+
+// Truth 질문 로드
+static void loadTruthQuestions(GameContext* ctx, ContentBuilder* b) {
+    if (loadTruthQuestionsFromSnapshot(ctx, b)) {
+        gameLog(ctx, "Truth 질문 로드 완료: %d개 (스냅샷)\n", b->truthCount);
+        return;
+    }
+    if (!parseTruthQuestions(ctx, b)) {
+        gameLog(ctx, "Truth 질문 파일을 찾을 수 없습니다. 기본 질문을 사용합니다.\n");
+        // 기본 질문 설정 (파일이 없을 경우)
+        contentAddTruth(b, 1, "오늘 가장 감사했던 일은 무엇인가요?");
+        contentAddTruth(b, 2, "최근 자신을 성장시켰다고 생각하는 경험은 무엇인가요?");
+        contentAddTruth(b, 3, "오늘 하루 느꼈던 감정을 색깔로 표현한다면 어떤 색깔인가요?");
+        return;
+    }
+    gameLog(ctx, "Truth 질문 로드 완료: %d개\n", b->truthCount);
+}
+
+// Dare 도전 로드
+static void loadDareChallenges(GameContext* ctx, ContentBuilder* b) {
+    if (loadDareChallengesFromSnapshot(ctx, b)) {
+        gameLog(ctx, "Dare 도전 로드 완료: %d개 (스냅샷)\n", b->dareCount);
+        return;
+    }
+    if (!parseDareChallenges(ctx, b)) {
+        gameLog(ctx, "Dare 도전 파일을 찾을 수 없습니다. 기본 도전을 사용합니다.\n");
+        // 기본 도전 설정 (파일이 없을 경우)
+        contentAddDare(b, 101, "신체", "팔굽혀펴기 10개 하기", 1);
+        contentAddDare(b, 102, "학습", "새로운 단어 5개 외우기", 1);
+        contentAddDare(b, 103, "정서", "거울 보고 자신에게 칭찬 한마디 하기", 1);
+        return;
+    }
+    gameLog(ctx, "Dare 도전 로드 완료: %d개\n", b->dareCount);
+}
+
+// 콘텐츠 로드 (시작 시): 카탈로그 파일이 있으면 매핑하고, 없으면 스냅샷/텍스트에서 새 판을 만들어 공개
+static void loadContent(GameContext* ctx) {
+    ContentTable* table = openContentCatalog(ctx);
+    if (table != NULL) {
+        gameLog(ctx, "콘텐츠 카탈로그 로드 완료: Truth 질문 %d개, Dare 도전 %d개\n", table->truthCount, table->dareCount);
+    } else {
+        ContentBuilder b;
+        contentBuilderInit(&b);
+        loadTruthQuestions(ctx, &b);
+        loadDareChallenges(ctx, &b);
+        table = buildContentTable(ctx, &b, NULL);
+    }
+    contentPublish(ctx, table);
+}
+
+// 콘텐츠 파일이 바뀌었을 때 새 판을 만들어 교체 (감시 스레드에서 호출)
+// 카탈로그가 텍스트 파일보다 새로우면 카탈로그를, 아니면 텍스트를 읽으며,
+// 실행 중에 텍스트 파일이 지워졌으면 기본값 대신 지금 판의 내용을 그대로 옮긴다.
+static void reloadContent(GameContext* ctx) {
+    uint64_t start = statsBegin(ctx);
+    ContentTable* table = openContentCatalog(ctx);
+    if (table == NULL) {
+        const ContentTable* current = atomic_load(&ctx->content); // 판을 해제하는 쪽이 이 스레드이므로 표시 없이 읽음
+        ContentBuilder b;
+        contentBuilderInit(&b);
+        if (!parseTruthQuestions(ctx, &b)) {
+            for (int i = 0; i < current->truthCount; i++) {
+                TruthQuestion q = truthAt(current, i);
+                contentAddTruth(&b, q.id, q.question);
+            }
+        }
+        if (!parseDareChallenges(ctx, &b)) {
+            for (int i = 0; i < current->dareCount; i++) {
+                DareChallenge d = dareAt(current, i);
+                contentAddDare(&b, d.id, d.category, d.challenge, d.weight);
+            }
+        }
+        table = buildContentTable(ctx, &b, current);
+    }
+    contentPublish(ctx, table);
+    statsEnd(ctx, STAT_LOAD_CONTENT, start);
+    gameLog(ctx, "콘텐츠 다시 로드: Truth 질문 %d개, Dare 도전 %d개 (판 %llu%s)\n", table->truthCount,
+            table->dareCount, (unsigned long long)table->version, table->fromCatalog ? ", 카탈로그" : "");
+}
+
+// Truth 질문 저장 (스냅샷을 텍스트로 되돌릴 때 사용)
+static void saveTruthQuestions(GameContext* ctx) {
+    FILE* fp = fopen(ctx->paths[DATA_TRUTH_QUESTIONS], "w");
+    if (fp == NULL) {
+        gameLog(ctx, "Truth 질문 파일을 저장할 수 없습니다.\n");
+        return;
+    }
+    const ContentTable* content = contentAcquire(ctx);
+    for (int i = 0; i < content->truthCount; i++) {
+        TruthQuestion q = truthAt(content, i);
+        fprintf(fp, "%d %s\n", q.id, q.question);
+    }
+    fclose(fp);
+}
+
+// Dare 도전 저장 (스냅샷을 텍스트로 되돌릴 때 사용)
+static void saveDareChallenges(GameContext* ctx) {
+    FILE* fp = fopen(ctx->paths[DATA_DARE_CHALLENGES], "w");
+    if (fp == NULL) {
+        gameLog(ctx, "Dare 도전 파일을 저장할 수 없습니다.\n");
+        return;
+    }
+    const ContentTable* content = contentAcquire(ctx);
+    for (int i = 0; i < content->dareCount; i++) {
+        DareChallenge d = dareAt(content, i);
+        int plain = d.weight == 1 && !(d.challenge[0] == '*' && isdigit((unsigned char)d.challenge[1])); // "*숫자"로 시작하는 도전은 가중치와 헷갈리지 않게
+        if (plain) fprintf(fp, "%d %s %s\n", d.id, d.category, d.challenge);
+        else fprintf(fp, "%d %s *%d %s\n", d.id, d.category, d.weight, d.challenge);
+    }
+    fclose(fp);
+}
+
+// 질문/도전 텍스트 파일을 읽어 카탈로그 파일 작성 (임시 파일에 쓴 뒤 교체)
+int buildContentCatalog(GameContext* ctx) {
+    ContentBuilder b;
+    contentBuilderInit(&b);
+    if (!parseTruthQuestions(ctx, &b) || !parseDareChallenges(ctx, &b)) {
+        gameLog(ctx, "Truth 질문 파일과 Dare 도전 파일이 모두 있어야 콘텐츠 카탈로그를 만들 수 있습니다.\n");
+        contentBuilderFree(&b);
+        return 0;
+    }
+    size_t size;
+    char* image = buildContentImage(ctx, &b, NULL, &size);
+    const CatalogHeader* header = (const CatalogHeader*)image;
+    int ok = 0;
+    FILE* fp = fopen(ctx->paths[DATA_CATALOG_TEMP], "wb");
+    if (fp != NULL) {
+        ok = fwrite(image, 1, size, fp) == size;
+        statsIo(ctx, STAT_IO_WRITE_BYTES, size);
+        syncFile(ctx, fp);
+        fclose(fp);
+#ifdef _WIN32
+        remove(ctx->paths[DATA_CATALOG]);
+#endif
+        ok = ok && rename(ctx->paths[DATA_CATALOG_TEMP], ctx->paths[DATA_CATALOG]) == 0;
+    }
+    if (ok) {
+        gameLog(ctx, "콘텐츠 카탈로그 저장 완료: Truth 질문 %u개, Dare 도전 %u개, 카테고리 %u개, 문자열 %llu바이트\n",
+                header->truthCount, header->dareCount, header->categoryCount, (unsigned long long)header->stringsSize);
+    } else {
+        gameLog(ctx, "콘텐츠 카탈로그 파일을 저장할 수 없습니다.\n");
+    }
+    free(image);
+    return ok;
+}
+
+
+// --- 콘텐츠 파일 감시 ---
+// startGame 이후 데이터 디렉터리를 inotify로 지켜보다가 질문/도전 파일이나 카탈로그가 바뀌면 새 판으로 교체한다.
+// 편집기는 파일을 여러 번에 나눠 쓰거나 임시 파일을 옮겨 오므로, 마지막 변경 뒤 CONTENT_POLL_MS 동안
+// 조용해지면 한 번만 다시 읽는다.
+
+#ifdef __linux__
+// 이벤트가 질문/도전 파일이나 카탈로그에 대한 것인지
+static int isContentFileEvent(const struct inotify_event* ev) {
+    return ev->len > 0 && (strcmp(ev->name, dataFileNames[DATA_TRUTH_QUESTIONS]) == 0 ||
+                           strcmp(ev->name, dataFileNames[DATA_DARE_CHALLENGES]) == 0 ||
+                           strcmp(ev->name, dataFileNames[DATA_CATALOG]) == 0);
+}
+
+static void* contentWatcherMain(void* arg) {
+    GameContext* ctx = arg;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int pending = 0;
+    while (!atomic_load(&ctx->contentStopping)) {
+        struct pollfd pfd = { ctx->contentWatchFd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, CONTENT_POLL_MS);
+        if (ready > 0) {
+            ssize_t len;
+            while ((len = read(ctx->contentWatchFd, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + len; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+                    if (isContentFileEvent((struct inotify_event*)p)) pending = 1;
+                }
+            }
+            continue;
+        }
+        if (ready < 0 && errno != EINTR) break;
+        if (pending) {
+            pending = 0;
+            reloadContent(ctx);
+        }
+        if (ctx->retiredContent != NULL) { // 예전 판을 읽던 스레드가 다른 판으로 옮겨 갔으면 해제
+            gameLock(&ctx->contentLock);
+            contentReclaim(ctx);
+            gameUnlock(&ctx->contentLock);
+        }
+    }
+    return NULL;
+}
+#endif
+
+// 감시 시작 (inotify를 쓸 수 없으면 다시 시작할 때까지 콘텐츠가 바뀌지 않음)
+static void contentWatchStart(GameContext* ctx) {
+#ifdef __linux__
+    if (ctx->contentRunning) return;
+    ctx->contentWatchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (ctx->contentWatchFd < 0) return;
+    if (inotify_add_watch(ctx->contentWatchFd, ctx->dataDir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) < 0) {
+        gameLog(ctx, "콘텐츠 파일 감시를 시작할 수 없습니다: %s\n", ctx->dataDir);
+        close(ctx->contentWatchFd);
+        ctx->contentWatchFd = -1;
+        return;
+    }
+    atomic_store(&ctx->contentStopping, 0);
+    if (pthread_create(&ctx->contentThread, NULL, contentWatcherMain, ctx) == 0) {
+        ctx->contentRunning = 1;
+    } else {
+        close(ctx->contentWatchFd);
+        ctx->contentWatchFd = -1;
+    }
+#else
+    (void)ctx;
+#endif
+}
+
+static void contentWatchStop(GameContext* ctx) {
+#ifdef __linux__
+    if (!ctx->contentRunning) return;
+    atomic_store(&ctx->contentStopping, 1);
+    pthread_join(ctx->contentThread, NULL); // poll 제한 시간 안에 깨어남
+    ctx->contentRunning = 0;
+    close(ctx->contentWatchFd);
+    ctx->contentWatchFd = -1;
+#else
+    (void)ctx;
+#endif
+}
+
+
+// 기록 한 줄을 파싱 (성공 시 1)
+// 형식: userId date type contentId coinsEarned response
+// 줄 버퍼를 고쳐 쓰며 파싱하므로 rec의 문자열은 line을 가리킨다 (날짜를 해석할 수 없는 줄은 실패).
+static int parseRecordLine(char* line, RecordFields* rec) {
+    char date[MAX_DATE_LEN];
+    int idStart = 0, idEnd = 0, consumed = 0;
+    if (sscanf(line, " %n%*49s%n %14s %d %d %d %n",
+               &idStart, &idEnd, date, &rec->type, &rec->contentId, &rec->coinsEarned, &consumed) != 4 ||
+        consumed == 0 || !parseDay(date, &rec->day)) {
+        return 0;
+    }
+    line[idEnd] = '\0'; // ID 뒤의 공백
+    rec->userId = line + idStart;
+    char* response = line + consumed;
+    removeNewline(response);
+    if (strlen(response) > MAX_ANSWER_LEN - 1) response[MAX_ANSWER_LEN - 1] = '\0';
+    rec->response = response;
+    return 1;
+}
+
+// 기록 한 줄을 버퍼에 만들기 (개행 포함 길이 반환)
+static size_t formatRecordLine(char* buf, size_t size, const RecordFields* rec) {
+    char date[MAX_DATE_LEN];
+    formatGameDay(rec->day, date);
+    int len = snprintf(buf, size, "%s %s %d %d %d %s\n",
+                       rec->userId, date, rec->type, rec->contentId, rec->coinsEarned, rec->response);
+    if (len < 0) return 0;
+    if ((size_t)len >= size) { // 잘렸으면 개행으로 끝나도록 보정
+        len = (int)size - 1;
+        buf[len - 1] = '\n';
+    }
+    return (size_t)len;
+}
+
+// 기록 한 줄을 파일에 출력
+static void writeRecordLine(FILE* fp, const RecordFields* rec) {
+    char date[MAX_DATE_LEN];
+    formatGameDay(rec->day, date);
+    fprintf(fp, "%s %s %d %d %d %s\n",
+            rec->userId, date, rec->type, rec->contentId, rec->coinsEarned, rec->response);
+}
+
+// 저널 재생: 압축본 이후에 추가된 기록을 기록 저장소 뒤에 이어 붙임
+// 저널 첫 줄은 "#base N" 헤더로, 이 저널이 N개의 기록을 가진 압축본 위에 쌓인 것임을 나타냄.
+// 압축 도중 중단되어 압축본이 더 최신이면 이미 반영된 앞부분을 건너뜀.
+static int replayRecordJournal(GameContext* ctx) {
+    FILE* fp = fopen(ctx->paths[DATA_RECORDS_JOURNAL], "r");
+    if (fp == NULL) return 0;
+
+    char line[MAX_ID_LEN + MAX_DATE_LEN + MAX_ANSWER_LEN + 64];
+    RecordFields rec;
+    int journalBase = ctx->baseRecordCount;
+    int skip = 0;
+    int replayed = 0;
+    int first = 1;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (first) {
+            first = 0;
+            if (sscanf(line, "#base %d", &journalBase) == 1) {
+                skip = ctx->baseRecordCount - journalBase;
+                continue;
+            }
+        }
+        if (strchr(line, '\n') == NULL) break; // 마지막 줄이 잘린 경우 (쓰기 도중 중단)
+        if (!parseRecordLine(line, &rec)) continue;
+        if (skip > 0) { // 이미 압축본에 포함된 기록
+            skip--;
+            continue;
+        }
+        recordPush(ctx, &rec, -1);
+        replayed++;
+    }
+    statsIo(ctx, STAT_IO_READ_BYTES, (uint64_t)ftell(fp));
+    fclose(fp);
+    return replayed;
+}
+
+// recIdx번째 기록을 userIdx 사용자의 기록 목록에 날짜순으로 추가 (사용자 샤드 잠금 안에서 호출)
+// 새 기록은 보통 가장 최근 날짜이므로 끝에 붙이고, 과거 날짜일 때만 이진 탐색 후 삽입
+static void insertUserRecordIndex(GameContext* ctx, int userIdx, int recIdx) {
+    const RecordStore* store = &ctx->records;
+    int day = recordBlock(store, recIdx)->day[recordSlot(recIdx)];
+    RecordList* list = recordListAt(ctx, userIdx);
+    if (list->count == list->capacity) {
+        int newCapacity = list->capacity ? list->capacity * 2 : 8;
+        int* newItems = realloc(list->items, sizeof(int) * newCapacity);
+        if (newItems == NULL) outOfMemory();
+        list->items = newItems;
+        list->capacity = newCapacity;
+    }
+
+    int pos = list->count;
+    int last = pos > 0 ? list->items[pos - 1] : 0;
+    if (pos > 0 && recordBlock(store, last)->day[recordSlot(last)] > day) {
+        int lo = 0, hi = list->count; // 날짜가 day보다 늦은 첫 위치
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            int midRow = list->items[mid];
+            if (recordBlock(store, midRow)->day[recordSlot(midRow)] > day) hi = mid;
+            else lo = mid + 1;
+        }
+        pos = lo;
+        memmove(&list->items[pos + 1], &list->items[pos], sizeof(int) * (list->count - pos));
+    }
+    list->items[pos] = recIdx;
+    list->count++;
+}
+
+// 전체 기록으로 사용자별 기록 목록 재구성 (로드 중, 사용자 항목만 블록 단위로 훑음)
+static void rebuildUserRecordLists(GameContext* ctx) {
+    for (int i = 0; i < ctx->userRecordLists.count; i++) {
+        recordListAt(ctx, i)->count = 0;
+    }
+    int count = recordCount(&ctx->records);
+    for (int base = 0; base < count; base += RECORD_BLOCK_ROWS) {
+        const int32_t* users = recordBlock(&ctx->records, base)->user;
+        int rows = count - base < RECORD_BLOCK_ROWS ? count - base : RECORD_BLOCK_ROWS;
+        for (int i = 0; i < rows; i++) {
+            if (users[i] >= 0) insertUserRecordIndex(ctx, users[i], base + i); // 음수: 등록되지 않은 사용자의 기록
+        }
+    }
+}
+
+// 사용자 기록 로드 (압축본 + 저널 재생)
+static void loadUserRecords(GameContext* ctx) {
+    recordStoreClear(&ctx->records);
+    ctx->baseRecordCount = 0;
+    FILE* fp = NULL;
+    if (loadUserRecordsFromSnapshot(ctx)) {
+        ctx->baseRecordCount = recordCount(&ctx->records);
+    } else if ((fp = fopen(ctx->paths[DATA_RECORDS], "r")) == NULL) {
+        gameLog(ctx, "기록 데이터 파일을 찾을 수 없습니다. 새로운 파일을 생성합니다.\n");
+    } else {
+        char line[MAX_ID_LEN + MAX_DATE_LEN + MAX_ANSWER_LEN + 64];
+        RecordFields rec;
+        while (fgets(line, sizeof(line), fp) != NULL) {
+            if (parseRecordLine(line, &rec)) {
+                recordPush(ctx, &rec, -1);
+            }
+        }
+        statsIo(ctx, STAT_IO_READ_BYTES, (uint64_t)ftell(fp));
+        fclose(fp);
+        ctx->baseRecordCount = recordCount(&ctx->records);
+    }
+    int replayed = replayRecordJournal(ctx);
+    rebuildUserRecordLists(ctx);
+    gameLog(ctx, "기록 데이터 로드 완료: %d개 (저널 %d개, 메모리 %zuKB)\n",
+            recordCount(&ctx->records), replayed, recordStoreBytes(&ctx->records) / 1024);
+}
+
+// 저널을 append 모드로 열기 (비어 있으면 헤더 기록)
+static int openRecordJournal(GameContext* ctx) {
+    if (ctx->recordsJournal != NULL) return 1;
+    ctx->recordsJournal = fopen(ctx->paths[DATA_RECORDS_JOURNAL], "a+");
+    if (ctx->recordsJournal == NULL) {
+        gameLog(ctx, "기록 저널 파일을 열 수 없습니다.\n");
+        return 0;
+    }
+    fseek(ctx->recordsJournal, 0, SEEK_END);
+    long size = ftell(ctx->recordsJournal);
+    if (size == 0) {
+        fprintf(ctx->recordsJournal, "#base %d\n", ctx->baseRecordCount);
+    } else {
+        // 이전 실행이 줄 중간에서 끊겼다면 새 기록이 그 줄에 붙지 않도록 개행 보충
+        fseek(ctx->recordsJournal, -1, SEEK_END);
+        if (fgetc(ctx->recordsJournal) != '\n') {
+            fseek(ctx->recordsJournal, 0, SEEK_END);
+            fputc('\n', ctx->recordsJournal);
+        }
+    }
+    fflush(ctx->recordsJournal);
+    return 1;
+}
+
+// 미리 만든 기록 줄들을 저널 끝에 한 번에 추가 (저장 스레드에서 호출)
+static void journalAppend(GameContext* ctx, const char* lines, size_t size, int sync) {
+    if (!openRecordJournal(ctx)) return;
+    uint64_t start = statsBegin(ctx);
+#ifdef __linux__
+    if (ctx->shared.users != NULL) {
+        // 다른 프로세스도 같은 저널 끝에 붙이므로 줄이 섞이지 않도록 O_APPEND 쓰기 한 번으로
+        fflush(ctx->recordsJournal);
+        if (write(fileno(ctx->recordsJournal), lines, size) != (ssize_t)size) {
+            gameLog(ctx, "기록 저널에 쓸 수 없습니다.\n");
+        }
+    } else
+#endif
+    fwrite(lines, 1, size, ctx->recordsJournal);
+    fflush(ctx->recordsJournal);
+    if (sync) syncFile(ctx, ctx->recordsJournal);
+    statsIo(ctx, STAT_IO_WRITE_BYTES, size);
+    statsEnd(ctx, STAT_JOURNAL_APPEND, start);
+}
+
+// 저널 닫기
+static void closeRecordJournal(GameContext* ctx) {
+    if (ctx->recordsJournal == NULL) return;
+    syncFile(ctx, ctx->recordsJournal);
+    fclose(ctx->recordsJournal);
+    ctx->recordsJournal = NULL;
+}
+
+// 기록 압축: 전체 기록을 임시 파일에 쓴 뒤 교체하고 저널을 비움
+void compactUserRecords(GameContext* ctx) {
+    if (ctx->shared.users != NULL) { // 다른 프로세스가 저널에 계속 붙이고 있을 수 있음
+        gameLog(ctx, "공유 사용자 표를 쓰는 동안에는 기록을 압축하지 않습니다.\n");
+        return;
+    }
+    uint64_t start = statsBegin(ctx);
+    closeRecordJournal(ctx);
+
+    FILE* fp = fopen(ctx->paths[DATA_RECORDS_TEMP], "w");
+    if (fp == NULL) {
+        gameLog(ctx, "기록 데이터 파일을 저장할 수 없습니다.\n");
+        return;
+    }
+    int count = recordCount(&ctx->records);
+    for (int i = 0; i < count; i++) {
+        RecordFields rec;
+        recordFieldsAt(ctx, i, &rec);
+        writeRecordLine(fp, &rec);
+    }
+    statsIo(ctx, STAT_IO_WRITE_BYTES, (uint64_t)ftell(fp));
+    syncFile(ctx, fp);
+    fclose(fp);
+#ifdef _WIN32
+    remove(ctx->paths[DATA_RECORDS]); // Windows의 rename은 대상 파일이 있으면 실패
+#endif
+    if (rename(ctx->paths[DATA_RECORDS_TEMP], ctx->paths[DATA_RECORDS]) != 0) {
+        gameLog(ctx, "기록 데이터 파일을 교체할 수 없습니다.\n");
+        return;
+    }
+    ctx->baseRecordCount = count;
+
+    // 새 압축본 기준으로 저널 초기화 (여기서 중단되어도 헤더 덕분에 중복 재생되지 않음)
+    fp = fopen(ctx->paths[DATA_RECORDS_JOURNAL], "w");
+    if (fp != NULL) {
+        fprintf(fp, "#base %d\n", ctx->baseRecordCount);
+        syncFile(ctx, fp);
+        fclose(fp);
+    }
+    statsEnd(ctx, STAT_COMPACT_RECORDS, start);
+    gameLog(ctx, "기록 데이터 압축 완료: %d개\n", count);
+}
+
+
+// --- 비동기 저장 ---
+// 핸들러는 바뀐 내용(기록 한 줄, 사용자 행)을 문자열로 만들어 고정 크기 무잠금 큐에 넣기만 하고
+// 바로 다음 화면으로 넘어간다. 저장 스레드가 큐에 쌓인 항목을 한꺼번에 꺼내
+// 같은 사용자 행은 마지막 것만 남기고(병합) 한 번의 쓰기와 한 번의 fsync로 커밋한다(그룹 커밋).
+
+#ifndef _WIN32
+// 큐에서 항목 하나 꺼내기 (비어 있으면 0)
+static int persistDequeue(GameContext* ctx, PersistEntry* out) {
+    size_t pos = atomic_load_explicit(&ctx->persistQueue.dequeuePos, memory_order_relaxed);
+    for (;;) {
+        PersistCell* cell = &ctx->persistQueue.cells[pos & (PERSIST_QUEUE_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ctx->persistQueue.dequeuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *out = cell->entry;
+                atomic_store_explicit(&cell->sequence, pos + PERSIST_QUEUE_SIZE, memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&ctx->persistQueue.dequeuePos, memory_order_relaxed);
+        }
+    }
+}
+
+// 큐에 항목 넣기 (가득 차 있으면 0)
+static int persistEnqueue(GameContext* ctx, const PersistEntry* entry) {
+    size_t pos = atomic_load_explicit(&ctx->persistQueue.enqueuePos, memory_order_relaxed);
+    for (;;) {
+        PersistCell* cell = &ctx->persistQueue.cells[pos & (PERSIST_QUEUE_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ctx->persistQueue.enqueuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                cell->entry = *entry;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&ctx->persistQueue.enqueuePos, memory_order_relaxed);
+        }
+    }
+}
+
+// 잠들어 있는 저장 스레드 깨우기
+static void persistWakeWriter(GameContext* ctx) {
+    if (atomic_load(&ctx->persistQueue.writerSleeping)) {
+        pthread_mutex_lock(&ctx->persistMutex);
+        pthread_cond_signal(&ctx->persistWakeCond);
+        pthread_mutex_unlock(&ctx->persistMutex);
+    }
+}
+#endif
+
+// 꺼낸 항목들을 한 번에 파일에 반영 (그룹 커밋)
+static void persistApply(GameContext* ctx, PersistEntry* entries, int count) {
+    uint64_t start = statsBegin(ctx);
+    char* lines = NULL;
+    size_t linesSize = 0;
+    int numRows = 0;
+    uint32_t* rowIndex = malloc(sizeof(uint32_t) * count);
+    char* rows = malloc((size_t)USER_ROW_WIDTH * count);
+    if (rowIndex == NULL || rows == NULL) outOfMemory();
+
+    // 기록 줄은 순서대로 이어 붙이고, 사용자 행은 같은 행이면 마지막 내용만 남김
+    size_t totalLines = 0;
+    for (int i = 0; i < count; i++) {
+        if (entries[i].type == PERSIST_RECORD) totalLines += entries[i].length;
+    }
+    if (totalLines > 0) {
+        lines = malloc(totalLines);
+        if (lines == NULL) outOfMemory();
+    }
+    for (int i = 0; i < count; i++) {
+        PersistEntry* e = &entries[i];
+        if (e->type == PERSIST_RECORD) {
+            memcpy(lines + linesSize, e->data, e->length);
+            linesSize += e->length;
+        } else if (e->type == PERSIST_USER_ROW) {
+            int slot = numRows;
+            for (int j = 0; j < numRows; j++) {
+                if (rowIndex[j] == e->rowIndex) {
+                    slot = j;
+                    break;
+                }
+            }
+            if (slot == numRows) rowIndex[numRows++] = e->rowIndex;
+            memcpy(rows + (size_t)slot * USER_ROW_WIDTH, e->data, USER_ROW_WIDTH);
+        }
+    }
+
+    int sync = ctx->durabilityLevel != DURABILITY_NONE;
+    if (linesSize > 0) journalAppend(ctx, lines, linesSize, sync);
+    if (numRows > 0) writeUserRows(ctx, numRows, rowIndex, rows, sync);
+
+    free(lines);
+    free(rowIndex);
+    free(rows);
+    statsEnd(ctx, STAT_PERSIST_COMMIT, start);
+}
+
+#ifndef _WIN32
+// 저장 스레드: 큐가 빌 때까지 최대 PERSIST_BATCH_MAX개씩 꺼내 커밋
+static void* persistWriterMain(void* arg) {
+    GameContext* ctx = arg;
+    PersistEntry* batch = malloc(sizeof(PersistEntry) * PERSIST_BATCH_MAX);
+    if (batch == NULL) outOfMemory();
+    for (;;) {
+        int count = 0;
+        while (count < PERSIST_BATCH_MAX && persistDequeue(ctx, &batch[count])) count++;
+
+        if (count > 0) {
+            persistApply(ctx, batch, count);
+            pthread_mutex_lock(&ctx->persistMutex);
+            ctx->persistCommitted += count; // 큐 순서대로 커밋하므로 이 번호 이전은 모두 반영됨
+            pthread_cond_broadcast(&ctx->persistCommitCond);
+            pthread_mutex_unlock(&ctx->persistMutex);
+            continue;
+        }
+
+        pthread_mutex_lock(&ctx->persistMutex);
+        if (ctx->persistStopping) {
+            pthread_mutex_unlock(&ctx->persistMutex);
+            break;
+        }
+        atomic_store(&ctx->persistQueue.writerSleeping, 1);
+        // 잠들기 직전에 들어온 항목을 놓치지 않도록 한 번 더 확인하고, 만일을 위해 시간 제한을 둠
+        size_t head = atomic_load(&ctx->persistQueue.dequeuePos);
+        size_t seq = atomic_load(&ctx->persistQueue.cells[head & (PERSIST_QUEUE_SIZE - 1)].sequence);
+        if (seq != head + 1) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 50 * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&ctx->persistWakeCond, &ctx->persistMutex, &deadline);
+        }
+        atomic_store(&ctx->persistQueue.writerSleeping, 0);
+        pthread_mutex_unlock(&ctx->persistMutex);
+    }
+    free(batch);
+    return NULL;
+}
+#endif
+
+// 저장 스레드 시작 (실패하면 동기 저장으로 동작)
+static void persistStart(GameContext* ctx) {
+#ifndef _WIN32
+    if (ctx->persistRunning) return;
+    ctx->persistQueue.cells = calloc(PERSIST_QUEUE_SIZE, sizeof(PersistCell));
+    if (ctx->persistQueue.cells == NULL) return;
+    for (size_t i = 0; i < PERSIST_QUEUE_SIZE; i++) {
+        atomic_init(&ctx->persistQueue.cells[i].sequence, i);
+    }
+    atomic_init(&ctx->persistQueue.enqueuePos, 0);
+    atomic_init(&ctx->persistQueue.dequeuePos, 0);
+    atomic_init(&ctx->persistQueue.writerSleeping, 0);
+    ctx->persistCommitted = 0;
+    ctx->persistStopping = 0;
+    if (pthread_create(&ctx->persistThread, NULL, persistWriterMain, ctx) != 0) {
+        free(ctx->persistQueue.cells);
+        ctx->persistQueue.cells = NULL;
+        gameLog(ctx, "저장 스레드를 시작할 수 없습니다. 동기 저장을 사용합니다.\n");
+        return;
+    }
+    ctx->persistRunning = 1;
+#endif
+}
+
+// 지금까지 넣은 항목이 모두 커밋될 때까지 대기 (플러시 장벽)
+static void persistFlush(GameContext* ctx) {
+#ifndef _WIN32
+    if (!ctx->persistRunning) return;
+    size_t ticket = atomic_load(&ctx->persistQueue.enqueuePos);
+    pthread_mutex_lock(&ctx->persistMutex);
+    while (ctx->persistCommitted < ticket) {
+        pthread_cond_signal(&ctx->persistWakeCond);
+        pthread_cond_wait(&ctx->persistCommitCond, &ctx->persistMutex);
+    }
+    pthread_mutex_unlock(&ctx->persistMutex);
+#endif
+}
+
+// 남은 항목을 모두 커밋하고 저장 스레드 종료
+static void persistStop(GameContext* ctx) {
+#ifndef _WIN32
+    if (!ctx->persistRunning) return;
+    persistFlush(ctx);
+    pthread_mutex_lock(&ctx->persistMutex);
+    ctx->persistStopping = 1;
+    pthread_cond_signal(&ctx->persistWakeCond);
+    pthread_mutex_unlock(&ctx->persistMutex);
+    pthread_join(ctx->persistThread, NULL);
+    free(ctx->persistQueue.cells);
+    ctx->persistQueue.cells = NULL;
+    ctx->persistRunning = 0;
+#endif
+}
+
+// 저장할 항목 제출 (큐가 가득 차면 저장 스레드가 비울 때까지 잠시 양보)
+// 샤드/기록 잠금 안에서 호출되므로 fsync를 기다리지 않는다 (persistSyncPoint 참고).
+static void persistSubmit(GameContext* ctx, const PersistEntry* entry) {
+#ifndef _WIN32
+    if (ctx->persistRunning) {
+        while (!persistEnqueue(ctx, entry)) {
+            persistWakeWriter(ctx);
+            sched_yield();
+        }
+        persistWakeWriter(ctx);
+        return;
+    }
+    pthread_mutex_lock(&ctx->persistMutex); // 저장 스레드가 없으면 바로 기록 (파일 접근 직렬화)
+    persistApply(ctx, (PersistEntry*)entry, 1);
+    pthread_mutex_unlock(&ctx->persistMutex);
+#else
+    persistApply(ctx, (PersistEntry*)entry, 1); // 저장 스레드가 없으면 바로 기록
+#endif
+}
+
+// 게임 동작이 끝날 때 호출: sync 수준이면 지금까지 제출한 변경이 fsync될 때까지 대기 (잠금 밖에서)
+static void persistSyncPoint(GameContext* ctx) {
+    if (ctx->durabilityLevel == DURABILITY_SYNC) persistFlush(ctx);
+}
+
+// 새 기록 한 건을 저널에 추가하도록 제출
+static void appendUserRecord(GameContext* ctx, const RecordFields* rec) {
+    PersistEntry entry;
+    entry.type = PERSIST_RECORD;
+    entry.rowIndex = 0;
+    entry.length = formatRecordLine(entry.data, sizeof(entry.data), rec);
+    persistSubmit(ctx, &entry);
+}
+
+// 샤드에서 바뀐 사용자 행을 저장하도록 제출 (샤드 잠금 안에서 호출)
+// 같은 행은 항상 같은 샤드 잠금 안에서 만들어 넣으므로 큐에는 나중 내용이 뒤에 온다.
+static void saveShardUsers(GameContext* ctx, UserShard* shard) {
+    if (shard->numDirtyUsers == 0) return;
+    if (!sharedIsCheckpointer(ctx)) { // 공유 사용자 표: 행의 dirty 표시를 남겨 두면 체크포인트 프로세스가 저장
+        shard->numDirtyUsers = 0;
+        return;
+    }
+    if (!ctx->usersFileFixedLayout) { // startGame 전: 파일이 없거나 예전 가변 폭 형식이면 한 번 전체를 고정 폭으로 변환
+        persistFlush(ctx);
+        rewriteUsersFile(ctx);
+        return;
+    }
+    PersistEntry entry;
+    entry.type = PERSIST_USER_ROW;
+    entry.length = USER_ROW_WIDTH;
+    for (int i = 0; i < shard->numDirtyUsers; i++) {
+        entry.rowIndex = (uint32_t)shard->dirtyUsers[i];
+        formatUserRow(ctx, entry.data, userAt(ctx, shard->dirtyUsers[i]));
+        userAt(ctx, shard->dirtyUsers[i])->dirty = 0;
+        persistSubmit(ctx, &entry);
+    }
+    shard->numDirtyUsers = 0;
+}
+
+// 모든 샤드의 바뀐 사용자 행을 저장하도록 제출
+static void saveUsers(GameContext* ctx) {
+    for (int i = 0; i < USER_SHARD_COUNT; i++) {
+        UserShard* shard = &ctx->userShards[i];
+        gameLock(&shard->lock);
+        saveShardUsers(ctx, shard);
+        gameUnlock(&shard->lock);
+    }
+}
+
+
+// --- 공유 사용자 표 ---
+// GameConfig.sharedUsers로 켜며 Linux에서만 동작한다 (프로세스 간 robust 뮤텍스 사용).
+// 사용자 행과 누적 코인 리더보드만 공유하고, 기록/답변 색인/기간별 순위는 프로세스마다 따로 둔다.
+// 기록 저널 파일은 모두 같은 파일 끝에 붙이며, 다른 프로세스의 새 기록은 다음 시작 때 보인다.
+
+enum {
+    SHARED_OFF,
+    SHARED_CREATED,  // 이 프로세스가 만들고 users.txt에서 채움
+    SHARED_ATTACHED  // 다른 프로세스가 채워 둔 표에 붙음
+};
+
+#ifdef __linux__
+enum {
+    SHARED_ATTACH_NONE,  // 이름이 없거나 닫히는 중 (새로 만들거나 잠시 뒤 다시 시도)
+    SHARED_ATTACH_OK,
+    SHARED_ATTACH_STALE, // 만들거나 닫던 프로세스가 죽음 (이름을 지우고 새로 만듦)
+    SHARED_ATTACH_ERROR
+};
+
+static int sharedProcessAlive(int pid) {
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+static size_t sharedAlign(size_t size) {
+    return (size + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+}
+
+// 프로세스 간 잠금 (쥔 프로세스가 죽으면 다음 프로세스가 EOWNERDEAD로 이어받음)
+static void sharedMutexInit(pthread_mutex_t* mutex) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+// 매핑한 표를 컨텍스트에 연결 (사용자 접근, ID 인덱스, 누적 리더보드, 잠금이 모두 공유 쪽을 씀)
+static void sharedUsersBind(GameContext* ctx, SharedUserHeader* header) {
+    SharedUserTable* table = &ctx->shared;
+    table->header = header;
+    table->users = (User*)((char*)header + sharedAlign(sizeof(SharedUserHeader)));
+    table->count = &header->count;
+    table->index = (atomic_int*)((char*)header + header->indexOffset);
+    table->rankCount = &header->rankCount;
+    table->capacity = header->capacity;
+    table->indexCapacity = header->indexCapacity;
+    table->size = header->size;
+    ctx->rankBoard.sharedNodes = (RankNode*)((char*)header + header->rankOffset);
+    ctx->rankBoard.sharedRoot = &header->rankRoot;
+    for (int i = 0; i < USER_SHARD_COUNT; i++) {
+        ctx->userShards[i].lock.shared = &header->shardLocks[i];
+    }
+    ctx->userAppendLock.shared = &header->appendLock;
+    ctx->rankLock.shared = &header->rankLock;
+}
+
+static void sharedUsersUnbind(GameContext* ctx) {
+    SharedUserTable* table = &ctx->shared;
+    munmap(table->header, table->size);
+    table->header = NULL;
+    table->users = NULL;
+    table->count = NULL;
+    table->index = NULL;
+    table->rankCount = NULL;
+    ctx->rankBoard.sharedNodes = NULL;
+    ctx->rankBoard.sharedRoot = NULL;
+    for (int i = 0; i < USER_SHARD_COUNT; i++) {
+        ctx->userShards[i].lock.shared = NULL;
+    }
+    ctx->userAppendLock.shared = NULL;
+    ctx->rankLock.shared = NULL;
+}
+
+// 붙은 프로세스 칸을 차지함 (죽은 프로세스의 칸은 다시 씀, appendLock 안에서, 빈 칸이 없으면 0)
+static int sharedProcessJoin(SharedUserHeader* header, int pid) {
+    for (int i = 0; i < SHARED_MAX_PROCESSES; i++) {
+        int other = header->processes[i];
+        if (other == 0 || !sharedProcessAlive(other)) {
+            header->processes[i] = pid;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 칸을 비우고 살아 있는 다른 프로세스가 남았는지 반환 (appendLock 안에서)
+static int sharedProcessLeave(SharedUserHeader* header, int pid) {
+    int others = 0;
+    for (int i = 0; i < SHARED_MAX_PROCESSES; i++) {
+        int other = header->processes[i];
+        if (other == pid) header->processes[i] = 0;
+        else if (other != 0 && sharedProcessAlive(other)) others = 1;
+    }
+    return others;
+}
+
+// 새 표를 만들고 머리를 채움 (1: 만듦, 0: 이미 있음, -1: 만들 수 없음)
+// 다른 프로세스는 ready가 켜질 때까지 기다리므로 사용자를 채우는 동안에는 잠금이 필요 없다.
+static int sharedUsersCreate(GameContext* ctx, const char* path) {
+    int fd = shm_open(ctx->shared.name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) return errno == EEXIST ? 0 : -1;
+    int capacity = ctx->sharedCapacity;
+    int indexCapacity = USER_INDEX_MIN_CAPACITY;
+    while (indexCapacity < capacity * 2) indexCapacity *= 2; // 부하율 1/2 이하라 다시 해시하지 않음
+    size_t usersOffset = sharedAlign(sizeof(SharedUserHeader));
+    size_t rankOffset = sharedAlign(usersOffset + sizeof(User) * capacity);
+    size_t indexOffset = sharedAlign(rankOffset + sizeof(RankNode) * capacity);
+    size_t size = indexOffset + sizeof(atomic_int) * indexCapacity;
+    SharedUserHeader* header = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0) { // tmpfs는 0으로 채운 것처럼 보이며 쓴 페이지만 메모리를 씀
+        header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (header == MAP_FAILED) {
+        shm_unlink(ctx->shared.name);
+        return -1;
+    }
+    memcpy(header->magic, SHARED_USERS_MAGIC, sizeof(header->magic));
+    header->version = SHARED_USERS_VERSION;
+    header->userSize = sizeof(User);
+    header->capacity = capacity;
+    header->indexCapacity = indexCapacity;
+    header->rankOffset = rankOffset;
+    header->indexOffset = indexOffset;
+    header->size = size;
+    copyString(header->path, path, sizeof(header->path));
+    header->processes[0] = ctx->shared.pid;
+    atomic_store(&header->checkpointer, ctx->shared.pid); // 만든 프로세스가 먼저 users.txt를 맡음
+    header->rankRoot = -1;
+    header->rankCount = 0;
+    sharedMutexInit(&header->appendLock);
+    sharedMutexInit(&header->rankLock);
+    for (int i = 0; i < USER_SHARD_COUNT; i++) {
+        sharedMutexInit(&header->shardLocks[i]);
+    }
+    sharedUsersBind(ctx, header);
+    return 1;
+}
+
+// 이미 있는 표에 붙음 (SHARED_ATTACH_*)
+static int sharedUsersAttach(GameContext* ctx, const char* path) {
+    int fd = shm_open(ctx->shared.name, O_RDWR, 0);
+    if (fd < 0) return errno == ENOENT ? SHARED_ATTACH_NONE : SHARED_ATTACH_ERROR;
+    struct stat st;
+    int waited = 0;
+    // 만든 프로세스가 ftruncate하기 전이면 크기가 0
+    while (fstat(fd, &st) == 0 && st.st_size < (off_t)sizeof(SharedUserHeader) && waited < SHARED_ATTACH_WAIT_MS) {
+        poll(NULL, 0, 10);
+        waited += 10;
+    }
+    if (st.st_size < (off_t)sizeof(SharedUserHeader)) {
+        close(fd);
+        return SHARED_ATTACH_STALE;
+    }
+    SharedUserHeader* header = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED) return SHARED_ATTACH_ERROR;
+    // 만든 프로세스가 users.txt를 다 올릴 때까지 기다림 (그 사이 죽었으면 버림)
+    while (!atomic_load(&header->ready)) {
+        int owner = atomic_load(&header->checkpointer);
+        if (owner != 0 && !sharedProcessAlive(owner)) {
+            munmap(header, (size_t)st.st_size);
+            return SHARED_ATTACH_STALE;
+        }
+        poll(NULL, 0, 10);
+    }
+    if (memcmp(header->magic, SHARED_USERS_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SHARED_USERS_VERSION || header->userSize != sizeof(User) ||
+        header->size != (uint64_t)st.st_size || strcmp(header->path, path) != 0) {
+        munmap(header, (size_t)st.st_size);
+        gameLog(ctx, "공유 사용자 표의 형식이 다릅니다: %s\n", ctx->shared.name);
+        return SHARED_ATTACH_ERROR;
+    }
+    sharedUsersBind(ctx, header);
+    lockUserAppend(ctx);
+    int closed = atomic_load(&header->closed);
+    int joined = !closed && sharedProcessJoin(header, ctx->shared.pid);
+    gameUnlock(&ctx->userAppendLock);
+    if (joined) return SHARED_ATTACH_OK;
+    if (!closed) {
+        sharedUsersUnbind(ctx);
+        gameLog(ctx, "공유 사용자 표에 붙은 프로세스가 너무 많습니다 (최대 %d개).\n", SHARED_MAX_PROCESSES);
+        return SHARED_ATTACH_ERROR;
+    }
+    // 마지막 프로세스가 users.txt를 마저 쓰고 이름을 지우는 중
+    int owner = atomic_load(&header->checkpointer);
+    sharedUsersUnbind(ctx);
+    return owner != 0 && sharedProcessAlive(owner) ? SHARED_ATTACH_NONE : SHARED_ATTACH_STALE;
+}
+
+// 사용자를 모두 채웠음을 알림 (기다리던 프로세스들이 붙음)
+static void sharedUsersReady(GameContext* ctx) {
+    atomic_store(&ctx->shared.header->ready, 1);
+}
+
+// 모든 샤드를 잠그고 users.txt를 공유 표 내용으로 다시 씀 (체크포인트를 이어받을 때만)
+// 샤드를 쥔 채 다른 샤드를 기다리는 곳이 없으므로 번호 순서대로 모두 잡아도 교착이 생기지 않는다.
+static void sharedTakeOver(GameContext* ctx) {
+    gameLog(ctx, "공유 사용자 표의 체크포인트를 이어받습니다.\n");
+    for (int i = 0; i < USER_SHARD_COUNT; i++) gameLock(&ctx->userShards[i].lock);
+    rewriteUsersFile(ctx); // 앞 프로세스가 쓰다 만 행도 덮음
+    for (int i = USER_SHARD_COUNT - 1; i >= 0; i--) gameUnlock(&ctx->userShards[i].lock);
+    remove(ctx->paths[DATA_USERS_WAL]); // 공유 표가 더 새로우므로 남은 로그는 버림
+}
+
+// 체크포인트를 맡은 프로세스가 없거나 죽었으면 이어받음 (이 프로세스가 맡고 있으면 1)
+static int sharedUsersClaim(GameContext* ctx) {
+    SharedUserHeader* header = ctx->shared.header;
+    int owner = atomic_load(&header->checkpointer);
+    if (owner == ctx->shared.pid) return 1;
+    if (owner != 0 && sharedProcessAlive(owner)) return 0;
+    if (!atomic_compare_exchange_strong(&header->checkpointer, &owner, ctx->shared.pid)) return 0;
+    sharedTakeOver(ctx);
+    return 1;
+}
+
+// dirty 표시가 남은 행을 찾아 저장하도록 제출 (체크포인트 프로세스에서)
+static void sharedCheckpoint(GameContext* ctx) {
+    lockUserAppend(ctx);
+    int count = userCount(ctx); // 이 앞의 행은 가입이 끝나 dirty 표시까지 되어 있음
+    gameUnlock(&ctx->userAppendLock);
+    for (int i = 0; i < count; i++) {
+        User* u = userAt(ctx, i);
+        if (!u->dirty) continue; // 잠금 없이 먼저 거르고 잠금 안에서 다시 확인
+        UserShard* shard = userShard(ctx, i);
+        gameLock(&shard->lock);
+        if (u->dirty) {
+            shardDirtyPush(shard, i); // 이미 목록에 있으면 같은 행을 한 번 더 씀
+            saveShardUsers(ctx, shard);
+        }
+        gameUnlock(&shard->lock);
+    }
+}
+
+// 체크포인트 스레드: SHARED_CHECKPOINT_MS마다 체크포인트를 맡거나 (맡고 있으면) 바뀐 행을 저장
+static void* sharedCheckpointMain(void* arg) {
+    GameContext* ctx = arg;
+    int waited = 0;
+    while (!atomic_load(&ctx->shared.checkpointStopping)) {
+        poll(NULL, 0, SHARED_POLL_MS);
+        waited += SHARED_POLL_MS;
+        if (waited < SHARED_CHECKPOINT_MS) continue;
+        waited = 0;
+        if (sharedUsersClaim(ctx)) sharedCheckpoint(ctx);
+    }
+    return NULL;
+}
+#endif
+
+// 공유 사용자 표를 열거나 만듦 (SHARED_*, 만들면 사용자 로드 뒤 sharedUsersReady로 알려야 함)
+static int sharedUsersOpen(GameContext* ctx) {
+    if (!ctx->sharedRequested) return SHARED_OFF;
+#ifdef __linux__
+    if (ctx->shared.header != NULL) return SHARED_ATTACHED; // 다시 로드해도 공유 표는 그대로 사용
+    char* path = realpath(ctx->dataDir, NULL);
+    if (path == NULL) {
+        fprintf(stderr, "데이터 디렉터리를 찾을 수 없습니다: %s\n", ctx->dataDir);
+        exit(1);
+    }
+    snprintf(ctx->shared.name, sizeof(ctx->shared.name), "/tod-users-%08x", hashString(path));
+    ctx->shared.pid = (int)getpid();
+    // 공유하지 않고 계속하면 다른 프로세스와 users.txt를 함께 쓰게 되므로 열 수 없으면 종료
+    for (;;) {
+        int attach = sharedUsersAttach(ctx, path);
+        if (attach == SHARED_ATTACH_OK) {
+            gameLog(ctx, "공유 사용자 표에 붙었습니다: 사용자 %d명\n", userCount(ctx));
+            free(path);
+            return SHARED_ATTACHED;
+        }
+        if (attach == SHARED_ATTACH_ERROR) break;
+        if (attach == SHARED_ATTACH_STALE) shm_unlink(ctx->shared.name);
+        int created = sharedUsersCreate(ctx, path);
+        if (created > 0) {
+            gameLog(ctx, "공유 사용자 표를 만들었습니다: 최대 %d명\n", ctx->shared.capacity);
+            free(path);
+            return SHARED_CREATED;
+        }
+        if (created < 0) break;
+        poll(NULL, 0, 10); // 다른 프로세스가 막 만들었거나 마지막 프로세스가 닫는 중
+    }
+    fprintf(stderr, "공유 사용자 표를 열 수 없습니다: %s\n", ctx->shared.name);
+    exit(1);
+#else
+    gameLog(ctx, "이 플랫폼에서는 사용자 표를 공유할 수 없습니다. 혼자 실행합니다.\n");
+    return SHARED_OFF;
+#endif
+}
+
+static void sharedUsersStart(GameContext* ctx) {
+#ifdef __linux__
+    if (ctx->shared.header == NULL || ctx->shared.checkpointRunning) return;
+    atomic_store(&ctx->shared.checkpointStopping, 0);
+    if (pthread_create(&ctx->shared.checkpointThread, NULL, sharedCheckpointMain, ctx) == 0) {
+        ctx->shared.checkpointRunning = 1;
+    }
+#else
+    (void)ctx;
+#endif
+}
+
+static void sharedUsersStop(GameContext* ctx) {
+#ifdef __linux__
+    if (!ctx->shared.checkpointRunning) return;
+    atomic_store(&ctx->shared.checkpointStopping, 1);
+    pthread_join(ctx->shared.checkpointThread, NULL); // poll 제한 시간 안에 깨어남
+    ctx->shared.checkpointRunning = 0;
+#else
+    (void)ctx;
+#endif
+}
+
+// 공유 사용자 표에서 떠남 (체크포인트를 맡았거나 마지막 프로세스면 남은 행을 모두 쓰고 나감)
+// 마지막 프로세스는 closed를 켜서 새로 붙으려는 프로세스를 기다리게 하고, users.txt를 다 쓴 뒤에 이름을 지운다.
+static void sharedUsersDetach(GameContext* ctx) {
+#ifdef __linux__
+    SharedUserHeader* header = ctx->shared.header;
+    if (header == NULL) return;
+    lockUserAppend(ctx);
+    int last = !sharedProcessLeave(header, ctx->shared.pid); // 죽은 프로세스는 세지 않음
+    int mine = sharedIsCheckpointer(ctx);
+    if (last) {
+        atomic_store(&header->closed, 1);
+        atomic_store(&header->checkpointer, ctx->shared.pid);
+    }
+    gameUnlock(&ctx->userAppendLock);
+    if (last && !mine) sharedTakeOver(ctx);
+    if (last || mine) {
+        sharedCheckpoint(ctx);
+        persistFlush(ctx);
+    }
+    if (last) shm_unlink(ctx->shared.name);
+    else if (mine) atomic_store(&header->checkpointer, 0); // 남은 프로세스가 이어받음
+    sharedUsersUnbind(ctx);
+#else
+    (void)ctx;
+#endif
+}
+
+
+// --- 컨텍스트 생성/해제 ---
+
+GameContext* createGameContext(const GameConfig* config) {
+    GameContext* ctx = calloc(1, sizeof(GameContext));
+    if (ctx == NULL) return NULL;
+    ctx->users = (SegArray)SEG_ARRAY_INIT(User);
+    ctx->userRecordLists = (SegArray)SEG_ARRAY_INIT(RecordList);
+    ctx->rankBoard.nodes = (SegArray)SEG_ARRAY_INIT(RankNode);
+    ctx->rankBoard.root = -1;
+    for (int w = 0; w < RANK_WINDOW_COUNT; w++) {
+        ctx->windowBoards[w].nodes = (SegArray)SEG_ARRAY_INIT(RankNode);
+        ctx->windowBoards[w].root = -1;
+    }
+    ctx->userWindows = (SegArray)SEG_ARRAY_INIT(UserWindow);
+    ctx->windowDay = DAY_NONE;
+    ctx->records.blocks = (SegArray)SEG_ARRAY_INIT(RecordBlock);
+    ctx->records.interned = (SegArray)SEG_ARRAY_INIT(const char*);
+    ctx->snapshotRequireFresh = 1;
+    ctx->durabilityLevel = config ? config->durability : DURABILITY_BATCH;
+    ctx->log = config ? config->log : NULL;
+    ctx->rngSeeded = config && config->seed;
+    ctx->rngSeed = ctx->rngSeeded ? config->seed : ((uint64_t)time(NULL) << 32) ^ (uint64_t)(uintptr_t)ctx;
+    atomic_init(&ctx->rngStreams, 0);
+    ctx->statsEnabled = config && config->stats;
+    ctx->statsId = atomic_fetch_add(&nextStatsId, 1);
+    ctx->statsInterval = config && config->statsInterval > 0 ? config->statsInterval : STATS_DEFAULT_INTERVAL;
+    ctx->sharedRequested = config && config->sharedUsers;
+    ctx->sharedCapacity = config && config->sharedCapacity > 0 ? config->sharedCapacity : SHARED_USERS_DEFAULT_CAPACITY;
+    if (ctx->sharedCapacity > SHARED_USERS_MAX_CAPACITY) ctx->sharedCapacity = SHARED_USERS_MAX_CAPACITY;
+    if (config && config->statsFile) copyString(ctx->statsFile, config->statsFile, sizeof(ctx->statsFile));
+    atomic_init(&ctx->statsDumpRequested, 0);
+
+    const char* dir = config && config->dataDir && config->dataDir[0] ? config->dataDir : NULL;
+    copyString(ctx->dataDir, dir ? dir : ".", sizeof(ctx->dataDir));
+    for (int i = 0; i < DATA_FILE_COUNT; i++) {
+        int len = dir ? snprintf(ctx->paths[i], GAME_PATH_MAX, "%s/%s", dir, dataFileNames[i])
+                      : snprintf(ctx->paths[i], GAME_PATH_MAX, "%s", dataFileNames[i]);
+        if (len < 0 || len >= GAME_PATH_MAX) {
+            free(ctx);
+            return NULL;
+        }
+    }
+    for (int i = 0; i < USER_SHARD_COUNT; i++) {
+        gameLockInit(&ctx->userShards[i].lock);
+    }
+    gameLockInit(&ctx->userAppendLock);
+    gameLockInit(&ctx->rankLock);
+    gameLockInit(&ctx->windowLock);
+    gameLockInit(&ctx->recordsLock);
+    gameLockInit(&ctx->statsLock);
+    gameLockInit(&ctx->contentLock);
+#ifdef __linux__
+    ctx->contentWatchFd = -1;
+#endif
+#ifndef _WIN32
+    pthread_mutex_init(&ctx->persistMutex, NULL);
+    pthread_cond_init(&ctx->persistWakeCond, NULL);
+    pthread_cond_init(&ctx->persistCommitCond, NULL);
+    pthread_mutex_init(&ctx->statsMutex, NULL);
+    pthread_cond_init(&ctx->statsCond, NULL);
+#endif
+    return ctx;
+}
+
+void destroyGameContext(GameContext* ctx) {
+    if (ctx == NULL) return;
+    contentWatchStop(ctx);
+    sharedUsersStop(ctx);
+    saveUsers(ctx); // 바뀐 행이 없으면 아무것도 쓰지 않음
+    int shared = ctx->shared.users != NULL;
+    sharedUsersDetach(ctx); // 이후로는 프로세스 안의 빈 사용자 표만 남음
+    persistStop(ctx); // 플러시 장벽: 큐에 남은 변경을 모두 커밋한 뒤 종료
+    closeRecordJournal(ctx); // 기록은 이미 저널에 있으므로 전체 재작성 없음
+    // 세션이 모두 끝났으므로 색인이 모든 기록 행을 반영하고 있음 (공유 중이면 다른 프로세스의 기록이 빠져 있음)
+    if (!shared) saveSearchIndex(ctx);
+    closeSnapshot(ctx);
+    statsStop(ctx);
+    writeStatsFile(ctx); // 마지막 커밋까지 포함한 최종 통계
+    while (ctx->statsBuffers != NULL) {
+        StatsBuffer* next = ctx->statsBuffers->next;
+        free(ctx->statsBuffers);
+        ctx->statsBuffers = next;
+    }
+
+    userIndexClear(ctx);
+    searchIndexClearAll(ctx);
+    segClear(&ctx->users);
+    recordStoreClear(&ctx->records);
+    contentClear(ctx);
+    for (int i = 0; i < USER_SHARD_COUNT; i++) {
+        free(ctx->userShards[i].dirtyUsers);
+        gameLockDestroy(&ctx->userShards[i].lock);
+    }
+    gameLockDestroy(&ctx->userAppendLock);
+    gameLockDestroy(&ctx->rankLock);
+    gameLockDestroy(&ctx->windowLock);
+    gameLockDestroy(&ctx->recordsLock);
+    gameLockDestroy(&ctx->statsLock);
+    gameLockDestroy(&ctx->contentLock);
+#ifndef _WIN32
+    pthread_mutex_destroy(&ctx->persistMutex);
+    pthread_cond_destroy(&ctx->persistWakeCond);
+    pthread_cond_destroy(&ctx->persistCommitCond);
+    pthread_mutex_destroy(&ctx->statsMutex);
+    pthread_cond_destroy(&ctx->statsCond);
+#endif
+    free(ctx);
+}
+
+// 사용자/콘텐츠/기록을 차례로 로드 (단계별 시간 측정)
+static void loadAllData(GameContext* ctx) {
+    uint64_t start = statsBegin(ctx);
+    int shared = sharedUsersOpen(ctx);
+    if (shared != SHARED_ATTACHED) loadUsers(ctx); // 붙은 표는 먼저 연 프로세스가 이미 채워 둠
+    statsEnd(ctx, STAT_LOAD_USERS, start);
+
+    start = statsBegin(ctx);
+    loadContent(ctx);
+    statsEnd(ctx, STAT_LOAD_CONTENT, start);
+
+    start = statsBegin(ctx);
+    loadUserRecords(ctx);
+    // 통계 칸이 없던 사용자 행은 기록에서 다시 계산하고 다음 저장 때 새 형식으로 씀
+    int rebuilt = 0;
+    for (int i = 0; i < userCount(ctx); i++) {
+        if (!userAt(ctx, i)->statsStale) continue;
+        rebuildUserStatsOf(ctx, i);
+        markUserDirty(ctx, userShard(ctx, i), i);
+        rebuilt++;
+    }
+    if (rebuilt > 0) gameLog(ctx, "사용자 통계 재계산: %d명\n", rebuilt);
+    rebuildWindowBoards(ctx);
+    loadSearchIndex(ctx);
+    statsEnd(ctx, STAT_LOAD_RECORDS, start);
+#ifdef __linux__
+    if (shared == SHARED_CREATED) sharedUsersReady(ctx); // 통계를 다시 계산한 행까지 채운 뒤 공개
+#endif
+}
+
+// 데이터 로드 (시작 시) - 텍스트 파일이 바뀌지 않은 부분은 스냅샷에서 바로 읽음
+void loadGame(GameContext* ctx) {
+    openSnapshot(ctx);
+    loadAllData(ctx);
+    closeSnapshot(ctx);
+}
+
+// 이후 저장은 저장 스레드가 처리 (핸들러는 디스크를 기다리지 않음)
+void startGame(GameContext* ctx) {
+    // 여러 세션이 동시에 행 단위로 저장하기 전에 users.txt를 미리 고정 폭으로 맞춰 둠
+    if (!ctx->usersFileFixedLayout && sharedIsCheckpointer(ctx)) rewriteUsersFile(ctx);
+    persistStart(ctx);
+    statsStart(ctx);
+    contentWatchStart(ctx);
+    sharedUsersStart(ctx);
+}
+
+void flushGame(GameContext* ctx) {
+    saveUsers(ctx);
+    persistFlush(ctx);
+}
+
+void rebuildUserStats(GameContext* ctx) {
+    for (int i = 0; i < userCount(ctx); i++) {
+        rebuildUserStatsOf(ctx, i);
+        markUserDirty(ctx, userShard(ctx, i), i);
+    }
+    gameLog(ctx, "사용자 통계 재계산: %d명\n", userCount(ctx));
+}
+
+int importSnapshot(GameContext* ctx) {
+    ctx->snapshotRequireFresh = 0; // 텍스트 파일 상태와 무관하게 스냅샷 내용 사용
+    if (!openSnapshot(ctx)) {
+        gameLog(ctx, "스냅샷 파일을 열 수 없습니다.\n");
+        return 0;
+    }
+    loadAllData(ctx);
+    closeSnapshot(ctx);
+    ctx->snapshotRequireFresh = 1;
+
+    rewriteUsersFile(ctx);
+    saveTruthQuestions(ctx);
+    saveDareChallenges(ctx);
+    compactUserRecords(ctx);
+    return saveSnapshot(ctx); // 새 텍스트 파일 기준으로 스냅샷 갱신
+}
+
+
+// --- 게임 동작 (화면 입출력 없음) ---
+// 대화형 화면과 서버 모드가 함께 사용한다. 여러 스레드에서 동시에 호출할 수 있으며
+// 사용자 한 명의 상태는 그 사용자의 샤드 잠금, 코인과 Dare 시도 횟수는 원자적 연산으로 갱신한다.
+
+// 사용자 일일 상태 초기화 (날짜가 바뀐 경우에만 변경, 샤드 잠금 안에서 호출, 저장은 호출자가 saveShardUsers()로)
+static void refreshDailyStatus(GameContext* ctx, UserShard* shard, int userIdx, int today) {
+    User* u = userAt(ctx, userIdx);
+    // Truth 초기화
+    if (u->lastTruthDay != today && u->lastTruthDay != DAY_NONE) {
+        u->lastTruthDay = DAY_NONE; // 오늘 Truth 아직 안 함
+        markUserDirty(ctx, shard, userIdx);
+    }
+    // Dare 초기화
+    if (u->lastDareDay != today) {
+        atomic_store(&u->dareAttemptsToday, 0);
+        u->lastDareDay = today; // 오늘 Dare 시작 날짜로 업데이트
+        markUserDirty(ctx, shard, userIdx);
+    }
+}
+
+int signUpUser(GameContext* ctx, const char* id, const char* password) {
+    uint64_t start = statsBegin(ctx);
+    UserShard* shard = shardForId(ctx, id);
+    gameLock(&shard->lock); // 같은 ID의 동시 가입은 같은 샤드에서 직렬화됨
+    if (findUserIndex(ctx, id) >= 0) {
+        gameUnlock(&shard->lock);
+        statsEnd(ctx, STAT_SIGN_UP, start);
+        return GAME_ERR_DUPLICATE_ID;
+    }
+    // 새 행은 users 인덱스 순서대로 큐에 들어가야 users.txt 중간에 빈 행이 생기지 않으므로
+    // 배열 추가부터 행 제출까지 userAppendLock 안에서 처리
+    lockUserAppend(ctx);
+    User* newUser = userPush(ctx);
+    if (newUser == NULL) { // 공유 사용자 표가 가득 참
+        gameUnlock(&ctx->userAppendLock);
+        gameUnlock(&shard->lock);
+        statsEnd(ctx, STAT_SIGN_UP, start);
+        return GAME_ERR_USERS_FULL;
+    }
+    copyString(newUser->id, id, sizeof(newUser->id));
+    copyString(newUser->password, password, sizeof(newUser->password));
+    newUser->coins = 0;
+    newUser->lastTruthDay = DAY_NONE; // 초기값
+    newUser->lastDareDay = DAY_NONE;  // 초기값
+    newUser->dareAttemptsToday = 0;
+    userStatsReset(&newUser->stats);
+    newUser->truthBagFirstId = 0; // 처음 질문을 낼 때 섞음
+    newUser->truthBagSpan = 0;
+    newUser->truthBagCursor = 0;
+    newUser->truthBagKey = 0;
+    registerNewUser(ctx);
+    markUserDirty(ctx, shard, userCount(ctx) - 1); // 파일 끝에 새 행으로 추가됨
+    saveShardUsers(ctx, shard); // 사용자 추가 후 저장
+    gameUnlock(&ctx->userAppendLock);
+    gameUnlock(&shard->lock);
+    persistSyncPoint(ctx);
+    statsEnd(ctx, STAT_SIGN_UP, start);
+    return GAME_OK;
+}
+
+int loginSession(GameContext* ctx, GameSession* session, const char* id, const char* password) {
+    uint64_t start = statsBegin(ctx);
+    session->ctx = ctx;
+    session->userIdx = -1;
+    UserShard* shard = shardForId(ctx, id);
+    gameLock(&shard->lock);
+    int idx = findUserIndex(ctx, id);
+    if (idx < 0 || strcmp(userAt(ctx, idx)->password, password) != 0) {
+        gameUnlock(&shard->lock);
+        statsEnd(ctx, STAT_LOGIN, start);
+        return GAME_ERR_AUTH;
+    }
+    session->userIdx = idx;
+    refreshDailyStatus(ctx, shard, idx, gameToday(ctx)); // 로그인 성공 후 현재 사용자 데이터 기반으로 초기화
+    saveShardUsers(ctx, shard);
+    gameUnlock(&shard->lock);
+    persistSyncPoint(ctx);
+    statsEnd(ctx, STAT_LOGIN, start);
+    return GAME_OK;
+}
+
+const User* sessionUser(const GameSession* session) {
+    return session->userIdx < 0 ? NULL : userAt(session->ctx, session->userIdx);
+}
+
+int hasAnsweredTruthToday(const GameSession* session) {
+    UserShard* shard = userShard(session->ctx, session->userIdx);
+    int today = gameToday(session->ctx);
+    gameLock(&shard->lock);
+    int answered = userAt(session->ctx, session->userIdx)->lastTruthDay == today;
+    gameUnlock(&shard->lock);
+    return answered;
+}
+
+int dareAttemptsLeft(GameSession* session) {
+    GameContext* ctx = session->ctx;
+    UserShard* shard = userShard(ctx, session->userIdx);
+    gameLock(&shard->lock);
+    refreshDailyStatus(ctx, shard, session->userIdx, gameToday(ctx));
+    saveShardUsers(ctx, shard);
+    gameUnlock(&shard->lock);
+    persistSyncPoint(ctx);
+    int left = MAX_DARE_ATTEMPTS_PER_DAY - atomic_load(&userAt(ctx, session->userIdx)->dareAttemptsToday);
+    return left > 0 ? left : 0;
+}
+
+// 오늘 Dare 시도 한 번 예약 (남은 횟수 확인과 증가를 CAS 한 번으로 처리, 남은 횟수가 없으면 0)
+// 같은 사용자의 여러 세션이 동시에 시도해도 하루 MAX_DARE_ATTEMPTS_PER_DAY회를 정확히 넘지 않는다.
+static int reserveDareAttempt(User* u) {
+    int attempts = atomic_load(&u->dareAttemptsToday);
+    do {
+        if (attempts >= MAX_DARE_ATTEMPTS_PER_DAY) return 0;
+    } while (!atomic_compare_exchange_weak(&u->dareAttemptsToday, &attempts, attempts + 1));
+    return 1;
+}
+
+// 기록 한 건 추가 (메모리, 사용자별 목록, 저널) - 사용자 샤드 잠금 안에서 호출
+static void addUserRecord(GameContext* ctx, int userIdx, int day, int type, int contentId, const char* response, int coinsEarned) {
+    // 저널 줄은 기록 배열과 같은 순서로 큐에 넣음
+    RecordFields rec = { userAt(ctx, userIdx)->id, day, type, contentId, coinsEarned, response };
+    gameLock(&ctx->recordsLock);
+    int recIdx = recordPush(ctx, &rec, userIdx);
+    appendUserRecord(ctx, &rec); // 저널에 한 줄만 추가
+    gameUnlock(&ctx->recordsLock);
+    insertUserRecordIndex(ctx, userIdx, recIdx);
+    searchIndexRow(ctx, recIdx);
+    userStatsAdd(ctx, &userAt(ctx, userIdx)->stats, day, type, contentId, response, coinsEarned); // 호출한 쪽이 사용자 행을 저장
+    windowAddCoins(ctx, userIdx, day, coinsEarned);
+}
+
+int answerTruth(GameSession* session, int questionId, const char* answer) {
+    if (session->userIdx < 0) return GAME_ERR_NOT_LOGGED_IN;
+    GameContext* ctx = session->ctx;
+    uint64_t start = statsBegin(ctx);
+    UserShard* shard = userShard(ctx, session->userIdx);
+    User* u = userAt(ctx, session->userIdx);
+    int today = gameToday(ctx); // 자정 직전에 답해도 검사/기록/마지막 날짜가 같은 날을 쓰도록 한 번만 읽음
+    gameLock(&shard->lock);
+    // 같은 사용자가 다른 세션에서 먼저 답했을 수 있으므로 저장 직전에 확인
+    if (u->lastTruthDay == today) {
+        gameUnlock(&shard->lock);
+        statsEnd(ctx, STAT_ANSWER_TRUTH, start);
+        return GAME_ERR_ALREADY_ANSWERED;
+    }
+    addUserRecord(ctx, session->userIdx, today, 0, questionId, answer, 0); // 0: Truth
+    // 주머니의 지금 차례 질문에 답했으면 다음 차례로 (다른 질문 ID면 차례를 그대로 둠)
+    const ContentTable* content = contentAcquire(ctx);
+    if (content->truthCount > 0 &&
+        content->truthRows[truthBagCurrent(ctx, shard, session->userIdx, content)].id == questionId) {
+        truthBagAdvance(ctx, shard, session->userIdx);
+    }
+
+    // 사용자의 마지막 Truth 날짜 업데이트
+    u->lastTruthDay = today;
+    markUserDirty(ctx, shard, session->userIdx);
+    saveShardUsers(ctx, shard); // 바뀐 행만 저장
+    gameUnlock(&shard->lock);
+    persistSyncPoint(ctx);
+    statsEnd(ctx, STAT_ANSWER_TRUTH, start);
+    return GAME_OK;
+}
+
+int attemptDare(GameSession* session, int dareId, int resultChoice, int* coinsEarned) {
+    if (coinsEarned) *coinsEarned = 0;
+    if (session->userIdx < 0) return GAME_ERR_NOT_LOGGED_IN;
+    GameContext* ctx = session->ctx;
+    uint64_t start = statsBegin(ctx);
+    int userIdx = session->userIdx;
+    UserShard* shard = userShard(ctx, userIdx);
+    int today = gameToday(ctx);
+
+    gameLock(&shard->lock);
+    refreshDailyStatus(ctx, shard, userIdx, today); // 날짜가 바뀌었으면 시도 횟수부터 초기화
+    saveShardUsers(ctx, shard);
+    gameUnlock(&shard->lock);
+    // 같은 사용자의 다른 세션이 그 사이 남은 횟수를 다 썼을 수 있음
+    if (!reserveDareAttempt(userAt(ctx, userIdx))) {
+        statsEnd(ctx, STAT_ATTEMPT_DARE, start);
+        return GAME_ERR_NO_ATTEMPTS;
+    }
+
+    int coins = 0;
+    const char* responseResult;
+    if (resultChoice == 1) { // Complete
+        addUserCoins(ctx, userIdx, 10); // 예시: 10코인 지급 (리더보드도 갱신)
+        coins = 10;
+        responseResult = "Complete";
+    } else if (resultChoice == 2) { // Fail
+        responseResult = "Fail";
+    } else {
+        responseResult = "Invalid Choice";
+    }
+
+    gameLock(&shard->lock);
+    addUserRecord(ctx, userIdx, today, 1, dareId, responseResult, coins); // 1: Dare
+    markUserDirty(ctx, shard, userIdx); // 시도 횟수/코인
+    saveShardUsers(ctx, shard); // 바뀐 행만 저장
+    gameUnlock(&shard->lock);
+    persistSyncPoint(ctx);
+    if (coinsEarned) *coinsEarned = coins;
+    statsEnd(ctx, STAT_ATTEMPT_DARE, start);
+    return GAME_OK;
+}
+
+const TruthQuestion* getTruthQuestion(GameSession* session) {
+    // 공유 질문 목록에는 쓰지 않고, 사용자별 주머니의 지금 차례를 돌려줌 (차례는 답할 때 넘어감)
+    if (session->userIdx < 0) return NULL;
+    GameContext* ctx = session->ctx;
+    const ContentTable* content = contentAcquire(ctx);
+    if (content->truthCount == 0) {
+        return NULL;
+    }
+    uint64_t start = statsBegin(ctx);
+    UserShard* shard = userShard(ctx, session->userIdx);
+    gameLock(&shard->lock);
+    int row = truthBagCurrent(ctx, shard, session->userIdx, content);
+    gameUnlock(&shard->lock);
+    threadTruth = truthAt(content, row);
+    statsEnd(ctx, STAT_TRUTH_QUESTION, start);
+    return &threadTruth;
+}
+
+int listDareCategories(GameContext* ctx, int* ids, const char** names, int max) {
+    const ContentTable* content = contentAcquire(ctx);
+    for (int k = 0; k < content->categoryCount && k < max; k++) {
+        if (ids) ids[k] = content->categoryIds[k];
+        if (names) names[k] = contentString(content, content->categories[k].nameOff);
+    }
+    return content->categoryCount;
+}
+
+const DareChallenge* getRandomDareChallenge(GameContext* ctx, int categoryId) {
+    uint64_t start = statsBegin(ctx);
+    // 카탈로그에 카테고리별 도전 행 번호와 별칭 표가 모여 있으므로 전체 도전을 훑지 않고
+    // 칸 하나와 난수 하나로 가중치에 비례해 고름
+    const ContentTable* content = contentAcquire(ctx);
+    int k = contentCategoryOfId(content, categoryId);
+    const DareChallenge* selectedDare = NULL;
+    if (k >= 0 && content->categories[k].count > 0) {
+        const CatalogCategory* c = &content->categories[k];
+        uint32_t slot = gameRandom(ctx) % c->count;
+        const CatalogAlias* alias = &content->dareAlias[c->first + slot];
+        if (gameRandom(ctx) >= alias->threshold && alias->alias < c->count) slot = alias->alias; // 손상된 카탈로그의 별칭은 무시
+        uint32_t row = content->dareOrder[c->first + slot];
+        if (row < (uint32_t)content->dareCount) { // 손상된 카탈로그의 행 번호는 무시
+            threadDare = dareAt(content, (int)row);
+            selectedDare = &threadDare;
+        }
+    }
+    statsEnd(ctx, STAT_RANDOM_DARE, start);
+    return selectedDare;
+}
+
+
+// --- 조회 ---
+
+int listRecords(const GameSession* session, int start, UserRecord* out, int max) {
+    if (session->userIdx < 0) return 0;
+    // 사용자별 기록 목록은 이미 날짜순이므로 필터링/정렬 없이 열 저장소에서 바로 읽어 채움
+    // (문자열은 복사하지 않고 저장소를 가리킴, 기록은 추가된 뒤 바뀌지 않음)
+    uint64_t begin = statsBegin(session->ctx);
+    UserShard* shard = userShard(session->ctx, session->userIdx);
+    gameLock(&shard->lock);
+    const RecordList* list = recordListAt(session->ctx, session->userIdx);
+    int n = 0;
+    for (int i = start; i < list->count && n < max; i++) {
+        RecordFields rec;
+        recordFieldsAt(session->ctx, list->items[i], &rec);
+        UserRecord* view = &out[n++];
+        view->userId = rec.userId;
+        view->day = rec.day;
+        view->type = rec.type;
+        view->contentId = rec.contentId;
+        view->response = rec.response;
+        view->coinsEarned = rec.coinsEarned;
+    }
+    gameUnlock(&shard->lock);
+    statsEnd(session->ctx, STAT_LIST_RECORDS, begin);
+    return n;
+}
+
+int searchRecords(const GameSession* session, const char* query, int start, UserRecord* out, int max) {
+    if (session->userIdx < 0) return 0;
+    GameContext* ctx = session->ctx;
+    uint64_t begin = statsBegin(ctx);
+    SearchQuery parsed;
+    parseSearchQuery(query, &parsed);
+    UserShard* shard = userShard(ctx, session->userIdx);
+    int n = 0;
+    gameLock(&shard->lock);
+    // 검색어 토큰마다 그 사용자의 행 목록을 찾고, 가장 짧은 목록의 행만 나머지 목록에서 이진 탐색
+    const SearchTerm* lists[SEARCH_QUERY_TOKENS];
+    int numLists = 0;
+    for (int i = 0; i < parsed.numTokens; i++) {
+        const SearchTerm* t = searchIndexFind(&shard->search, session->userIdx, parsed.tokens[i]);
+        if (t == NULL) {
+            numLists = 0; // 한 토큰이라도 없으면 일치하는 답변 없음
+            break;
+        }
+        int pos = numLists++;
+        while (pos > 0 && lists[pos - 1]->count > t->count) {
+            lists[pos] = lists[pos - 1];
+            pos--;
+        }
+        lists[pos] = t;
+    }
+    int matched = 0;
+    for (int i = 0; numLists > 0 && i < lists[0]->count && n < max; i++) {
+        int row = lists[0]->rows[i];
+        int ok = 1;
+        for (int k = 1; ok && k < numLists; k++) ok = searchTermHas(lists[k], row);
+        const char* response = recordBlock(&ctx->records, row)->response[recordSlot(row)];
+        for (int k = 0; ok && k < parsed.numPhrases; k++) ok = strstr(response, parsed.phrases[k]) != NULL;
+        if (!ok || matched++ < start) continue;
+        RecordFields rec;
+        recordFieldsAt(ctx, row, &rec);
+        UserRecord* view = &out[n++];
+        view->userId = rec.userId;
+        view->day = rec.day;
+        view->type = rec.type;
+        view->contentId = rec.contentId;
+        view->response = rec.response;
+        view->coinsEarned = rec.coinsEarned;
+    }
+    gameUnlock(&shard->lock);
+    statsEnd(ctx, STAT_SEARCH_RECORDS, begin);
+    return n;
+}
+
+int gameUserCount(GameContext* ctx) {
+    return userCount(ctx);
+}
+
+const User* gameUserAt(GameContext* ctx, int userIdx) {
+    return userIdx < 0 || userIdx >= userCount(ctx) ? NULL : userAt(ctx, userIdx);
+}
+
+int topRanks(GameContext* ctx, int* out, int max) {
+    uint64_t start = statsBegin(ctx);
+    int n = 0;
+    lockRankBoard(ctx);
+    while (n < max && (out[n] = leaderboardAt(&ctx->rankBoard, n)) >= 0) {
+        n++;
+    }
+    gameUnlock(&ctx->rankLock);
+    statsEnd(ctx, STAT_RANKING, start);
+    return n;
+}
+
+int sessionRank(const GameSession* session) {
+    uint64_t start = statsBegin(session->ctx);
+    lockRankBoard(session->ctx);
+    int rank = leaderboardRank(&session->ctx->rankBoard, session->userIdx) + 1;
+    gameUnlock(&session->ctx->rankLock);
+    statsEnd(session->ctx, STAT_RANKING, start);
+    return rank;
+}
+
+int topWindowRanks(GameContext* ctx, int window, int* out, int* coins, int max) {
+    if (window < 0 || window >= RANK_WINDOW_COUNT) return 0;
+    uint64_t start = statsBegin(ctx);
+    int n = 0;
+    gameLock(&ctx->windowLock);
+    windowSyncDay(ctx); // 오늘 처음 조회하면 지난 버킷부터 뺌
+    Leaderboard* board = &ctx->windowBoards[window];
+    while (n < max && (out[n] = leaderboardAt(board, n)) >= 0) {
+        if (coins) coins[n] = rankNodeAt(board, out[n])->coins;
+        n++;
+    }
+    gameUnlock(&ctx->windowLock);
+    statsEnd(ctx, STAT_RANKING, start);
+    return n;
+}
+
+int sessionWindowRank(const GameSession* session, int window, int* coins) {
+    if (coins) *coins = 0;
+    if (session->userIdx < 0 || window < 0 || window >= RANK_WINDOW_COUNT) return 0;
+    GameContext* ctx = session->ctx;
+    uint64_t start = statsBegin(ctx);
+    int rank = 0;
+    gameLock(&ctx->windowLock);
+    windowSyncDay(ctx);
+    // 기간 코인이 없는 사용자는 리더보드에 없음
+    if (session->userIdx < ctx->userWindows.count && userWindowAt(ctx, session->userIdx)->windowCoins[window] != 0) {
+        rank = leaderboardRank(&ctx->windowBoards[window], session->userIdx) + 1;
+        if (coins) *coins = userWindowAt(ctx, session->userIdx)->windowCoins[window];
+    }
+    gameUnlock(&ctx->windowLock);
+    statsEnd(ctx, STAT_RANKING, start);
+    return rank;
+}
+
+void sessionStatsSummary(const GameSession* session, UserStatsSummary* out) {
+    memset(out, 0, sizeof(*out));
+    if (session->userIdx < 0) return;
+    GameContext* ctx = session->ctx;
+    UserShard* shard = userShard(ctx, session->userIdx);
+    gameLock(&shard->lock);
+    UserStats stats = userAt(ctx, session->userIdx)->stats;
+    gameUnlock(&shard->lock);
+
+    int today = gameToday(ctx);
+    out->truthAnswers = stats.truthAnswers;
+    out->dareAttempts = stats.dareAttempts;
+    out->dareCompletions = stats.dareCompletions;
+    // 마지막 참여가 어제보다 이르면 이미 끊긴 연속 참여
+    out->truthStreak = stats.truthStreakDay != DAY_NONE && stats.truthStreakDay >= today - 1 ? stats.truthStreak : 0;
+    out->weekCoins = stats.weekStart == weekStartOf(today) ? stats.weekCoins : 0;
+    // 통계 칸의 카테고리 ID를 지금 판에서 찾음 (지금 콘텐츠에 없는 카테고리는 건너뜀)
+    const ContentTable* content = contentAcquire(ctx);
+    int favoriteDares = 0;
+    for (int j = 0; j < USER_CATEGORY_SLOTS && stats.categoryDares[j].category != 0; j++) {
+        int k = contentCategoryOfId(content, stats.categoryDares[j].category);
+        if (k >= 0 && stats.categoryDares[j].dares > favoriteDares) {
+            favoriteDares = stats.categoryDares[j].dares;
+            out->favoriteCategory = contentString(content, content->categories[k].nameOff);
+        }
+    }
+}
+
+
+// --- 기록 분석 ---
+// 네 단계를 모두 스레드에 나눠 실행한다: 날짜 범위 → 기록 블록 집계 → 비트맵 채우기 → 사용자 비트맵 집계.
+// 집계는 블록의 항목 배열(day, type, contentId, coinsEarned, response)을 순서대로 읽기만 하고
+// 스레드마다 따로 더한 뒤 마지막에 합친다. 날짜 × 사용자 비트맵은 날짜 행을 스레드에 나눠
+// 각 스레드가 day/user 열 전체를 훑으며 자기 행만 채우므로 잠금이나 원자적 연산이 없다
+// (여러 스레드가 같은 단어에 원자적 OR을 하는 것보다 열을 한 번 더 순차로 읽는 편이 싸다).
+
+// Dare ID → 도전 번호 (없는 도전이면 -1)
+static int reportDareSlot(const ReportScan* scan, int contentId) {
+    if (scan->dareSlots != NULL) {
+        unsigned int offset = (unsigned int)contentId - (unsigned int)scan->dareMinId;
+        return offset < (unsigned int)scan->dareSpan ? scan->dareSlots[offset] - 1 : -1;
+    }
+    return findDareRow(scan->content, contentId);
+}
+
+static void reportScanRange(ReportWorker* w) {
+    const ReportScan* scan = w->scan;
+    const RecordStore* store = &scan->ctx->records;
+    int minDay = w->minDay, maxDay = w->maxDay;
+    for (int b = w->firstBlock; b < w->endBlock; b++) {
+        const RecordBlock* block = (const RecordBlock*)segAt(&store->blocks, b);
+        int rows = scan->rowCount - (b << RECORD_BLOCK_SHIFT);
+        if (rows > RECORD_BLOCK_ROWS) rows = RECORD_BLOCK_ROWS;
+        for (int i = 0; i < rows; i++) {
+            int day = block->day[i];
+            minDay = day < minDay ? day : minDay;
+            maxDay = day > maxDay ? day : maxDay;
+        }
+    }
+    w->minDay = minDay;
+    w->maxDay = maxDay;
+}
+
+static void reportScanRecords(ReportWorker* w) {
+    const ReportScan* scan = w->scan;
+    const RecordStore* store = &scan->ctx->records;
+    long long* truth = w->daily + (size_t)REPORT_COL_TRUTH * scan->numDays;
+    long long* dare = w->daily + (size_t)REPORT_COL_DARE * scan->numDays;
+    long long* complete = w->daily + (size_t)REPORT_COL_COMPLETE * scan->numDays;
+    long long* coins = w->daily + (size_t)REPORT_COL_COINS * scan->numDays;
+    for (int b = w->firstBlock; b < w->endBlock; b++) {
+        const RecordBlock* block = (const RecordBlock*)segAt(&store->blocks, b);
+        int rows = scan->rowCount - (b << RECORD_BLOCK_SHIFT);
+        if (rows > RECORD_BLOCK_ROWS) rows = RECORD_BLOCK_ROWS;
+        for (int i = 0; i < rows; i++) {
+            unsigned int d = (unsigned int)(block->day[i] - scan->firstDay);
+            if (d >= (unsigned int)scan->numDays) continue;
+            w->records++;
+            coins[d] += block->coinsEarned[i];
+            if (block->type[i] == 0) {
+                truth[d]++;
+                continue;
+            }
+            int done = block->response[i] == scan->complete;
+            dare[d]++;
+            complete[d] += done;
+            int slot = reportDareSlot(scan, block->contentId[i]);
+            if (slot >= 0) {
+                w->dareCounts[slot * 2]++;
+                w->dareCounts[slot * 2 + 1] += done;
+            }
+        }
+    }
+}
+
+static void reportFillBitmap(ReportWorker* w) {
+    const ReportScan* scan = w->scan;
+    const RecordStore* store = &scan->ctx->records;
+    int blocks = (scan->rowCount + RECORD_BLOCK_ROWS - 1) >> RECORD_BLOCK_SHIFT;
+    int rows = w->endRow - w->firstRow;
+    int firstDay = scan->firstDay + w->firstRow;
+    uint64_t* bits = scan->userBits + (size_t)w->firstRow * scan->words * 2;
+    for (int b = 0; b < blocks; b++) {
+        const RecordBlock* block = (const RecordBlock*)segAt(&store->blocks, b);
+        int n = scan->rowCount - (b << RECORD_BLOCK_SHIFT);
+        if (n > RECORD_BLOCK_ROWS) n = RECORD_BLOCK_ROWS;
+        for (int i = 0; i < n; i++) {
+            unsigned int d = (unsigned int)(block->day[i] - firstDay);
+            if (d >= (unsigned int)rows) continue;
+            // 가입하지 않은 사용자(음수)와 스캔을 시작한 뒤 가입한 사용자는 활동 집계에서 뺌
+            int user = block->user[i];
+            if ((unsigned int)user >= (unsigned int)scan->numUsers) continue;
+            uint64_t* pair = bits + ((size_t)d * scan->words + (user >> 6)) * 2;
+            pair[0] |= 1ull << (user & 63);
+            pair[1] |= (uint64_t)(block->type[i] == 0) << (user & 63);
+        }
+    }
+}
+
+// 최장 연속 일수 → streakUsers 구간 (1, 2-3, 4-7, 8-14, 15-30, 31 이상)
+static int reportStreakBucket(int days) {
+    if (days <= 1) return 0;
+    if (days <= 3) return 1;
+    if (days <= 7) return 2;
+    if (days <= 14) return 3;
+    if (days <= 30) return 4;
+    return 5;
+}
+
+// 맡은 사용자 64명 단위마다 날짜 순서로 켜진 Truth 비트만 따라가며 연속 일수를 셈
+static void reportScanUsers(ReportWorker* w) {
+    const ReportScan* scan = w->scan;
+    long long* active = w->daily + (size_t)REPORT_COL_ACTIVE * scan->numDays;
+    for (int word = w->firstWord; word < w->endWord; word++) {
+        int run[64] = {0}, best[64] = {0}, last[64];
+        for (int j = 0; j < 64; j++) last[j] = -2; // 마지막으로 답한 날짜 행
+        for (int d = 0; d < scan->numDays; d++) {
+            const uint64_t* pair = scan->userBits + ((size_t)d * scan->words + word) * 2;
+            active[d] += __builtin_popcountll(pair[0]);
+            for (uint64_t bits = pair[1]; bits != 0; bits &= bits - 1) {
+                int j = __builtin_ctzll(bits);
+                run[j] = last[j] == d - 1 ? run[j] + 1 : 1;
+                last[j] = d;
+                if (run[j] > best[j]) best[j] = run[j];
+            }
+        }
+        for (int j = 0; j < 64; j++) {
+            if (best[j] == 0) continue; // 범위 안에 Truth 답변 없음 (또는 없는 사용자)
+            w->streakUsers[reportStreakBucket(best[j])]++;
+            if (best[j] > w->longestStreak) w->longestStreak = best[j];
+            w->ongoingStreaks += last[j] == scan->numDays - 1;
+        }
+    }
+}
+
+static void* reportWorkerMain(void* arg) {
+    ReportWorker* w = arg;
+    if (w->pass == REPORT_PASS_RANGE) reportScanRange(w);
+    else if (w->pass == REPORT_PASS_SCAN) reportScanRecords(w);
+    else if (w->pass == REPORT_PASS_BITMAP) reportFillBitmap(w);
+    else reportScanUsers(w);
+    return NULL;
+}
+
+// 모든 작업자로 한 단계 실행 (첫 번째는 호출한 스레드, 스레드를 만들 수 없으면 그 몫도 직접 실행)
+static void runReportPass(ReportWorker* workers, int count, int pass) {
+    for (int i = 0; i < count; i++) workers[i].pass = pass;
+#ifndef _WIN32
+    for (int i = 1; i < count; i++) {
+        workers[i].started = pthread_create(&workers[i].thread, NULL, reportWorkerMain, &workers[i]) == 0;
+    }
+#endif
+    reportWorkerMain(&workers[0]);
+    for (int i = 1; i < count; i++) {
+#ifndef _WIN32
+        if (workers[i].started) {
+            pthread_join(workers[i].thread, NULL);
+            continue;
+        }
+#endif
+        reportWorkerMain(&workers[i]);
+    }
+}
+
+// [0, total)을 count개로 나눈 i번째 구간
+static void reportSplit(int total, int count, int i, int* first, int* end) {
+    *first = (int)((long long)total * i / count);
+    *end = (int)((long long)total * (i + 1) / count);
+}
+
+// 도전 ID순의 도전별 집계와 카테고리별 집계 구성
+static void buildReportDareStats(const ContentTable* content, GameReport* report, const long long* dareCounts, int numChallenges) {
+    report->challenges = calloc(numChallenges + 1, sizeof(ReportDareStats));
+    report->categories = calloc(numChallenges + 1, sizeof(ReportDareStats));
+    if (report->challenges == NULL || report->categories == NULL) outOfMemory();
+    report->numChallenges = numChallenges;
+    for (int i = 0; i < numChallenges; i++) {
+        DareChallenge d = dareAt(content, i);
+        ReportDareStats* c = &report->challenges[i];
+        c->category = d.category;
+        c->contentId = d.id;
+        c->attempts = dareCounts[i * 2];
+        c->completions = dareCounts[i * 2 + 1];
+        int k = 0;
+        while (k < report->numCategories && strcmp(report->categories[k].category, d.category) != 0) k++;
+        if (k == report->numCategories) {
+            report->categories[k].category = d.category;
+            report->categories[k].contentId = -1;
+            report->numCategories++;
+        }
+        report->categories[k].attempts += c->attempts;
+        report->categories[k].completions += c->completions;
+    }
+}
+
+GameReport* buildGameReport(GameContext* ctx, int firstDay, int lastDay, int threads) {
+    uint64_t start = statsBegin(ctx);
+    GameReport* report = calloc(1, sizeof(GameReport));
+    if (report == NULL) return NULL;
+    ReportScan scan;
+    memset(&scan, 0, sizeof(scan));
+    scan.ctx = ctx;
+    scan.content = contentAcquire(ctx);
+    scan.rowCount = recordCount(&ctx->records);
+    scan.numUsers = userCount(ctx);
+    int blocks = (scan.rowCount + RECORD_BLOCK_ROWS - 1) >> RECORD_BLOCK_SHIFT;
+
+#ifdef _WIN32
+    threads = 1;
+#else
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (threads > REPORT_MAX_THREADS) threads = REPORT_MAX_THREADS;
+    if (threads > blocks) threads = blocks;
+    if (threads < 1) threads = 1;
+    ReportWorker* workers = calloc(threads, sizeof(ReportWorker));
+    if (workers == NULL) outOfMemory();
+    for (int i = 0; i < threads; i++) {
+        workers[i].scan = &scan;
+        workers[i].minDay = INT_MAX;
+        workers[i].maxDay = INT_MIN;
+        reportSplit(blocks, threads, i, &workers[i].firstBlock, &workers[i].endBlock);
+    }
+
+    // 1. 실제 기록이 있는 날짜로 범위를 좁힘 (비트맵 크기가 날짜 수에 비례하므로)
+    runReportPass(workers, threads, REPORT_PASS_RANGE);
+    int minDay = INT_MAX, maxDay = INT_MIN;
+    for (int i = 0; i < threads; i++) {
+        if (workers[i].minDay < minDay) minDay = workers[i].minDay;
+        if (workers[i].maxDay > maxDay) maxDay = workers[i].maxDay;
+    }
+    if (firstDay == DAY_NONE || firstDay < minDay) firstDay = minDay;
+    if (lastDay == DAY_NONE || lastDay > maxDay) lastDay = maxDay;
+    report->firstDay = firstDay;
+    report->lastDay = lastDay;
+    report->numDays = scan.rowCount > 0 && firstDay <= lastDay ? lastDay - firstDay + 1 : 0;
+
+    // 2. 기록 블록 스캔 (Dare 도전 목록과 "Complete" 공유 문자열은 미리 찾아 둠)
+    scan.firstDay = firstDay;
+    scan.numDays = report->numDays;
+    scan.words = (scan.numUsers + 63) / 64;
+    scan.numChallenges = scan.content->dareCount;
+    gameLock(&ctx->recordsLock); // 공유 문자열 해시는 기록을 추가할 때 바뀜
+    int completeIdx = recordInternFind(&ctx->records, "Complete");
+    scan.complete = completeIdx >= 0 ? recordInterned(&ctx->records, completeIdx) : NULL;
+    gameUnlock(&ctx->recordsLock);
+    int* dareSlots = NULL;
+    if (scan.numChallenges > 0) {
+        int minId = INT_MAX, maxId = INT_MIN;
+        for (int i = 0; i < scan.numChallenges; i++) {
+            int id = scan.content->dareRows[i].id;
+            minId = id < minId ? id : minId;
+            maxId = id > maxId ? id : maxId;
+        }
+        if ((long long)maxId - minId < REPORT_DENSE_ID_SPAN) {
+            scan.dareMinId = minId;
+            scan.dareSpan = maxId - minId + 1;
+            dareSlots = calloc(scan.dareSpan, sizeof(int));
+            if (dareSlots == NULL) outOfMemory();
+            for (int i = 0; i < scan.numChallenges; i++) {
+                int slot = scan.content->dareRows[i].id - minId;
+                if (dareSlots[slot] == 0) dareSlots[slot] = i + 1; // 같은 ID가 여럿이면 인덱스처럼 처음 것
+            }
+            scan.dareSlots = dareSlots;
+        }
+    }
+    size_t bitWords = (size_t)scan.numDays * scan.words;
+    scan.userBits = calloc(bitWords * 2 + 1, sizeof(uint64_t));
+    if (scan.userBits == NULL) outOfMemory();
+    for (int i = 0; i < threads; i++) {
+        workers[i].daily = calloc((size_t)REPORT_COL_COUNT * scan.numDays + 1, sizeof(long long));
+        workers[i].dareCounts = calloc((size_t)scan.numChallenges * 2 + 1, sizeof(long long));
+        if (workers[i].daily == NULL || workers[i].dareCounts == NULL) outOfMemory();
+        reportSplit(scan.numDays, threads, i, &workers[i].firstRow, &workers[i].endRow);
+        reportSplit(scan.words, threads, i, &workers[i].firstWord, &workers[i].endWord);
+    }
+    if (scan.numDays > 0) {
+        runReportPass(workers, threads, REPORT_PASS_SCAN);
+        // 3. 날짜 × 사용자 비트맵 채우기와 집계
+        runReportPass(workers, threads, REPORT_PASS_BITMAP);
+        runReportPass(workers, threads, REPORT_PASS_USERS);
+    }
+
+    // 4. 부분 결과 합치기
+    report->activeUsers = calloc(scan.numDays + 1, sizeof(int));
+    report->truthAnswers = calloc(scan.numDays + 1, sizeof(long long));
+    report->dareAttempts = calloc(scan.numDays + 1, sizeof(long long));
+    report->dareCompletions = calloc(scan.numDays + 1, sizeof(long long));
+    report->coinsIssued = calloc(scan.numDays + 1, sizeof(long long));
+    long long* dareCounts = calloc((size_t)scan.numChallenges * 2 + 1, sizeof(long long));
+    if (report->activeUsers == NULL || report->truthAnswers == NULL || report->dareAttempts == NULL ||
+        report->dareCompletions == NULL || report->coinsIssued == NULL || dareCounts == NULL) {
+        outOfMemory();
+    }
+    for (int i = 0; i < threads; i++) {
+        ReportWorker* w = &workers[i];
+        const long long* daily = w->daily;
+        for (int d = 0; d < scan.numDays; d++) {
+            report->truthAnswers[d] += daily[(size_t)REPORT_COL_TRUTH * scan.numDays + d];
+            report->dareAttempts[d] += daily[(size_t)REPORT_COL_DARE * scan.numDays + d];
+            report->dareCompletions[d] += daily[(size_t)REPORT_COL_COMPLETE * scan.numDays + d];
+            report->coinsIssued[d] += daily[(size_t)REPORT_COL_COINS * scan.numDays + d];
+            report->activeUsers[d] += (int)daily[(size_t)REPORT_COL_ACTIVE * scan.numDays + d];
+        }
+        for (int c = 0; c < scan.numChallenges * 2; c++) dareCounts[c] += w->dareCounts[c];
+        for (int k = 0; k < REPORT_STREAK_BUCKETS; k++) report->streakUsers[k] += w->streakUsers[k];
+        if (w->longestStreak > report->longestStreak) report->longestStreak = w->longestStreak;
+        report->ongoingStreaks += w->ongoingStreaks;
+        report->records += w->records;
+        free(w->daily);
+        free(w->dareCounts);
+    }
+    buildReportDareStats(scan.content, report, dareCounts, scan.numChallenges);
+
+    free(dareCounts);
+    free(dareSlots);
+    free(scan.userBits);
+    free(workers);
+    statsEnd(ctx, STAT_REPORT, start);
+    return report;
+}
+
+void freeGameReport(GameReport* report) {
+    if (report == NULL) return;
+    free(report->activeUsers);
+    free(report->truthAnswers);
+    free(report->dareAttempts);
+    free(report->dareCompletions);
+    free(report->coinsIssued);
+    free(report->categories);
+    free(report->challenges);
+    free(report);
+}
@@ -0,0 +1,283 @@
+// Truth or Dare 게임 엔진 (화면 입출력 없음)
+//
+// 모든 상태는 GameContext 하나에 들어 있으며 전역 변수가 없다.
+// 한 프로세스에서 여러 컨텍스트를 서로 다른 데이터 디렉터리로 동시에 열 수 있다.
+// startGame 이후의 세션/조회 함수는 한 컨텍스트를 여러 스레드에서 동시에 호출해도 된다
+// (사용자 표는 ID 해시로 나눈 샤드마다 잠금, 코인과 Dare 시도 횟수는 원자적 카운터).
+// 로드/유지보수 함수(loadGame, compactUserRecords, saveSnapshot 등)는 한 스레드에서만 호출한다.
+// startGame 이후 데이터 디렉터리의 질문/도전 파일이 바뀌면 다시 시작하지 않아도 새 내용으로 교체된다.
+// 질문/도전 포인터(와 보고서의 카테고리 문자열)는 같은 스레드가 다음에 질문/도전을 조회할 때까지 유효하다.
+//
+// 사용 순서: createGameContext → loadGame → startGame → (세션 함수들) → destroyGameContext
+
+#ifndef GAME_CORE_H
+#define GAME_CORE_H
+
+#include <stdio.h>
+
+// 최대 길이를 정의하여 버퍼 오버플로우 방지
+#define MAX_ID_LEN 50
+#define MAX_PW_LEN 50
+#define MAX_ANSWER_LEN 500
+#define MAX_DATE_LEN 15 // YYYY-MM-DD\0
+#define DAY_NONE (-2147483647 - 1) // 날짜 없음 (예: 아직 Truth에 답하지 않음)
+#define MAX_DARE_ATTEMPTS_PER_DAY 5
+#define MAX_DARE_WEIGHT 1000 // dare_challenges.txt의 "*가중치" 칸 최댓값 (난이도, 보상, 최신 여부 등을 작성자가 가중치로 적음)
+#define USER_CATEGORY_SLOTS 8 // 누적 통계에서 사용자마다 따로 세는 Dare 카테고리 수 (넘치면 가장 적게 시도한 칸을 물려받음)
+
+// --- 구조체 정의 ---
+
+// 카테고리별 Dare 시도 수 (category: Dare 카테고리 ID, 0: 빈 칸)
+typedef struct {
+    int category;
+    int dares;
+} UserCategoryCount;
+
+// 사용자별 누적 통계 (기록을 추가할 때 O(1)로 갱신하고 users.txt의 사용자 행에 함께 저장)
+typedef struct {
+    int truthAnswers;    // Truth 답변 수
+    int dareAttempts;    // Dare 시도 수
+    int dareCompletions; // Dare 완료 수
+    int truthStreak;     // truthStreakDay까지 이어진 Truth 연속 참여 일수
+    int truthStreakDay;  // 연속 참여의 마지막 날짜 (DAY_NONE: 없음)
+    int weekStart;       // weekCoins를 모은 주의 월요일 (DAY_NONE: 없음)
+    int weekCoins;       // 그 주에 Dare로 얻은 코인
+    UserCategoryCount categoryDares[USER_CATEGORY_SLOTS]; // 카테고리별 Dare 시도 수 (앞에서부터 채움)
+} UserStats;
+
+// 사용자 정보 구조체
+typedef struct {
+    char id[MAX_ID_LEN];
+    char password[MAX_PW_LEN];
+    _Atomic int coins;                // 여러 세션이 동시에 갱신 (원자적 카운터)
+    int lastTruthDay;                 // Truth 완료한 마지막 날짜 (1970-01-01부터의 일수, DAY_NONE: 없음)
+    int lastDareDay;                  // Dare 시도한 마지막 날짜
+    _Atomic int dareAttemptsToday;    // 오늘 Dare 시도 횟수 (원자적 카운터)
+    UserStats stats;                  // 누적 통계 (샤드 잠금으로 보호)
+    int truthBagFirstId;              // Truth 질문 주머니 바퀴의 첫 질문 ID (바퀴를 시작할 때의 가장 작은 ID)
+    unsigned int truthBagSpan;        // 바퀴가 도는 ID 범위의 크기 (0: 아직 없음, 다음에 질문을 낼 때 섞음)
+    unsigned int truthBagCursor;      // 바퀴에서 지금 차례 (truthBagSpan에 닿으면 새로 섞음)
+    unsigned int truthBagKey;         // 바퀴의 순서를 정하는 키 (순열은 저장하지 않고 키로 계산)
+    int dirty;                        // 파일에 아직 쓰지 않은 변경이 있음 (파일에 저장하지 않음)
+    int statsStale;                   // 통계를 기록에서 다시 계산해야 함 (파일에 저장하지 않음)
+} User;
+
+// Truth 질문 구조체 (문자열은 엔진의 콘텐츠 판을 가리킴, 길이 제한 없는 UTF-8)
+typedef struct {
+    int id;
+    const char* question;
+} TruthQuestion;
+
+// Dare 도전 구조체
+typedef struct {
+    int id;
+    const char* category;
+    const char* challenge;
+    int weight; // 같은 카테고리 안에서 뽑힐 상대 가중치 (1~MAX_DARE_WEIGHT, 파일에 없으면 1)
+} DareChallenge;
+
+// 사용자 기록 구조체 (엔진의 열 저장소에서 한 행을 읽어 채운 값)
+// 문자열은 엔진 저장소를 가리키며 컨텍스트가 살아 있는 동안 유효하다.
+typedef struct {
+    const char* userId;
+    int day;  // 날짜 (1970-01-01부터의 일수, 출력은 formatGameDay)
+    int type; // 0: Truth, 1: Dare
+    int contentId; // TruthQuestion 또는 DareChallenge의 ID
+    const char* response; // Truth 답변 또는 Dare 결과 (Complete/Fail)
+    int coinsEarned; // Dare로 획득한 코인 (Truth는 0)
+} UserRecord;
+
+// 세션 사용자의 통계 요약 (오늘 기준으로 계산한 값)
+typedef struct {
+    int truthAnswers;
+    int dareAttempts;
+    int dareCompletions;
+    int truthStreak;              // 오늘 또는 어제까지 이어지는 Truth 연속 참여 일수 (끊겼으면 0)
+    int weekCoins;                // 이번 주(월요일부터) Dare로 얻은 코인
+    const char* favoriteCategory; // 지금 콘텐츠에 있는 카테고리 중 가장 많이 시도한 Dare 카테고리 (없으면 NULL, 이름의 유효 기간은 listDareCategories와 같음)
+} UserStatsSummary;
+
+// 저장 내구성 수준
+enum {
+    DURABILITY_NONE = 0, // fsync 하지 않음 (OS에 맡김)
+    DURABILITY_BATCH,    // 그룹 커밋마다 한 번 fsync (기본값, 핸들러는 기다리지 않음)
+    DURABILITY_SYNC      // 핸들러가 자기 변경이 fsync될 때까지 기다림
+};
+
+// 기간별 코인 순위 (오늘 포함 최근 1일 / 7일 / 30일 동안 Dare로 얻은 코인)
+enum {
+    RANK_DAILY = 0,
+    RANK_WEEKLY,
+    RANK_MONTHLY,
+    RANK_WINDOW_COUNT
+};
+
+// 게임 동작 결과
+enum {
+    GAME_OK = 0,
+    GAME_ERR_DUPLICATE_ID,    // 이미 존재하는 ID
+    GAME_ERR_AUTH,            // ID 또는 비밀번호 불일치
+    GAME_ERR_NOT_LOGGED_IN,   // 로그인하지 않은 세션
+    GAME_ERR_ALREADY_ANSWERED, // 오늘 Truth에 이미 답함
+    GAME_ERR_NO_ATTEMPTS,     // 오늘 Dare 도전 횟수를 모두 사용함
+    GAME_ERR_USERS_FULL       // 공유 사용자 표에 빈 자리가 없음
+};
+
+// 컨텍스트 설정
+typedef struct {
+    const char* dataDir; // 데이터 파일 디렉터리 (NULL: 현재 디렉터리)
+    FILE* log;           // 로드/저장 메시지 출력 대상 (NULL: 출력하지 않음)
+    int durability;      // DURABILITY_*
+    unsigned int seed;   // 질문/도전 선택 난수 시드 (0: 현재 시각, 그 밖: 사용자별 질문 순서와 스레드별 난수 흐름을 재현)
+    int stats;             // 1: 동작별 지연/입출력 계측 (0이면 측정하지 않으며 비용이 거의 없음)
+    const char* statsFile; // 계측 결과를 주기적으로 덮어쓸 파일 (NULL: 쓰지 않음, stats가 1일 때만)
+    int statsInterval;     // statsFile 갱신 주기 (초, 0: 10초)
+    int sharedUsers;       // 1: 같은 데이터 디렉터리를 쓰는 로컬 프로세스들과 사용자 표/코인 순위를 공유 (Linux)
+    int sharedCapacity;    // 공유 사용자 표를 처음 만들 때의 최대 사용자 수 (0: 1048576)
+} GameConfig;
+
+typedef struct GameContext GameContext;
+
+#define REPORT_STREAK_BUCKETS 6 // 최장 Truth 연속 참여 일수 구간: 1, 2-3, 4-7, 8-14, 15-30, 31 이상
+
+// 기록 분석: Dare 도전 또는 카테고리 하나의 집계
+typedef struct {
+    const char* category; // 카테고리 이름 (엔진 저장소를 가리킴)
+    int contentId;        // DareChallenge ID (카테고리 집계는 -1)
+    long long attempts;
+    long long completions;
+} ReportDareStats;
+
+// 기록 분석 결과 (날짜별 배열은 firstDay부터 numDays개)
+typedef struct {
+    int firstDay;              // 집계한 날짜 범위 (양 끝 포함, 기록이 있는 날짜로 좁힘)
+    int lastDay;
+    int numDays;               // 0: 범위 안에 기록 없음
+    long long records;         // 범위 안의 기록 수
+    int* activeUsers;          // 날짜별 기록을 남긴 가입 사용자 수
+    long long* truthAnswers;   // 날짜별 Truth 답변 수
+    long long* dareAttempts;   // 날짜별 Dare 시도 수
+    long long* dareCompletions;
+    long long* coinsIssued;    // 날짜별 지급한 코인
+    ReportDareStats* categories; // 카테고리별 Dare 완료율 (도전 목록에 처음 나오는 순서)
+    int numCategories;
+    ReportDareStats* challenges; // 도전별 성공률 (도전 ID순, 시도 없는 도전 포함)
+    int numChallenges;
+    int streakUsers[REPORT_STREAK_BUCKETS]; // 범위 안 최장 Truth 연속 참여 일수 구간별 사용자 수
+    int longestStreak;         // 가장 긴 Truth 연속 참여 일수
+    int ongoingStreaks;        // lastDay까지 연속 참여가 이어지는 사용자 수
+} GameReport;
+
+// 세션 핸들: 한 컨텍스트에 로그인한 사용자 하나 (복사해도 됨)
+typedef struct {
+    GameContext* ctx;
+    int userIdx; // 로그인한 사용자 인덱스 (-1: 로그인 전)
+} GameSession;
+
+
+// --- 컨텍스트 ---
+
+// 새 컨텍스트 생성 (실패 시 NULL)
+GameContext* createGameContext(const GameConfig* config);
+// 남은 변경을 모두 저장하고 컨텍스트 해제
+void destroyGameContext(GameContext* ctx);
+// 데이터 디렉터리에서 사용자/콘텐츠/기록 로드 (바뀌지 않은 부분은 스냅샷 사용)
+void loadGame(GameContext* ctx);
+// 저장 스레드와 콘텐츠 파일 감시 시작 (이후 변경은 비동기로 저장됨)
+void startGame(GameContext* ctx);
+// 지금까지의 변경이 모두 파일에 반영될 때까지 대기
+void flushGame(GameContext* ctx);
+
+// 유지보수 작업 (loadGame 이후, startGame 이전에 호출)
+void compactUserRecords(GameContext* ctx);   // 기록 저널을 압축본에 합침
+int saveSnapshot(GameContext* ctx);          // 스냅샷 파일 저장 (성공 시 1)
+int importSnapshot(GameContext* ctx);        // 스냅샷 내용으로 텍스트 파일 재작성 (loadGame 대신 호출, 성공 시 1)
+void rebuildUserStats(GameContext* ctx);     // 모든 사용자 통계를 기록에서 다시 계산
+int buildContentCatalog(GameContext* ctx);   // 질문/도전 텍스트 파일로 콘텐츠 카탈로그 생성 (loadGame 대신 호출, 성공 시 1)
+
+
+// --- 세션 ---
+
+// 회원가입 (GAME_OK / GAME_ERR_DUPLICATE_ID / GAME_ERR_USERS_FULL)
+int signUpUser(GameContext* ctx, const char* id, const char* password);
+// 로그인 후 일일 상태 갱신 (GAME_OK / GAME_ERR_AUTH)
+int loginSession(GameContext* ctx, GameSession* session, const char* id, const char* password);
+// 로그인한 사용자 정보
+const User* sessionUser(const GameSession* session);
+
+// 오늘 Truth 질문에 이미 답했는지
+int hasAnsweredTruthToday(const GameSession* session);
+// 세션 사용자의 Truth 질문 (질문이 없으면 NULL)
+// 사용자마다 질문 전체를 따로 섞은 순서로 하나씩 내므로 모든 질문을 한 번씩 받기 전에는 같은 질문이 나오지 않으며,
+// 답하기 전까지는 같은 질문을 다시 보여 준다. GameConfig.seed를 주면 사용자별 순서가 실행마다 같다.
+// 콘텐츠를 다시 읽어도 진행 중인 바퀴는 이어지며, 그 사이 추가된 질문은 다음 바퀴부터 나온다.
+const TruthQuestion* getTruthQuestion(GameSession* session);
+// Truth 답변 저장 (GAME_OK / GAME_ERR_ALREADY_ANSWERED)
+int answerTruth(GameSession* session, int questionId, const char* answer);
+
+// 오늘 남은 Dare 도전 횟수 (날짜가 바뀌었으면 먼저 초기화)
+int dareAttemptsLeft(GameSession* session);
+// 콘텐츠에 있는 Dare 카테고리의 ID와 이름을 최대 max개 ids/names에 채움 (전체 개수 반환, 필요 없는 쪽은 NULL)
+// ID는 1부터의 작은 정수로, 이름마다 데이터 디렉터리에서 한 번 정해져 콘텐츠를 다시 읽거나 다시 시작해도 바뀌지 않는다.
+// 이름은 같은 스레드가 다음에 질문/도전/카테고리를 조회할 때까지 유효하다.
+int listDareCategories(GameContext* ctx, int* ids, const char** names, int max);
+// 카테고리 ID로 가중치에 비례해 Dare 도전 하나를 뽑음 (지금 콘텐츠에 없거나 비었으면 NULL, 카테고리 표와 별칭 표로 O(1))
+const DareChallenge* getRandomDareChallenge(GameContext* ctx, int categoryId);
+// Dare 결과 저장 (1: 완료, 2: 실패, 그 밖: 잘못된 선택) - GAME_OK / GAME_ERR_NO_ATTEMPTS
+int attemptDare(GameSession* session, int dareId, int resultChoice, int* coinsEarned);
+
+
+// --- 조회 ---
+
+// 세션 사용자의 기록을 날짜순으로 start번째부터 최대 max개 out에 채움 (채운 개수 반환)
+int listRecords(const GameSession* session, int start, UserRecord* out, int max);
+// 세션 사용자의 Truth 답변 중 query의 토큰을 모두 포함하는 기록을 기록 순서로 start번째부터 최대 max개 채움
+// (채운 개수 반환) - 영문/숫자는 단어 단위로 대소문자 없이, 한글은 부분 문자열로 찾으며 기록 전체를 훑지 않는다.
+int searchRecords(const GameSession* session, const char* query, int start, UserRecord* out, int max);
+const TruthQuestion* findTruthQuestion(GameContext* ctx, int id);
+const DareChallenge* findDareChallenge(GameContext* ctx, int id);
+
+int gameUserCount(GameContext* ctx);
+const User* gameUserAt(GameContext* ctx, int userIdx);
+// 코인 순위 상위 max명의 사용자 인덱스를 out에 채움 (채운 개수 반환)
+int topRanks(GameContext* ctx, int* out, int max);
+// 세션 사용자의 순위 (1부터)
+int sessionRank(const GameSession* session);
+// 기간(RANK_*) 코인 순위 상위 max명의 사용자 인덱스와 기간 코인을 채움 (채운 개수 반환, coins는 NULL 가능)
+int topWindowRanks(GameContext* ctx, int window, int* out, int* coins, int max);
+// 세션 사용자의 기간 순위 (1부터, 기간 안에 얻은 코인이 없으면 0) - coins에 기간 코인
+int sessionWindowRank(const GameSession* session, int window, int* coins);
+// 세션 사용자의 통계 요약 (기록을 훑지 않고 누적 통계에서 바로 계산)
+void sessionStatsSummary(const GameSession* session, UserStatsSummary* out);
+
+
+// --- 분석 ---
+// 기록 열 저장소를 블록 단위로 여러 스레드에 나눠 항목 배열만 훑는다.
+// 세션과 동시에 호출해도 되며, 호출 시점까지 추가된 기록만 집계한다.
+
+// firstDay~lastDay 기록 집계 (DAY_NONE: 기록의 처음/마지막 날짜, threads: 스캔 스레드 수, 0이면 CPU 수)
+GameReport* buildGameReport(GameContext* ctx, int firstDay, int lastDay, int threads);
+void freeGameReport(GameReport* report);
+
+
+// --- 계측 ---
+// 스레드마다 따로 쌓은 카운터와 지연 히스토그램을 합쳐서 출력한다 (GameConfig.stats가 0이면 출력할 내용 없음).
+
+// 동작별 횟수, 평균/p50/p99/p999/최대 지연, 읽고 쓴 바이트 수, fsync 횟수 출력
+void dumpGameStats(GameContext* ctx, FILE* out);
+// 계측 스레드가 곧 stderr와 statsFile에 통계를 쓰도록 요청 (신호 처리기에서 호출해도 됨)
+void requestGameStatsDump(GameContext* ctx);
+
+
+// --- 문자열 도우미 ---
+
+// 개행 문자 제거 함수 (fgets 사용 시 유용)
+void removeNewline(char* str);
+// 길이 제한 문자열 복사 (항상 NUL 종료)
+void copyString(char* dst, const char* src, size_t size);
+// 일수 → "YYYY-MM-DD" (out은 MAX_DATE_LEN 이상, DAY_NONE은 "none")
+void formatGameDay(int day, char* out);
+// "YYYY-MM-DD" → 일수 (성공 시 1)
+int parseGameDay(const char* str, int* day);
+
+#endif
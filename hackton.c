@@ -1,86 +1,40 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h> // 시간 및 날짜 관련 함수
-#include <ctype.h> // 문자열 처리 (예: tolower)
-
-// 최대 길이를 정의하여 버퍼 오버플로우 방지
-#define MAX_ID_LEN 50
-#define MAX_PW_LEN 50
-#define MAX_QUESTION_LEN 200
-#define MAX_ANSWER_LEN 500
-#define MAX_CATEGORY_LEN 50
-#define MAX_DATE_LEN 15 // YYYY-MM-DD\0
-#define MAX_USERS 100
-#define MAX_RECORDS 1000
-#define MAX_QUESTIONS 50
-#define MAX_DARES 50
-#define MAX_DARE_ATTEMPTS_PER_DAY 5
-
-// 파일명 정의
-#define USERS_FILE "users.txt"
-#define RECORDS_FILE "records.txt"
-#define TRUTH_QUESTIONS_FILE "truth_questions.txt"
-#define DARE_CHALLENGES_FILE "dare_challenges.txt"
-
-// --- 구조체 정의 ---
-
-// 사용자 정보 구조체
-typedef struct {
-    char id[MAX_ID_LEN];
-    char password[MAX_PW_LEN];
-    int coins;
-    char lastTruthDate[MAX_DATE_LEN]; // Truth 완료한 마지막 날짜
-    char lastDareDate[MAX_DATE_LEN];  // Dare 시도한 마지막 날짜
-    int dareAttemptsToday;            // 오늘 Dare 시도 횟수
-} User;
-
-// Truth 질문 구조체
-typedef struct {
-    int id;
-    char question[MAX_QUESTION_LEN];
-    int used; // 해당 세션에서 이미 사용된 질문인지 표시 (0: No, 1: Yes)
-} TruthQuestion;
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h> // close, unlink
+#include <fcntl.h> // 논블로킹 소켓
+#include <signal.h> // SIGINT/SIGTERM 처리, SIGPIPE 무시, SIGUSR1 통계 덤프
+#include <sys/socket.h>
+#include <sys/un.h> // 유닉스 도메인 소켓
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h> // 서버 모드 이벤트 루프
+#include <sys/eventfd.h> // 작업 스레드 종료 알림
+#include <pthread.h> // 서버 작업 스레드
+#endif
 
-// Dare 도전 구조체
-typedef struct {
-    int id;
-    char category[MAX_CATEGORY_LEN];
-    char challenge[MAX_QUESTION_LEN];
-} DareChallenge;
-
-// 사용자 기록 구조체
-typedef struct {
-    char userId[MAX_ID_LEN];
-    char date[MAX_DATE_LEN];
-    int type; // 0: Truth, 1: Dare
-    int contentId; // TruthQuestion 또는 DareChallenge의 ID
-    char response[MAX_ANSWER_LEN]; // Truth 답변 또는 Dare 결과 (Complete/Fail)
-    int coinsEarned; // Dare로 획득한 코인 (Truth는 0)
-} UserRecord;
+#include "game_core.h" // 게임 엔진 (상태와 저장은 모두 여기서 처리)
 
+#define SESSION_INPUT_MAX (MAX_ANSWER_LEN + 16) // 서버 세션 한 줄 입력 버퍼 크기
+#define SERVER_MAX_EVENTS 256                    // epoll_wait 한 번에 받는 최대 이벤트 수
+#define SERVER_MAX_THREADS 64                    // 서버 작업 스레드 최대 수
 
 // --- 전역 변수 ---
-User users[MAX_USERS];
-int numUsers = 0;
-User currentUser; // 현재 로그인한 사용자
-
-TruthQuestion truthQuestions[MAX_QUESTIONS];
-int numTruthQuestions = 0;
-
-DareChallenge dareChallenges[MAX_DARES];
-int numDareChallenges = 0;
-
-UserRecord userRecords[MAX_RECORDS];
-int numRecords = 0;
+// 대화형 화면 하나가 쓰는 상태 (엔진 상태는 GameContext 안에 있음)
+GameContext* game = NULL;     // 게임 엔진 컨텍스트
+GameSession currentSession;   // 현재 로그인한 사용자 세션
 
 
 // 화면 지우기 (OS 호환성 고려)
+// 화면마다 셸을 띄우지 않도록 터미널 제어 문자열로 지움 (화면 지우기 + 커서를 맨 위로)
 void clearScreen() {
 #ifdef _WIN32
     system("cls");
 #else
-    system("clear");
+    fputs("\033[2J\033[H", stdout);
+    fflush(stdout);
 #endif
 }
 
@@ -91,156 +45,290 @@ void pauseExecution() {
     getchar(); // 실제 엔터키 입력 대기
 }
 
-// 현재 날짜를 YYYY-MM-DD 형식으로 가져오는 함수
-void getCurrentDate(char* dateStr) {
-    time_t t = time(NULL);
-    struct tm tm = *localtime(&t);
-    sprintf(dateStr, "%04d-%02d-%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+
+// --- 화면 출력 함수 (출력 대상 지정) ---
+
+void printAuthMenu(FILE* out) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "     Truth or Dare     \n");
+    fprintf(out, "=======================\n");
+    fprintf(out, "1. 로그인\n");
+    fprintf(out, "2. 회원가입\n");
+    fprintf(out, "0. 종료\n");
+    fprintf(out, "선택: ");
 }
 
-// 두 날짜 문자열이 같은지 비교하는 함수
-int isSameDate(const char* date1, const char* date2) {
-    return strcmp(date1, date2) == 0;
+void printMainMenu(FILE* out, const GameSession* session) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "     Truth or Dare     \n");
+    fprintf(out, "=======================\n");
+    fprintf(out, "1. Truth (오늘의 질문)\n");
+    fprintf(out, "2. Dare (오늘의 도전)\n");
+    fprintf(out, "3. 기록 보기\n");
+    fprintf(out, "4. 코인 기록\n");
+    fprintf(out, "5. 답변 검색\n");
+    fprintf(out, "0. 종료\n");
+    fprintf(out, "-----------------------\n");
+    // 누적 통계는 엔진이 기록을 추가할 때마다 갱신해 두므로 기록을 훑지 않고 바로 표시
+    UserStatsSummary stats;
+    sessionStatsSummary(session, &stats);
+    fprintf(out, "현재 코인: %d (이번 주 +%d)\n", sessionUser(session)->coins, stats.weekCoins); // 우측 상단 코인 표시
+    fprintf(out, "Truth 연속 %d일 | Dare 완료 %d회 | 자주 하는 카테고리: %s\n",
+            stats.truthStreak, stats.dareCompletions, stats.favoriteCategory ? stats.favoriteCategory : "없음");
+    fprintf(out, "선택: ");
 }
 
-// 개행 문자 제거 함수 (fgets 사용 시 유용)
-void removeNewline(char* str) {
-    str[strcspn(str, "\n")] = 0;
+void printTruthQuestion(FILE* out, const TruthQuestion* q) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "       오늘의 Truth      \n");
+    fprintf(out, "=======================\n");
+    fprintf(out, "질문: %s\n", q->question);
+    fprintf(out, "답변 (최대 %d자): ", MAX_ANSWER_LEN - 1);
 }
 
+void printDareLimitReached(FILE* out) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "     Dare 도전 완료!     \n");
+    fprintf(out, "=======================\n");
+    fprintf(out, "오늘은 더 이상 Dare 도전을 할 수 없습니다.\n");
+    fprintf(out, "5회 도전을 모두 완료하셨습니다. 정말 대단해요!\n");
+}
 
-// --- 데이터 로드/저장 함수 ---
+void printDareAllDone(FILE* out) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "     Dare 도전 완료!     \n");
+    fprintf(out, "=======================\n");
+    fprintf(out, "오늘의 Dare 도전을 모두 완료하셨습니다. 정말 대단해요!\n");
+}
 
-// 사용자 데이터 로드
-void loadUsers() {
-    FILE* fp = fopen(USERS_FILE, "r");
-    if (fp == NULL) {
-        printf("사용자 데이터 파일을 찾을 수 없습니다. 새로운 파일을 생성합니다.\n");
-        return;
+// 화면에 보여 준 Dare 카테고리 메뉴 (번호 - 1 → 카테고리 ID)
+// 고른 번호는 보여 준 그 목록으로 찾으므로, 그 사이 콘텐츠가 바뀌어도 다른 카테고리로 바뀌지 않는다.
+typedef struct {
+    int* ids;
+    int count;
+} DareMenu;
+
+void freeDareMenu(DareMenu* menu) {
+    free(menu->ids);
+    menu->ids = NULL;
+    menu->count = 0;
+}
+
+// 지금 콘텐츠의 카테고리로 메뉴를 새로 만들어 출력 (이전 메뉴는 버림)
+void printDareCategoryMenu(FILE* out, GameContext* ctx, DareMenu* menu, int attemptsLeft) {
+    // 한 번의 조회로 ID와 이름을 함께 받고, 그 사이 카테고리가 늘어 자리가 모자랐으면 늘려서 다시 받음
+    int capacity = menu->count > 0 ? menu->count : 16;
+    const char** names = NULL;
+    int count;
+    for (;;) {
+        int* ids = realloc(menu->ids, sizeof(int) * capacity);
+        const char** grown = realloc(names, sizeof(const char*) * capacity);
+        if (ids != NULL) menu->ids = ids;
+        if (grown != NULL) names = grown;
+        if (ids == NULL || grown == NULL) {
+            count = 0;
+            break;
+        }
+        count = listDareCategories(ctx, menu->ids, names, capacity);
+        if (count <= capacity) break;
+        capacity = count;
     }
-    numUsers = 0;
-    while (numUsers < MAX_USERS && fscanf(fp, "%s %s %d %s %s %d\n",
-                                          users[numUsers].id,
-                                          users[numUsers].password,
-                                          &users[numUsers].coins,
-                                          users[numUsers].lastTruthDate,
-                                          users[numUsers].lastDareDate,
-                                          &users[numUsers].dareAttemptsToday) == 6) {
-        numUsers++;
-    }
-    fclose(fp);
-    printf("사용자 데이터 로드 완료: %d명\n", numUsers);
-}
-
-// 사용자 데이터 저장
-void saveUsers() {
-    FILE* fp = fopen(USERS_FILE, "w");
-    if (fp == NULL) {
-        printf("사용자 데이터 파일을 저장할 수 없습니다.\n");
-        return;
+    menu->count = count;
+    fprintf(out, "=======================\n");
+    fprintf(out, "     Dare 카테고리     \n");
+    fprintf(out, "=======================\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "%d. %s\n", i + 1, names[i]);
     }
-    for (int i = 0; i < numUsers; i++) {
-        fprintf(fp, "%s %s %d %s %s %d\n",
-                users[i].id,
-                users[i].password,
-                users[i].coins,
-                users[i].lastTruthDate,
-                users[i].lastDareDate,
-                users[i].dareAttemptsToday);
-    }
-    fclose(fp);
-    printf("사용자 데이터 저장 완료.\n");
-}
-
-// Truth 질문 로드
-void loadTruthQuestions() {
-    FILE* fp = fopen(TRUTH_QUESTIONS_FILE, "r");
-    if (fp == NULL) {
-        printf("Truth 질문 파일을 찾을 수 없습니다. 기본 질문을 사용합니다.\n");
-        // 기본 질문 설정 (파일이 없을 경우)
-        truthQuestions[0] = (TruthQuestion){1, "오늘 가장 감사했던 일은 무엇인가요?", 0};
-        truthQuestions[1] = (TruthQuestion){2, "최근 자신을 성장시켰다고 생각하는 경험은 무엇인가요?", 0};
-        truthQuestions[2] = (TruthQuestion){3, "오늘 하루 느꼈던 감정을 색깔로 표현한다면 어떤 색깔인가요?", 0};
-        numTruthQuestions = 3;
-        return;
+    free(names);
+    fprintf(out, "0. 뒤로가기\n");
+    fprintf(out, "-----------------------\n");
+    fprintf(out, "오늘 남은 도전 횟수: %d회\n", attemptsLeft);
+    fprintf(out, "선택: ");
+}
+
+// Dare 메뉴 번호 → 카테고리 ID (잘못된 번호면 0)
+int dareMenuCategory(const DareMenu* menu, int choice) {
+    return choice >= 1 && choice <= menu->count ? menu->ids[choice - 1] : 0;
+}
+
+void printDareChallenge(FILE* out, const DareChallenge* d) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "       오늘의 Dare       \n");
+    fprintf(out, "=======================\n");
+    fprintf(out, "카테고리: %s\n", d->category);
+    fprintf(out, "도전: %s\n", d->challenge);
+    fprintf(out, "\n1. 도전 완료 (Complete)\n");
+    fprintf(out, "2. 도전 실패 (Fail)\n");
+    fprintf(out, "선택: ");
+}
+
+void printDareResult(FILE* out, int resultChoice) {
+    if (resultChoice == 1) {
+        fprintf(out, "\n축하합니다! 코인 10개를 획득했습니다!\n");
+    } else if (resultChoice == 2) {
+        fprintf(out, "\n아쉽지만 다음 기회에! 코인은 변동 없습니다.\n");
+    } else {
+        fprintf(out, "잘못된 선택입니다. 도전 결과가 기록되지 않습니다.\n");
     }
-    numTruthQuestions = 0;
-    char line[MAX_QUESTION_LEN + 10]; // ID + Question
-    while (numTruthQuestions < MAX_QUESTIONS && fgets(line, sizeof(line), fp) != NULL) {
-        // fscanf 대신 fgets로 한 줄을 읽고 sscanf로 파싱
-        sscanf(line, "%d %[^\n]", &truthQuestions[numTruthQuestions].id, truthQuestions[numTruthQuestions].question);
-        truthQuestions[numTruthQuestions].used = 0; // 초기화 시 사용되지 않음으로 설정
-        numTruthQuestions++;
-    }
-    fclose(fp);
-    printf("Truth 질문 로드 완료: %d개\n", numTruthQuestions);
-}
-
-// Dare 도전 로드
-void loadDareChallenges() {
-    FILE* fp = fopen(DARE_CHALLENGES_FILE, "r");
-    if (fp == NULL) {
-        printf("Dare 도전 파일을 찾을 수 없습니다. 기본 도전을 사용합니다.\n");
-        // 기본 도전 설정 (파일이 없을 경우)
-        dareChallenges[0] = (DareChallenge){101, "신체", "팔굽혀펴기 10개 하기"};
-        dareChallenges[1] = (DareChallenge){102, "학습", "새로운 단어 5개 외우기"};
-        dareChallenges[2] = (DareChallenge){103, "정서", "거울 보고 자신에게 칭찬 한마디 하기"};
-        numDareChallenges = 3;
-        return;
+}
+
+// 기록 한 건 출력
+void printRecord(FILE* out, GameContext* ctx, const UserRecord* rec) {
+    char date[MAX_DATE_LEN];
+    formatGameDay(rec->day, date);
+    fprintf(out, "\n날짜: %s\n", date);
+    if (rec->type == 0) { // Truth 기록
+        fprintf(out, "종류: Truth\n");
+        // 질문 내용 찾기 (ID 인덱스로 바로 조회, 복사 없음)
+        const TruthQuestion* q = findTruthQuestion(ctx, rec->contentId);
+        fprintf(out, "질문: %s\n", q ? q->question : "알 수 없는 질문");
+        fprintf(out, "답변: %s\n", rec->response);
+    } else { // Dare 기록
+        fprintf(out, "종류: Dare\n");
+        // 도전 내용 찾기
+        const DareChallenge* d = findDareChallenge(ctx, rec->contentId);
+        fprintf(out, "카테고리: %s\n", d ? d->category : "N/A");
+        fprintf(out, "도전: %s\n", d ? d->challenge : "알 수 없는 도전");
+        fprintf(out, "결과: %s (획득 코인: %d)\n", rec->response, rec->coinsEarned);
+    }
+    fprintf(out, "-----------------------\n");
+}
+
+// 사용자의 기록 출력
+void printRecords(FILE* out, const GameSession* session) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "       나의 기록        \n");
+    fprintf(out, "=======================\n");
+
+    // 엔진이 날짜순 기록을 조금씩 채워 주므로 받아서 바로 출력
+    UserRecord batch[64];
+    int start = 0;
+    int n;
+    while ((n = listRecords(session, start, batch, 64)) > 0) {
+        for (int i = 0; i < n; i++) printRecord(out, session->ctx, &batch[i]);
+        start += n;
     }
-    numDareChallenges = 0;
-    char line[MAX_QUESTION_LEN + MAX_CATEGORY_LEN + 20]; // ID + Category + Challenge
-    while (numDareChallenges < MAX_DARES && fgets(line, sizeof(line), fp) != NULL) {
-        sscanf(line, "%d %s %[^\n]", &dareChallenges[numDareChallenges].id,
-               dareChallenges[numDareChallenges].category, dareChallenges[numDareChallenges].challenge);
-        numDareChallenges++;
+    if (start == 0) {
+        fprintf(out, "아직 기록이 없습니다.\n");
     }
-    fclose(fp);
-    printf("Dare 도전 로드 완료: %d개\n", numDareChallenges);
 }
 
+void printSearchPrompt(FILE* out) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "       답변 검색        \n");
+    fprintf(out, "=======================\n");
+    fprintf(out, "검색어: ");
+}
 
-// 사용자 기록 로드
-void loadUserRecords() {
-    FILE* fp = fopen(RECORDS_FILE, "r");
-    if (fp == NULL) {
-        printf("기록 데이터 파일을 찾을 수 없습니다. 새로운 파일을 생성합니다.\n");
+// 검색어가 들어 있는 Truth 답변 출력
+void printSearchResults(FILE* out, const GameSession* session, const char* query) {
+    // 엔진의 답변 색인에서 일치하는 기록만 받아 출력 (기록 전체를 훑지 않음)
+    UserRecord batch[64];
+    int start = 0;
+    int n;
+    while ((n = searchRecords(session, query, start, batch, 64)) > 0) {
+        for (int i = 0; i < n; i++) printRecord(out, session->ctx, &batch[i]);
+        start += n;
+    }
+    if (start == 0) {
+        fprintf(out, "'%s'이(가) 들어 있는 답변이 없습니다.\n", query);
+    } else {
+        fprintf(out, "검색 결과: %d개\n", start);
+    }
+}
+
+// 코인 랭킹 출력
+void printCoinRanking(FILE* out, const GameSession* session) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "       코인 랭킹        \n");
+    fprintf(out, "=======================\n");
+
+    // 리더보드에서 바로 조회 (복사/정렬 없음)
+    int top[3];
+    int numTop = topRanks(session->ctx, top, 3);
+    if (numTop == 0) {
+        fprintf(out, "등록된 사용자가 없습니다.\n");
         return;
     }
-    numRecords = 0;
-    while (numRecords < MAX_RECORDS && fscanf(fp, "%s %s %d %d %d %[^\n]\n",
-                                              userRecords[numRecords].userId,
-                                              userRecords[numRecords].date,
-                                              &userRecords[numRecords].type,
-                                              &userRecords[numRecords].contentId,
-                                              &userRecords[numRecords].coinsEarned,
-                                              userRecords[numRecords].response) == 6) {
-        // 개행 문자가 남아있을 수 있으므로 추가 처리
-        removeNewline(userRecords[numRecords].response);
-        numRecords++;
-    }
-    fclose(fp);
-    printf("기록 데이터 로드 완료: %d개\n", numRecords);
-}
-
-// 사용자 기록 저장
-void saveUserRecords() {
-    FILE* fp = fopen(RECORDS_FILE, "w");
-    if (fp == NULL) {
-        printf("기록 데이터 파일을 저장할 수 없습니다.\n");
+
+    fprintf(out, "--- TOP 3 ---\n");
+    for (int i = 0; i < numTop; i++) {
+        const User* u = gameUserAt(session->ctx, top[i]);
+        fprintf(out, "%d위: %s - %d 코인\n", i + 1, u->id, u->coins);
+    }
+
+    fprintf(out, "\n--- 나의 순위 ---\n");
+    const User* me = sessionUser(session);
+    fprintf(out, "%d위: %s - %d 코인\n", sessionRank(session), me->id, me->coins);
+
+    // 기간별 순위 (Dare로 얻은 코인, 엔진이 날짜 버킷으로 유지하므로 기록을 훑지 않음)
+    static const char* const windowNames[RANK_WINDOW_COUNT] = { "오늘", "최근 7일", "최근 30일" };
+    for (int w = 0; w < RANK_WINDOW_COUNT; w++) {
+        int coins[3];
+        int n = topWindowRanks(session->ctx, w, top, coins, 3);
+        fprintf(out, "\n--- %s TOP 3 ---\n", windowNames[w]);
+        if (n == 0) fprintf(out, "아직 코인을 얻은 사용자가 없습니다.\n");
+        for (int i = 0; i < n; i++) {
+            fprintf(out, "%d위: %s - %d 코인\n", i + 1, gameUserAt(session->ctx, top[i])->id, coins[i]);
+        }
+        int myCoins;
+        int myRank = sessionWindowRank(session, w, &myCoins);
+        if (myRank > 0) fprintf(out, "나의 순위: %d위 - %d 코인\n", myRank, myCoins);
+        else fprintf(out, "나의 순위: 없음 (이 기간에 얻은 코인 없음)\n");
+    }
+}
+
+// 완료 횟수 / 시도 횟수 비율 (%)
+static double reportRate(long long completions, long long attempts) {
+    return attempts > 0 ? completions * 100.0 / attempts : 0;
+}
+
+// 기록 분석 보고서 출력
+void printGameReport(FILE* out, const GameReport* report) {
+    fprintf(out, "=======================\n");
+    fprintf(out, "       기록 분석        \n");
+    fprintf(out, "=======================\n");
+    if (report->numDays == 0) {
+        fprintf(out, "해당 기간에 기록이 없습니다.\n");
         return;
     }
-    for (int i = 0; i < numRecords; i++) {
-        fprintf(fp, "%s %s %d %d %d %s\n",
-                userRecords[i].userId,
-                userRecords[i].date,
-                userRecords[i].type,
-                userRecords[i].contentId,
-                userRecords[i].coinsEarned,
-                userRecords[i].response);
+    char first[MAX_DATE_LEN], last[MAX_DATE_LEN];
+    formatGameDay(report->firstDay, first);
+    formatGameDay(report->lastDay, last);
+    fprintf(out, "기간: %s ~ %s (%d일), 기록 %lld개\n", first, last, report->numDays, report->records);
+
+    fprintf(out, "\n--- 날짜별 ---\n");
+    fprintf(out, "날짜           활동    Truth     Dare     완료     코인\n"); // 한글은 두 칸이므로 직접 맞춤
+    for (int d = 0; d < report->numDays; d++) {
+        if (report->truthAnswers[d] == 0 && report->dareAttempts[d] == 0) continue; // 기록 없는 날
+        char date[MAX_DATE_LEN];
+        formatGameDay(report->firstDay + d, date);
+        fprintf(out, "%-10s %8d %8lld %8lld %8lld %8lld\n", date, report->activeUsers[d], report->truthAnswers[d],
+                report->dareAttempts[d], report->dareCompletions[d], report->coinsIssued[d]);
+    }
+
+    fprintf(out, "\n--- 카테고리별 Dare 완료율 ---\n");
+    for (int i = 0; i < report->numCategories; i++) {
+        const ReportDareStats* c = &report->categories[i];
+        fprintf(out, "%s: %lld / %lld (%.1f%%)\n", c->category, c->completions, c->attempts,
+                reportRate(c->completions, c->attempts));
     }
-    fclose(fp);
-    printf("기록 데이터 저장 완료.\n");
+
+    fprintf(out, "\n--- 도전별 성공률 (시도한 도전만) ---\n");
+    for (int i = 0; i < report->numChallenges; i++) {
+        const ReportDareStats* c = &report->challenges[i];
+        if (c->attempts == 0) continue;
+        fprintf(out, "ID %d (%s): %lld / %lld (%.1f%%)\n", c->contentId, c->category, c->completions, c->attempts,
+                reportRate(c->completions, c->attempts));
+    }
+
+    static const char* const streakLabels[REPORT_STREAK_BUCKETS] = { "1일", "2~3일", "4~7일", "8~14일", "15~30일", "31일 이상" };
+    fprintf(out, "\n--- Truth 연속 참여 (기간 안 최장) ---\n");
+    for (int k = 0; k < REPORT_STREAK_BUCKETS; k++) {
+        fprintf(out, "%s: %d명\n", streakLabels[k], report->streakUsers[k]);
+    }
+    fprintf(out, "가장 긴 연속 참여: %d일, %s까지 이어지는 사용자: %d명\n", report->longestStreak, last, report->ongoingStreaks);
 }
 
 
@@ -250,17 +338,11 @@ void saveUserRecords() {
 int handleLogin() {
     char inputId[MAX_ID_LEN];
     char inputPw[MAX_PW_LEN];
-    int userIdx = -1;
+    int loggedIn = 0;
 
-    while (userIdx == -1) {
+    while (!loggedIn) {
         clearScreen();
-        printf("=======================\n");
-        printf("     Truth or Dare     \n");
-        printf("=======================\n");
-        printf("1. 로그인\n");
-        printf("2. 회원가입\n");
-        printf("0. 종료\n");
-        printf("선택: ");
+        printAuthMenu(stdout);
 
         int choice;
         if (scanf("%d", &choice) != 1) {
@@ -281,47 +363,25 @@ int handleLogin() {
         removeNewline(inputPw);
 
         if (choice == 1) { // 로그인
-            for (int i = 0; i < numUsers; i++) {
-                if (strcmp(users[i].id, inputId) == 0 && strcmp(users[i].password, inputPw) == 0) {
-                    userIdx = i;
-                    break;
-                }
-            }
-            if (userIdx != -1) {
-                printf("로그인 성공!\n");
-                currentUser = users[userIdx]; // 전역 currentUser 업데이트
+            if (loginSession(game, &currentSession, inputId, inputPw) == GAME_OK) {
+                printf("로그인 성공!\n"); // 일일 상태 초기화는 엔진이 로그인 시 처리
+                loggedIn = 1;
             } else {
                 printf("ID 또는 비밀번호가 일치하지 않습니다. 다시 시도하세요.\n");
                 pauseExecution();
             }
         } else if (choice == 2) { // 회원가입
-            if (numUsers >= MAX_USERS) {
-                printf("더 이상 사용자를 추가할 수 없습니다.\n");
+            int result = signUpUser(game, inputId, inputPw);
+            if (result == GAME_ERR_DUPLICATE_ID) {
+                printf("이미 존재하는 ID입니다. 다른 ID를 사용하세요.\n");
                 pauseExecution();
                 continue;
             }
-            // ID 중복 확인
-            int idExists = 0;
-            for (int i = 0; i < numUsers; i++) {
-                if (strcmp(users[i].id, inputId) == 0) {
-                    idExists = 1;
-                    break;
-                }
-            }
-            if (idExists) {
-                printf("이미 존재하는 ID입니다. 다른 ID를 사용하세요.\n");
+            if (result == GAME_ERR_USERS_FULL) {
+                printf("더 이상 가입할 수 없습니다 (사용자 수 한도).\n");
                 pauseExecution();
                 continue;
             }
-
-            strcpy(users[numUsers].id, inputId);
-            strcpy(users[numUsers].password, inputPw);
-            users[numUsers].coins = 0;
-            strcpy(users[numUsers].lastTruthDate, "none"); // 초기값
-            strcpy(users[numUsers].lastDareDate, "none");   // 초기값
-            users[numUsers].dareAttemptsToday = 0;
-            numUsers++;
-            saveUsers(); // 사용자 추가 후 저장
             printf("회원가입 성공! 로그인해주세요.\n");
             pauseExecution();
         } else {
@@ -332,60 +392,10 @@ int handleLogin() {
     return 1; // 로그인 성공
 }
 
-// 사용자 일일 상태 초기화
-void resetDailyStatus() {
-    char currentDate[MAX_DATE_LEN];
-    getCurrentDate(currentDate);
-
-    // 현재 로그인된 사용자의 정보 업데이트
-    // users 배열에서도 해당 사용자 정보를 찾아 업데이트해야 합니다.
-    for (int i = 0; i < numUsers; i++) {
-        if (strcmp(users[i].id, currentUser.id) == 0) {
-            // Truth 초기화
-            if (!isSameDate(currentUser.lastTruthDate, currentDate)) {
-                strcpy(currentUser.lastTruthDate, "none"); // 오늘 Truth 아직 안 함
-                strcpy(users[i].lastTruthDate, "none");
-            }
-            // Dare 초기화
-            if (!isSameDate(currentUser.lastDareDate, currentDate)) {
-                currentUser.dareAttemptsToday = 0;
-                strcpy(currentUser.lastDareDate, currentDate); // 오늘 Dare 시작 날짜로 업데이트
-                users[i].dareAttemptsToday = 0;
-                strcpy(users[i].lastDareDate, currentDate);
-            }
-            // 전역 currentUser 정보도 업데이트했으니, users 배열의 해당 사용자 정보도 업데이트
-            // (함수 호출 후 saveUsers()를 통해 파일에 저장)
-            break;
-        }
-    }
-}
-
-// 현재 로그인된 사용자 정보 업데이트 (users 배열과 동기화)
-void updateCurrentUserInUsersArray() {
-    for (int i = 0; i < numUsers; i++) {
-        if (strcmp(users[i].id, currentUser.id) == 0) {
-            users[i] = currentUser;
-            break;
-        }
-    }
-}
-
-
-
 // --- 메인 메뉴 및 선택 함수 ---
 
 void displayMainMenu() {
-    printf("=======================\n");
-    printf("     Truth or Dare     \n");
-    printf("=======================\n");
-    printf("1. Truth (오늘의 질문)\n");
-    printf("2. Dare (오늘의 도전)\n");
-    printf("3. 기록 보기\n");
-    printf("4. 코인 기록\n");
-    printf("0. 종료\n");
-    printf("-----------------------\n");
-    printf("현재 코인: %d\n", currentUser.coins); // 우측 상단 코인 표시
-    printf("선택: ");
+    printMainMenu(stdout, &currentSession);
 }
 
 int getMenuChoice() {
@@ -403,81 +413,28 @@ int getMenuChoice() {
 
 // --- Truth 기능 함수 ---
 
-// 랜덤 Truth 질문 가져오기
-TruthQuestion* getRandomTruthQuestion() {
-    char currentDate[MAX_DATE_LEN];
-    getCurrentDate(currentDate);
-
-    if (isSameDate(currentUser.lastTruthDate, currentDate)) {
-        printf("오늘은 이미 Truth 질문에 답하셨습니다. 내일 다시 시도해주세요!\n");
-        return NULL;
-    }
-
-    // 모든 질문을 'used = 0'으로 초기화
-    for (int i = 0; i < numTruthQuestions; i++) {
-        truthQuestions[i].used = 0;
-    }
-
-    int availableQuestionsCount = 0;
-    for (int i = 0; i < numTruthQuestions; i++) {
-        // 이미 사용된 질문 (여기서는 Truth 질문이 매일 리셋되므로 이 부분은 세션 내 중복 방지용)
-        if (truthQuestions[i].used == 0) {
-            availableQuestionsCount++;
-        }
-    }
-
-    if (availableQuestionsCount == 0) {
-        printf("더 이상 보여줄 Truth 질문이 없습니다.\n");
-        return NULL;
-    }
-
-    int randomIndex;
-    TruthQuestion* selectedQuestion = NULL;
-    do {
-        randomIndex = rand() % numTruthQuestions;
-        if (truthQuestions[randomIndex].used == 0) {
-            selectedQuestion = &truthQuestions[randomIndex];
-            selectedQuestion->used = 1; // 사용됨으로 표시
-            break;
-        }
-    } while (1);
-
-    return selectedQuestion;
-}
-
 // Truth 질문 및 답변 처리
 void handleTruth() {
     clearScreen();
-    TruthQuestion* currentQuestion = getRandomTruthQuestion();
+    if (hasAnsweredTruthToday(&currentSession)) {
+        printf("오늘은 이미 Truth 질문에 답하셨습니다. 내일 다시 시도해주세요!\n");
+        pauseExecution();
+        return;
+    }
+    const TruthQuestion* currentQuestion = getTruthQuestion(&currentSession);
     if (currentQuestion == NULL) {
+        printf("더 이상 보여줄 Truth 질문이 없습니다.\n");
         pauseExecution();
         return;
     }
 
-    printf("=======================\n");
-    printf("       오늘의 Truth      \n");
-    printf("=======================\n");
-    printf("질문: %s\n", currentQuestion->question);
-    printf("답변 (최대 %d자): ", MAX_ANSWER_LEN - 1);
+    printTruthQuestion(stdout, currentQuestion);
 
     char answer[MAX_ANSWER_LEN];
     fgets(answer, sizeof(answer), stdin);
     removeNewline(answer);
 
-    // 기록 저장
-    strcpy(userRecords[numRecords].userId, currentUser.id);
-    getCurrentDate(userRecords[numRecords].date);
-    userRecords[numRecords].type = 0; // Truth
-    userRecords[numRecords].contentId = currentQuestion->id;
-    strcpy(userRecords[numRecords].response, answer);
-    userRecords[numRecords].coinsEarned = 0;
-    numRecords++;
-    saveUserRecords(); // 기록 파일에 즉시 저장
-
-    // 사용자의 마지막 Truth 날짜 업데이트
-    getCurrentDate(currentUser.lastTruthDate);
-    updateCurrentUserInUsersArray(); // users 배열에도 업데이트
-    saveUsers(); // 사용자 정보 저장
+    answerTruth(&currentSession, currentQuestion->id, answer);
 
     printf("\n답변이 저장되었습니다. 언제든지 '기록 보기'에서 확인할 수 있습니다.\n");
     printf("추가 버튼을 누르면 첫 화면으로 돌아갑니다.\n"); // '추가' 버튼은 그냥 엔터로 대체
@@ -490,71 +447,28 @@ void handleTruth() {
 
 // --- Dare 기능 함수 ---
 
-// 랜덤 Dare 도전 가져오기
-DareChallenge* getRandomDareChallenge(const char* category) {
-    DareChallenge* selectedDare = NULL; // 선택된 Dare의 포인터
-    int availableIndices[MAX_DARES]; // 해당 카테고리에 맞는 도전들의 인덱스를 저장
-    int availableCount = 0;
-
-    // 해당 카테고리에 맞는 도전들의 인덱스를 수집
-    for (int i = 0; i < numDareChallenges; i++) {
-        if (strcmp(dareChallenges[i].category, category) == 0) {
-            availableIndices[availableCount++] = i;
-        }
-    }
-
-    if (availableCount == 0) {
-        printf("선택하신 카테고리에 도전 과제가 없습니다.\n");
-        return NULL;
-    }
-
-    // 랜덤으로 하나 선택
-    int randomIndexInAvailable = rand() % availableCount;
-    int actualIndex = availableIndices[randomIndexInAvailable]; // 실제 dareChallenges 배열에서의 인덱스
-
-    selectedDare = &dareChallenges[actualIndex]; // 전역 배열의 주소를 반환
-
-    return selectedDare;
-}
-
 // Dare 도전 처리
 void handleDare() {
-    char currentDate[MAX_DATE_LEN];
-    getCurrentDate(currentDate);
-
     // Dare 시도 횟수 초기화 및 업데이트 (날짜가 바뀌면)
-    if (!isSameDate(currentUser.lastDareDate, currentDate)) {
-        currentUser.dareAttemptsToday = 0;
-        strcpy(currentUser.lastDareDate, currentDate);
-        updateCurrentUserInUsersArray();
-        saveUsers();
-    }
+    int attemptsLeft = dareAttemptsLeft(&currentSession);
 
-    if (currentUser.dareAttemptsToday >= MAX_DARE_ATTEMPTS_PER_DAY) {
+    if (attemptsLeft == 0) {
         clearScreen();
-        printf("=======================\n");
-        printf("     Dare 도전 완료!     \n");
-        printf("=======================\n");
-        printf("오늘은 더 이상 Dare 도전을 할 수 없습니다.\n");
-        printf("5회 도전을 모두 완료하셨습니다. 정말 대단해요!\n");
+        printDareLimitReached(stdout);
         pauseExecution();
         return;
     }
 
     clearScreen();
-    printf("=======================\n");
-    printf("     Dare 카테고리     \n");
-    printf("=======================\n");
-    printf("1. 신체\n");
-    printf("2. 학습\n");
-    printf("3. 정서\n");
-    printf("0. 뒤로가기\n");
-    printf("-----------------------\n");
-    printf("오늘 남은 도전 횟수: %d회\n", MAX_DARE_ATTEMPTS_PER_DAY - currentUser.dareAttemptsToday);
-    printf("선택: ");
+    DareMenu menu = { NULL, 0 };
+    printDareCategoryMenu(stdout, game, &menu, attemptsLeft);
+    int categoryId = 0;
 
     int categoryChoice;
-    if (scanf("%d", &categoryChoice) != 1) {
+    int scanned = scanf("%d", &categoryChoice);
+    if (scanned == 1) categoryId = dareMenuCategory(&menu, categoryChoice);
+    freeDareMenu(&menu);
+    if (scanned != 1) {
         printf("잘못된 입력입니다. 숫자를 입력해주세요.\n");
         while (getchar() != '\n');
         pauseExecution();
@@ -564,32 +478,21 @@ void handleDare() {
 
     if (categoryChoice == 0) return; // 뒤로가기
 
-    char selectedCategory[MAX_CATEGORY_LEN];
-    switch (categoryChoice) {
-        case 1: strcpy(selectedCategory, "신체"); break;
-        case 2: strcpy(selectedCategory, "학습"); break;
-        case 3: strcpy(selectedCategory, "정서"); break;
-        default:
-            printf("유효하지 않은 카테고리입니다.\n");
-            pauseExecution();
-            return;
+    if (categoryId == 0) {
+        printf("유효하지 않은 카테고리입니다.\n");
+        pauseExecution();
+        return;
     }
 
-    DareChallenge* currentDare = getRandomDareChallenge(selectedCategory);
+    const DareChallenge* currentDare = getRandomDareChallenge(game, categoryId);
     if (currentDare == NULL) {
+        printf("선택하신 카테고리에 도전 과제가 없습니다.\n");
         pauseExecution();
         return;
     }
 
     clearScreen();
-    printf("=======================\n");
-    printf("       오늘의 Dare       \n");
-    printf("=======================\n");
-    printf("카테고리: %s\n", currentDare->category);
-    printf("도전: %s\n", currentDare->challenge);
-    printf("\n1. 도전 완료 (Complete)\n");
-    printf("2. 도전 실패 (Fail)\n");
-    printf("선택: ");
+    printDareChallenge(stdout, currentDare);
 
     int dareResultChoice;
     if (scanf("%d", &dareResultChoice) != 1) {
@@ -600,47 +503,16 @@ void handleDare() {
     }
     while (getchar() != '\n');
 
-    currentUser.dareAttemptsToday++; // 시도 횟수 증가
-
-    int coinsEarned = 0;
-    char responseResult[MAX_ANSWER_LEN];
+    attemptDare(&currentSession, currentDare->id, dareResultChoice, NULL);
+    printDareResult(stdout, dareResultChoice);
 
-    if (dareResultChoice == 1) { // Complete
-        currentUser.coins += 10; // 예시: 10코인 지급
-        coinsEarned = 10;
-        strcpy(responseResult, "Complete");
-        printf("\n축하합니다! 코인 10개를 획득했습니다!\n");
-    } else if (dareResultChoice == 2) { // Fail
-        strcpy(responseResult, "Fail");
-        printf("\n아쉽지만 다음 기회에! 코인은 변동 없습니다.\n");
-    } else {
-        printf("잘못된 선택입니다. 도전 결과가 기록되지 않습니다.\n");
-        strcpy(responseResult, "Invalid Choice");
-    }
-
-    // 기록 저장
-    strcpy(userRecords[numRecords].userId, currentUser.id);
-    getCurrentDate(userRecords[numRecords].date);
-    userRecords[numRecords].type = 1; // Dare
-    userRecords[numRecords].contentId = currentDare->id;
-    strcpy(userRecords[numRecords].response, responseResult);
-    userRecords[numRecords].coinsEarned = coinsEarned;
-    numRecords++;
-    saveUserRecords(); // 기록 파일에 즉시 저장
-
-    updateCurrentUserInUsersArray(); // users 배열에도 업데이트
-    saveUsers(); // 사용자 정보 저장
-
-    if (currentUser.dareAttemptsToday < MAX_DARE_ATTEMPTS_PER_DAY) {
+    if (sessionUser(&currentSession)->dareAttemptsToday < MAX_DARE_ATTEMPTS_PER_DAY) {
         printf("\n다음 도전을 선택할 수 있습니다.\n");
         pauseExecution();
         handleDare(); // 다음 도전을 위해 재귀 호출 또는 루프
     } else {
         clearScreen();
-        printf("=======================\n");
-        printf("     Dare 도전 완료!     \n");
-        printf("=======================\n");
-        printf("오늘의 Dare 도전을 모두 완료하셨습니다. 정말 대단해요!\n");
+        printDareAllDone(stdout);
         pauseExecution();
     }
 }
@@ -653,151 +525,778 @@ void handleDare() {
 
 void viewRecords() {
     clearScreen();
-    printf("=======================\n");
-    printf("       나의 기록        \n");
-    printf("=======================\n");
+    printRecords(stdout, &currentSession);
+    pauseExecution();
+}
 
-    if (numRecords == 0) {
-        printf("아직 기록이 없습니다.\n");
-        pauseExecution();
-        return;
+
+
+
+// --- 답변 검색 함수 ---
+
+void searchAnswers() {
+    clearScreen();
+    printSearchPrompt(stdout);
+    char query[MAX_ANSWER_LEN];
+    if (fgets(query, sizeof(query), stdin) == NULL) return;
+    removeNewline(query);
+    printSearchResults(stdout, &currentSession, query);
+    printf("\n계속하려면 Enter 키를 누르세요...");
+    getchar(); // 검색어 입력 줄은 fgets가 이미 소비함
+}
+
+
+
+
+// --- 코인 기록 (랭킹) 함수 ---
+
+void viewCoinRanking() {
+    clearScreen();
+    printCoinRanking(stdout, &currentSession);
+    pauseExecution();
+}
+
+
+
+
+
+// --- 서버 모드 ---
+// 한 프로세스가 여러 접속을 동시에 처리한다 (epoll).
+// 접속마다 대화형 화면 흐름(로그인 → 메뉴 → Truth/Dare/기록/랭킹/검색)을 상태 기계로 진행하며,
+// 사용자 표·기록·리더보드는 모든 세션이 공유한다 (잠금은 게임 엔진 안에서 처리).
+// 작업 스레드마다 자기 epoll과 세션 목록을 가지며, 새 접속은 먼저 깨어난 스레드가 받는다.
+
+#ifdef __linux__
+
+typedef enum {
+    SESSION_AUTH_MENU,     // 로그인/회원가입/종료 선택 대기
+    SESSION_AUTH_ID,       // ID 입력 대기
+    SESSION_AUTH_PW,       // 비밀번호 입력 대기
+    SESSION_MAIN_MENU,     // 메인 메뉴 선택 대기
+    SESSION_TRUTH_ANSWER,  // Truth 답변 대기
+    SESSION_DARE_CATEGORY, // Dare 카테고리 선택 대기
+    SESSION_DARE_RESULT,   // Dare 결과 (완료/실패) 대기
+    SESSION_SEARCH_QUERY   // 답변 검색어 대기
+} SessionState;
+
+typedef struct Session {
+    int fd;
+    SessionState state;
+    int authChoice;             // 1: 로그인, 2: 회원가입
+    char pendingId[MAX_ID_LEN]; // 입력받은 ID (비밀번호 입력 대기 중)
+    GameSession game;           // 엔진 세션 (userIdx -1: 로그인 전)
+    int pendingContentId;       // 응답을 기다리는 Truth 질문 / Dare 도전 ID
+    DareMenu dareMenu;          // 마지막으로 보여 준 Dare 카테고리 메뉴
+    int closing;                // 남은 출력을 보낸 뒤 연결 종료
+    char inBuf[SESSION_INPUT_MAX];
+    int inLen;
+    char* outBuf;               // 아직 보내지 못한 출력
+    size_t outLen;
+    size_t outSent;
+    size_t outCap;
+    int wantWrite;              // EPOLLOUT 등록 여부
+    struct ServerWorker* worker; // 이 접속을 맡은 작업 스레드
+    struct Session* prev;       // 작업 스레드의 세션 목록 (종료 시 정리용)
+    struct Session* next;
+} Session;
+
+// 서버 작업 스레드 하나의 상태 (다른 스레드와 공유하지 않음)
+typedef struct ServerWorker {
+    GameContext* ctx;
+    int listenFd;
+    int epollFd;
+    Session* sessions;
+    int sessionCount;
+    pthread_t thread;
+} ServerWorker;
+
+static volatile sig_atomic_t serverStopRequested = 0;
+static int serverStopFd = -1; // 종료 시 모든 작업 스레드의 epoll_wait를 깨우는 eventfd
+static char serverStopMarker; // epoll 이벤트에서 종료 알림을 구분하는 주소
+
+static void serverSignalHandler(int sig) {
+    (void)sig;
+    serverStopRequested = 1;
+}
+
+static int setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// 세션 출력 버퍼 끝에 추가
+static int sessionAppend(Session* s, const char* data, size_t len) {
+    if (s->outSent > 0 && s->outSent == s->outLen) { // 다 보낸 버퍼는 처음부터 재사용
+        s->outLen = s->outSent = 0;
     }
+    if (s->outLen + len > s->outCap) {
+        size_t newCap = s->outCap ? s->outCap : 1024;
+        while (newCap < s->outLen + len) newCap *= 2;
+        char* grown = realloc(s->outBuf, newCap);
+        if (grown == NULL) return 0;
+        s->outBuf = grown;
+        s->outCap = newCap;
+    }
+    memcpy(s->outBuf + s->outLen, data, len);
+    s->outLen += len;
+    return 1;
+}
 
-    // 사용자 기록 중 현재 사용자의 기록만 필터링 및 정렬 (간단한 버블 정렬 예시)
-    UserRecord userSpecificRecords[MAX_RECORDS];
-    int userRecordCount = 0;
-    for (int i = 0; i < numRecords; i++) {
-        if (strcmp(userRecords[i].userId, currentUser.id) == 0) {
-            userSpecificRecords[userRecordCount++] = userRecords[i];
+static void sessionWatch(Session* s, int wantWrite) {
+    if (s->wantWrite == wantWrite) return;
+    struct epoll_event ev;
+    ev.events = wantWrite ? EPOLLOUT : EPOLLIN; // 출력이 밀려 있으면 입력을 잠시 받지 않음
+    ev.data.ptr = s;
+    epoll_ctl(s->worker->epollFd, EPOLL_CTL_MOD, s->fd, &ev);
+    s->wantWrite = wantWrite;
+}
+
+static void sessionClose(Session* s) {
+    ServerWorker* w = s->worker;
+    epoll_ctl(w->epollFd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    if (s->prev) s->prev->next = s->next; else w->sessions = s->next;
+    if (s->next) s->next->prev = s->prev;
+    w->sessionCount--;
+    freeDareMenu(&s->dareMenu);
+    free(s->outBuf);
+    free(s);
+}
+
+// 밀린 출력 전송 (0: 연결을 닫아야 함)
+static int sessionFlush(Session* s) {
+    while (s->outSent < s->outLen) {
+        ssize_t n = send(s->fd, s->outBuf + s->outSent, s->outLen - s->outSent, MSG_NOSIGNAL);
+        if (n > 0) {
+            s->outSent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            sessionWatch(s, 1);
+            return 1;
+        } else {
+            return 0;
         }
     }
+    s->outLen = s->outSent = 0;
+    sessionWatch(s, 0);
+    return !s->closing;
+}
 
-    if (userRecordCount == 0) {
-        printf("아직 기록이 없습니다.\n");
-        pauseExecution();
+// 메뉴 입력 한 줄을 숫자로 해석 (scanf("%d")와 같이 앞 공백 허용, 실패 시 0 반환)
+static int parseMenuNumber(const char* line, int* value) {
+    char* end;
+    long v = strtol(line, &end, 10);
+    if (end == line) return 0;
+    *value = (int)v;
+    return 1;
+}
+
+// 한 줄 입력 처리: 화면 출력은 out에 쓰고 다음 상태로 넘어간다
+static void sessionHandleLine(Session* s, char* line, FILE* out) {
+    int choice;
+    // 운영용 명령: 어느 화면에서든 현재 계측 결과를 이 접속으로 출력 (화면 상태는 그대로)
+    if (strcmp(line, "/stats") == 0) {
+        dumpGameStats(s->game.ctx, out);
         return;
     }
+    switch (s->state) {
+        case SESSION_AUTH_MENU:
+            if (!parseMenuNumber(line, &choice)) {
+                fprintf(out, "잘못된 입력입니다. 다시 시도하세요.\n");
+                printAuthMenu(out);
+            } else if (choice == 0) {
+                fprintf(out, "프로그램을 종료합니다. 안녕히 계세요!\n");
+                s->closing = 1;
+            } else if (choice == 1 || choice == 2) {
+                s->authChoice = choice;
+                fprintf(out, "ID를 입력하세요: ");
+                s->state = SESSION_AUTH_ID;
+            } else {
+                fprintf(out, "잘못된 선택입니다.\n");
+                printAuthMenu(out);
+            }
+            break;
+
+        case SESSION_AUTH_ID:
+            copyString(s->pendingId, line, sizeof(s->pendingId));
+            fprintf(out, "비밀번호를 입력하세요: ");
+            s->state = SESSION_AUTH_PW;
+            break;
 
-    // 날짜순 정렬 (버블 정렬)
-    for (int i = 0; i < userRecordCount - 1; i++) {
-        for (int j = 0; j < userRecordCount - 1 - i; j++) {
-            if (strcmp(userSpecificRecords[j].date, userSpecificRecords[j+1].date) > 0) {
-                UserRecord temp = userSpecificRecords[j];
-                userSpecificRecords[j] = userSpecificRecords[j+1];
-                userSpecificRecords[j+1] = temp;
+        case SESSION_AUTH_PW: {
+            char password[MAX_PW_LEN];
+            copyString(password, line, sizeof(password));
+            s->state = SESSION_AUTH_MENU;
+            if (s->authChoice == 1) { // 로그인
+                if (loginSession(s->game.ctx, &s->game, s->pendingId, password) != GAME_OK) {
+                    fprintf(out, "ID 또는 비밀번호가 일치하지 않습니다. 다시 시도하세요.\n");
+                    printAuthMenu(out);
+                    break;
+                }
+                fprintf(out, "로그인 성공!\n");
+                s->state = SESSION_MAIN_MENU;
+                printMainMenu(out, &s->game);
+            } else { // 회원가입
+                int result = signUpUser(s->game.ctx, s->pendingId, password);
+                if (result == GAME_ERR_DUPLICATE_ID) {
+                    fprintf(out, "이미 존재하는 ID입니다. 다른 ID를 사용하세요.\n");
+                } else if (result == GAME_ERR_USERS_FULL) {
+                    fprintf(out, "더 이상 가입할 수 없습니다 (사용자 수 한도).\n");
+                } else {
+                    fprintf(out, "회원가입 성공! 로그인해주세요.\n");
+                }
+                printAuthMenu(out);
             }
+            break;
         }
-    }
 
-    for (int i = 0; i < userRecordCount; i++) {
-        printf("\n날짜: %s\n", userSpecificRecords[i].date);
-        if (userSpecificRecords[i].type == 0) { // Truth 기록
-            printf("종류: Truth\n");
-            // 질문 내용 찾기
-            char qText[MAX_QUESTION_LEN] = "알 수 없는 질문";
-            for (int j = 0; j < numTruthQuestions; j++) {
-                if (truthQuestions[j].id == userSpecificRecords[i].contentId) {
-                    strcpy(qText, truthQuestions[j].question);
+        case SESSION_MAIN_MENU:
+            if (!parseMenuNumber(line, &choice)) {
+                fprintf(out, "잘못된 입력입니다. 숫자를 입력해주세요.\n");
+                fprintf(out, "잘못된 선택입니다. 다시 시도해주세요.\n");
+            } else if (choice == 1) { // Truth
+                if (hasAnsweredTruthToday(&s->game)) {
+                    fprintf(out, "오늘은 이미 Truth 질문에 답하셨습니다. 내일 다시 시도해주세요!\n");
                     break;
                 }
-            }
-            printf("질문: %s\n", qText);
-            printf("답변: %s\n", userSpecificRecords[i].response);
-        } else { // Dare 기록
-            printf("종류: Dare\n");
-            // 도전 내용 찾기
-            char dText[MAX_QUESTION_LEN] = "알 수 없는 도전";
-            char dCategory[MAX_CATEGORY_LEN] = "N/A";
-            for (int j = 0; j < numDareChallenges; j++) {
-                if (dareChallenges[j].id == userSpecificRecords[i].contentId) {
-                    strcpy(dText, dareChallenges[j].challenge);
-                    strcpy(dCategory, dareChallenges[j].category);
+                const TruthQuestion* q = getTruthQuestion(&s->game);
+                if (q == NULL) {
+                    fprintf(out, "더 이상 보여줄 Truth 질문이 없습니다.\n");
+                    break;
+                }
+                printTruthQuestion(out, q);
+                s->pendingContentId = q->id;
+                s->state = SESSION_TRUTH_ANSWER;
+                return;
+            } else if (choice == 2) { // Dare
+                int attemptsLeft = dareAttemptsLeft(&s->game);
+                if (attemptsLeft == 0) {
+                    printDareLimitReached(out);
                     break;
                 }
+                printDareCategoryMenu(out, s->game.ctx, &s->dareMenu, attemptsLeft);
+                s->state = SESSION_DARE_CATEGORY;
+                return;
+            } else if (choice == 3) { // 기록 보기
+                printRecords(out, &s->game);
+            } else if (choice == 4) { // 코인 기록
+                printCoinRanking(out, &s->game);
+            } else if (choice == 5) { // 답변 검색
+                printSearchPrompt(out);
+                s->state = SESSION_SEARCH_QUERY;
+                return;
+            } else if (choice == 0) { // 종료
+                fprintf(out, "프로그램을 종료합니다. 안녕히 계세요!\n");
+                s->closing = 1;
+                return;
+            } else {
+                fprintf(out, "잘못된 선택입니다. 다시 시도해주세요.\n");
+            }
+            break;
+
+        case SESSION_TRUTH_ANSWER: {
+            char answer[MAX_ANSWER_LEN];
+            copyString(answer, line, sizeof(answer));
+            // 같은 사용자가 다른 접속에서 먼저 답했으면 엔진이 거절함
+            if (answerTruth(&s->game, s->pendingContentId, answer) == GAME_ERR_ALREADY_ANSWERED) {
+                fprintf(out, "오늘은 이미 Truth 질문에 답하셨습니다. 내일 다시 시도해주세요!\n");
+            } else {
+                fprintf(out, "\n답변이 저장되었습니다. 언제든지 '기록 보기'에서 확인할 수 있습니다.\n");
             }
-            printf("카테고리: %s\n", dCategory);
-            printf("도전: %s\n", dText);
-            printf("결과: %s (획득 코인: %d)\n", userSpecificRecords[i].response, userSpecificRecords[i].coinsEarned);
+            break;
         }
-        printf("-----------------------\n");
-    }
-    pauseExecution();
-}
 
+        case SESSION_DARE_CATEGORY: {
+            if (!parseMenuNumber(line, &choice)) {
+                fprintf(out, "잘못된 입력입니다. 숫자를 입력해주세요.\n");
+                break;
+            }
+            if (choice == 0) break; // 뒤로가기
+            int categoryId = dareMenuCategory(&s->dareMenu, choice);
+            if (categoryId == 0) {
+                fprintf(out, "유효하지 않은 카테고리입니다.\n");
+                break;
+            }
+            const DareChallenge* dare = getRandomDareChallenge(s->game.ctx, categoryId);
+            if (dare == NULL) {
+                fprintf(out, "선택하신 카테고리에 도전 과제가 없습니다.\n");
+                break;
+            }
+            printDareChallenge(out, dare);
+            s->pendingContentId = dare->id;
+            s->state = SESSION_DARE_RESULT;
+            return;
+        }
 
+        case SESSION_DARE_RESULT:
+            if (!parseMenuNumber(line, &choice)) {
+                fprintf(out, "잘못된 입력입니다. 숫자를 입력해주세요.\n");
+                break;
+            }
+            // 같은 사용자의 다른 접속이 그 사이 남은 횟수를 다 썼으면 엔진이 거절함
+            if (attemptDare(&s->game, s->pendingContentId, choice, NULL) == GAME_ERR_NO_ATTEMPTS) {
+                printDareLimitReached(out);
+                break;
+            }
+            printDareResult(out, choice);
+            if (sessionUser(&s->game)->dareAttemptsToday < MAX_DARE_ATTEMPTS_PER_DAY) {
+                fprintf(out, "\n다음 도전을 선택할 수 있습니다.\n");
+                printDareCategoryMenu(out, s->game.ctx, &s->dareMenu, dareAttemptsLeft(&s->game));
+                s->state = SESSION_DARE_CATEGORY;
+                return;
+            }
+            printDareAllDone(out);
+            break;
 
+        case SESSION_SEARCH_QUERY:
+            printSearchResults(out, &s->game, line);
+            break;
+    }
 
-// --- 코인 기록 (랭킹) 함수 ---
+    // 로그인 후 흐름은 모두 메인 메뉴로 돌아감
+    if (s->game.userIdx >= 0 && !s->closing) {
+        s->state = SESSION_MAIN_MENU;
+        printMainMenu(out, &s->game);
+    }
+}
 
-void viewCoinRanking() {
-    clearScreen();
-    printf("=======================\n");
-    printf("       코인 랭킹        \n");
-    printf("=======================\n");
+// 완성된 줄 하나를 처리하고 그 출력을 세션 버퍼에 넣는다
+static int sessionDispatchLine(Session* s, char* line) {
+    size_t len = strlen(line);
+    if (len > 0 && line[len - 1] == '\r') line[len - 1] = '\0'; // 텔넷 등의 CRLF
+
+    char* text = NULL;
+    size_t textLen = 0;
+    FILE* out = open_memstream(&text, &textLen);
+    if (out == NULL) return 0;
+    sessionHandleLine(s, line, out);
+    fclose(out);
+    int ok = sessionAppend(s, text, textLen);
+    free(text);
+    return ok;
+}
 
-    if (numUsers == 0) {
-        printf("등록된 사용자가 없습니다.\n");
-        pauseExecution();
-        return;
+// 읽을 수 있는 데이터 처리 (0: 연결을 닫아야 함)
+static int sessionRead(Session* s) {
+    char buf[4096];
+    ssize_t n = recv(s->fd, buf, sizeof(buf), 0);
+    if (n == 0) return 0; // 상대가 연결을 닫음
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    for (ssize_t i = 0; i < n && !s->closing; i++) {
+        if (buf[i] == '\n' || s->inLen == SESSION_INPUT_MAX - 1) {
+            // 줄이 버퍼보다 길면 fgets처럼 잘라서 처리
+            s->inBuf[s->inLen] = '\0';
+            s->inLen = 0;
+            if (!sessionDispatchLine(s, s->inBuf)) return 0;
+            if (buf[i] == '\n') continue;
+        }
+        s->inBuf[s->inLen++] = buf[i];
     }
+    return sessionFlush(s);
+}
 
-    // 사용자 배열을 코인 기준으로 내림차순 정렬 (버블 정렬)
-    User sortedUsers[MAX_USERS];
-    memcpy(sortedUsers, users, sizeof(User) * numUsers); // 원본 배열 복사
+static void serverAccept(ServerWorker* w) {
+    for (;;) {
+        int fd = accept(w->listenFd, NULL, NULL); // 다른 스레드가 먼저 받았으면 EAGAIN
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("accept"); // EMFILE 등: 다음 이벤트에서 다시 시도
+            }
+            return;
+        }
+        Session* s = calloc(1, sizeof(Session));
+        if (s == NULL || setNonBlocking(fd) != 0) {
+            free(s);
+            close(fd);
+            continue;
+        }
+        s->fd = fd;
+        s->worker = w;
+        s->game.ctx = w->ctx;
+        s->game.userIdx = -1;
+        s->state = SESSION_AUTH_MENU;
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = s;
+        if (epoll_ctl(w->epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(s);
+            continue;
+        }
+        s->next = w->sessions;
+        if (w->sessions) w->sessions->prev = s;
+        w->sessions = s;
+        w->sessionCount++;
+
+        // 첫 화면 전송
+        char* text = NULL;
+        size_t textLen = 0;
+        FILE* out = open_memstream(&text, &textLen);
+        if (out != NULL) {
+            printAuthMenu(out);
+            fclose(out);
+            sessionAppend(s, text, textLen);
+            free(text);
+        }
+        if (!sessionFlush(s)) sessionClose(s);
+    }
+}
 
-    for (int i = 0; i < numUsers - 1; i++) {
-        for (int j = 0; j < numUsers - 1 - i; j++) {
-            if (sortedUsers[j].coins < sortedUsers[j+1].coins) {
-                User temp = sortedUsers[j];
-                sortedUsers[j] = sortedUsers[j+1];
-                sortedUsers[j+1] = temp;
+// 대기 소켓 열기: '/'가 들어 있으면 유닉스 소켓 경로, 아니면 127.0.0.1의 TCP 포트
+static int serverListen(const char* address) {
+    int fd;
+    if (strchr(address, '/') != NULL) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(address) >= sizeof(addr.sun_path)) {
+            printf("소켓 경로가 너무 깁니다: %s\n", address);
+            return -1;
+        }
+        strcpy(addr.sun_path, address);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        unlink(address); // 이전 실행이 남긴 소켓 파일
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            perror("bind");
+            close(fd);
+            return -1;
+        }
+    } else {
+        int port = atoi(address);
+        if (port <= 0 || port > 65535) {
+            printf("잘못된 포트 번호입니다: %s\n", address);
+            return -1;
+        }
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 로컬 접속만 허용
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            perror("bind");
+            close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, SOMAXCONN) != 0 || setNonBlocking(fd) != 0) {
+        perror("listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 작업 스레드 이벤트 루프 (종료 알림을 받으면 반환)
+static void* serverWorkerMain(void* arg) {
+    ServerWorker* w = arg;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!serverStopRequested) {
+        int n = epoll_wait(w->epollFd, events, SERVER_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            Session* s = events[i].data.ptr;
+            if (s == NULL) {
+                serverAccept(w);
+                continue;
             }
+            if ((void*)s == &serverStopMarker) continue; // 루프 조건에서 종료
+            int keep;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) keep = 0;
+            else if (events[i].events & EPOLLOUT) keep = sessionFlush(s);
+            else keep = sessionRead(s);
+            if (!keep) sessionClose(s);
         }
     }
+    return NULL;
+}
+
+// 작업 스레드의 epoll 준비: 대기 소켓과 종료 알림 등록
+static int serverWorkerInit(ServerWorker* w, GameContext* ctx, int listenFd) {
+    memset(w, 0, sizeof(*w));
+    w->ctx = ctx;
+    w->listenFd = listenFd;
+    w->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (w->epollFd < 0) {
+        perror("epoll_create1");
+        return 0;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE; // 새 접속 하나에 모든 스레드가 깨어나지 않도록
+    ev.data.ptr = NULL; // NULL: 대기 소켓
+    epoll_ctl(w->epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.events = EPOLLIN; // 읽지 않으므로 한 번 알리면 모든 스레드에서 계속 준비 상태
+    ev.data.ptr = &serverStopMarker;
+    epoll_ctl(w->epollFd, EPOLL_CTL_ADD, serverStopFd, &ev);
+    return 1;
+}
 
-    printf("--- TOP 3 ---\n");
-    for (int i = 0; i < (numUsers > 3 ? 3 : numUsers); i++) {
-        printf("%d위: %s - %d 코인\n", i + 1, sortedUsers[i].id, sortedUsers[i].coins);
+// 서버 실행 (SIGINT/SIGTERM을 받으면 반환)
+// threads개의 작업 스레드가 한 게임 컨텍스트를 함께 사용한다 (첫 번째는 호출한 스레드).
+int runServer(GameContext* ctx, const char* address, int threads) {
+    if (threads < 1) threads = 1;
+    if (threads > SERVER_MAX_THREADS) threads = SERVER_MAX_THREADS;
+    int listenFd = serverListen(address);
+    if (listenFd < 0) return 0;
+    serverStopFd = eventfd(0, EFD_CLOEXEC);
+    if (serverStopFd < 0) {
+        perror("eventfd");
+        close(listenFd);
+        return 0;
     }
 
-    printf("\n--- 나의 순위 ---\n");
-    int myRank = -1;
-    for (int i = 0; i < numUsers; i++) {
-        if (strcmp(sortedUsers[i].id, currentUser.id) == 0) {
-            myRank = i + 1;
+    ServerWorker workers[SERVER_MAX_THREADS];
+    int numWorkers = 0;
+    while (numWorkers < threads && serverWorkerInit(&workers[numWorkers], ctx, listenFd)) numWorkers++;
+    int ok = numWorkers == threads;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = serverSignalHandler; // SA_RESTART 없음: epoll_wait가 EINTR로 깨어남
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // 추가 작업 스레드는 신호를 막아 두어 신호는 항상 첫 번째 스레드가 받음
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+    int started = ok ? 1 : 0;
+    while (ok && started < numWorkers) {
+        if (pthread_create(&workers[started].thread, NULL, serverWorkerMain, &workers[started]) != 0) {
+            printf("서버 작업 스레드를 시작할 수 없습니다.\n");
             break;
         }
+        started++;
     }
-    printf("%d위: %s - %d 코인\n", myRank, currentUser.id, currentUser.coins);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
 
-    pauseExecution();
+    if (ok) {
+        printf("서버 모드: %s 에서 접속을 기다립니다. (작업 스레드 %d개, 종료: Ctrl+C)\n", address, started);
+        fflush(stdout);
+        serverWorkerMain(&workers[0]);
+    }
+
+    // 나머지 작업 스레드 깨워서 종료
+    serverStopRequested = 1;
+    uint64_t one = 1;
+    if (write(serverStopFd, &one, sizeof(one)) < 0) perror("write");
+    for (int i = 1; i < started; i++) pthread_join(workers[i].thread, NULL);
+
+    int sessionCount = 0;
+    for (int i = 0; i < numWorkers; i++) sessionCount += workers[i].sessionCount;
+    printf("서버를 종료합니다. (접속 중인 세션 %d개)\n", sessionCount);
+    for (int i = 0; i < numWorkers; i++) {
+        while (workers[i].sessions) sessionClose(workers[i].sessions);
+        close(workers[i].epollFd);
+    }
+    close(serverStopFd);
+    serverStopFd = -1;
+    close(listenFd);
+    if (strchr(address, '/') != NULL) unlink(address);
+    return ok;
 }
 
+#else
 
+int runServer(GameContext* ctx, const char* address, int threads) {
+    (void)ctx;
+    (void)address;
+    (void)threads;
+    printf("서버 모드는 이 플랫폼에서 지원되지 않습니다.\n");
+    return 0;
+}
 
+#endif
 
 
 
 // --- Main 함수 ---
 
-int main() {
-    srand(time(NULL)); // 난수 시드 초기화
+#ifdef __linux__
+// SIGUSR1: 계측 스레드에 통계 덤프 요청 (출력은 계측 스레드가 함)
+static void statsSignalHandler(int sig) {
+    (void)sig;
+    if (game != NULL) requestGameStatsDump(game);
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    GameConfig config = { NULL, stdout, DURABILITY_BATCH, 0, 0, NULL, 0, 0, 0 }; // 난수 시드는 현재 시각, 계측 꺼짐, 공유 안 함
+
+    // 0. 실행 옵션
+    //   --compact         : 기록 저널을 압축본에 합치고 종료
+    //   --rebuild-stats   : 모든 사용자 누적 통계를 기록에서 다시 계산해 저장하고 종료
+    //   --durability L    : 저장 내구성 none | batch (기본, 그룹 커밋마다 fsync) | sync (fsync까지 대기)
+    //   --export-snapshot : 텍스트 파일을 읽어 스냅샷(snapshot.bin)을 만들고 종료
+    //   --import-snapshot : 스냅샷 내용으로 텍스트 파일을 다시 쓰고 종료
+    //   --build-catalog   : 질문/도전 텍스트 파일로 콘텐츠 카탈로그(content.cat)를 만들고 종료 (시작 시 매핑해서 사용)
+    //   --server ADDR     : 여러 접속을 받는 서버 모드 (ADDR: TCP 포트 또는 유닉스 소켓 경로)
+    //   --threads N       : 서버 작업 스레드 수 (기본 1), --report의 스캔 스레드 수 (기본 CPU 수)
+    //   --report          : 기록 분석 보고서(날짜별 활동/코인, Dare 완료율, Truth 연속 참여)를 출력하고 종료
+    //   --from DATE       : 보고서 시작 날짜 YYYY-MM-DD (기본: 첫 기록)
+    //   --to DATE         : 보고서 끝 날짜 YYYY-MM-DD (기본: 마지막 기록)
+    //   --data-dir DIR    : 데이터 파일 디렉터리 (기본: 현재 디렉터리)
+    //   --stats           : 동작별 지연/입출력 계측 (SIGUSR1 또는 서버의 /stats 명령으로 출력)
+    //   --stats-file PATH : 계측 결과를 주기적으로 PATH에 덮어씀 (--stats 포함)
+    //   --stats-interval S: 통계 파일 갱신 주기 (초, 기본 10)
+    //   --shared          : 같은 데이터 디렉터리를 쓰는 다른 프로세스와 사용자 표/코인 순위를 공유 (Linux)
+    //   --shared-capacity N: 공유 사용자 표를 처음 만들 때의 최대 사용자 수 (기본 1048576)
+    int compactOnly = 0;
+    int rebuildStatsOnly = 0;
+    const char* serverAddress = NULL;
+    int serverThreads = 0; // 0: 서버는 1개, 보고서는 CPU 수
+    int exportSnapshot = 0;
+    int reportOnly = 0;
+    int reportFrom = DAY_NONE;
+    int reportTo = DAY_NONE;
+    int importSnapshotOnly = 0;
+    int buildCatalogOnly = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compact") == 0) {
+            compactOnly = 1;
+        } else if (strcmp(argv[i], "--rebuild-stats") == 0) {
+            rebuildStatsOnly = 1;
+        } else if (strcmp(argv[i], "--export-snapshot") == 0) {
+            exportSnapshot = 1;
+        } else if (strcmp(argv[i], "--import-snapshot") == 0) {
+            importSnapshotOnly = 1;
+        } else if (strcmp(argv[i], "--build-catalog") == 0) {
+            buildCatalogOnly = 1;
+        } else if (strcmp(argv[i], "--report") == 0) {
+            reportOnly = 1;
+        } else if ((strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) && i + 1 < argc) {
+            int* day = argv[i][2] == 'f' ? &reportFrom : &reportTo;
+            if (!parseGameDay(argv[++i], day)) {
+                printf("잘못된 날짜입니다 (YYYY-MM-DD): %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            serverAddress = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            serverThreads = atoi(argv[++i]);
+            if (serverThreads < 1) {
+                printf("잘못된 스레드 수입니다: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--data-dir") == 0 && i + 1 < argc) {
+            config.dataDir = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            config.stats = 1;
+        } else if (strcmp(argv[i], "--stats-file") == 0 && i + 1 < argc) {
+            config.stats = 1;
+            config.statsFile = argv[++i];
+        } else if (strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc) {
+            config.statsInterval = atoi(argv[++i]);
+            if (config.statsInterval < 1) {
+                printf("잘못된 통계 갱신 주기입니다: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--shared") == 0) {
+            config.sharedUsers = 1;
+        } else if (strcmp(argv[i], "--shared-capacity") == 0 && i + 1 < argc) {
+            config.sharedUsers = 1;
+            config.sharedCapacity = atoi(argv[++i]);
+            if (config.sharedCapacity < 1) {
+                printf("잘못된 사용자 수입니다: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--durability") == 0 && i + 1 < argc) {
+            const char* level = argv[++i];
+            if (strcmp(level, "none") == 0) config.durability = DURABILITY_NONE;
+            else if (strcmp(level, "batch") == 0) config.durability = DURABILITY_BATCH;
+            else if (strcmp(level, "sync") == 0) config.durability = DURABILITY_SYNC;
+            else {
+                printf("알 수 없는 내구성 수준: %s\n", level);
+                return 1;
+            }
+        } else {
+            printf("알 수 없는 옵션: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    game = createGameContext(&config);
+    if (game == NULL) {
+        printf("게임 데이터를 준비할 수 없습니다.\n");
+        return 1;
+    }
 
     // 1. 데이터 로드 (시작 시)
-    loadUsers();
-    loadTruthQuestions();
-    loadDareChallenges();
-    loadUserRecords();
+    if (importSnapshotOnly) {
+        int ok = importSnapshot(game);
+        destroyGameContext(game);
+        return ok ? 0 : 1;
+    }
+    if (buildCatalogOnly) {
+        int ok = buildContentCatalog(game);
+        destroyGameContext(game);
+        return ok ? 0 : 1;
+    }
+    loadGame(game);
+
+    if (compactOnly) {
+        compactUserRecords(game);
+        saveSnapshot(game);
+        destroyGameContext(game);
+        return 0;
+    }
+    if (rebuildStatsOnly) {
+        rebuildUserStats(game);
+        destroyGameContext(game); // 바뀐 사용자 행 저장
+        return 0;
+    }
+    if (exportSnapshot) {
+        int ok = saveSnapshot(game);
+        destroyGameContext(game);
+        return ok ? 0 : 1;
+    }
+    if (reportOnly) {
+        GameReport* report = buildGameReport(game, reportFrom, reportTo, serverThreads);
+        int ok = report != NULL;
+        if (ok) printGameReport(stdout, report);
+        freeGameReport(report);
+        destroyGameContext(game);
+        return ok ? 0 : 1;
+    }
+
+    startGame(game);
+#ifdef __linux__
+    if (config.stats) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = statsSignalHandler;
+        sa.sa_flags = SA_RESTART; // 대화형 입력 대기(fgets)가 끊기지 않도록
+        sigaction(SIGUSR1, &sa, NULL);
+    }
+#endif
+
+    if (serverAddress != NULL) {
+        int ok = runServer(game, serverAddress, serverThreads);
+        destroyGameContext(game); // 남은 변경을 모두 저장
+        return ok ? 0 : 1;
+    }
 
     // 2. 로그인 및 사용자 초기화
     if (!handleLogin()) {
         printf("로그인 과정이 취소되었습니다. 프로그램을 종료합니다.\n");
+        destroyGameContext(game);
         return 0; // 로그인 실패 시 종료
     }
 
-    // 3. 일일 상태 초기화 (날짜 변경 시)
-    resetDailyStatus(); // 로그인 성공 후 현재 사용자 데이터 기반으로 초기화
-
     int choice;
     do {
         clearScreen();
@@ -817,6 +1316,9 @@ int main() {
             case 4: // 코인 기록
                 viewCoinRanking();
                 break;
+            case 5: // 답변 검색
+                searchAnswers();
+                break;
             case 0: // 종료
                 printf("프로그램을 종료합니다. 안녕히 계세요!\n");
                 break;
@@ -827,9 +1329,8 @@ int main() {
         }
     } while (choice != 0);
 
-    // 4. 데이터 저장 (종료 시)
-    saveUsers();
-    saveUserRecords();
+    // 4. 데이터 저장 (종료 시) - 큐에 남은 변경을 모두 커밋한 뒤 해제
+    destroyGameContext(game);
 
     return 0;
 }